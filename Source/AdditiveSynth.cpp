@@ -0,0 +1,235 @@
+#include "AdditiveSynth.h"
+#include <cmath>
+
+namespace
+{
+    // Blackman-Harris 4-term, zero-phase (centred on the frame): sidelobes at -92 dB,
+    // so keeping only the main lobe loses nothing audible
+    constexpr double bh0 = 0.35875, bh1 = 0.48829, bh2 = 0.14128, bh3 = 0.01168;
+
+    double blackmanHarris(double offsetFromCentre) noexcept
+    {
+        auto x = juce::MathConstants<double>::twoPi * offsetFromCentre / AdditiveSynth::fftSize;
+        return bh0 + bh1 * std::cos(x) + bh2 * std::cos(2.0 * x) + bh3 * std::cos(3.0 * x);
+    }
+
+    constexpr double minus60DbLog = 6.907755; // ln(1000)
+
+    const AdditiveSynth::Preset presets[AdditiveSynth::numPresets] =
+    {
+        //  name              slope  even  inharm.  decay  spread  formant  width  gain
+        { "Sawtooth Stack",  -6.0f, 1.0f, 0.0f,    0.0f,  0.0f,   0.0f,    1.0f,  0.0f  },
+        { "Hollow Square",   -6.0f, 0.0f, 0.0f,    0.0f,  0.0f,   0.0f,    1.0f,  0.0f  },
+        { "Plucked String",  -5.0f, 1.0f, 0.0001f, 3.0f,  0.3f,   0.0f,    1.0f,  0.0f  },
+        { "Bell",            -3.0f, 1.0f, 0.002f,  5.0f,  0.5f,   0.0f,    1.0f,  0.0f  },
+        { "Vowel Pad",       -9.0f, 1.0f, 0.0f,    0.0f,  0.0f,   800.0f,  0.7f,  18.0f },
+    };
+}
+
+//==============================================================================
+AdditiveSynth::AdditiveSynth()
+{
+    // ~130k cosines, so they come from the on-disk cache: [kernel | synthesis window].
+    // The key names every constant the tables are built from.
+    const auto tableBytes = sizeof(float) * (size_t)(kernelTableSize + 2 * hopSize);
+    const auto key = "additive-windows-" + juce::String(fftSize) + "-hop" + juce::String(hopSize)
+                   + "-lobe" + juce::String(kernelHalfWidth) + "x" + juce::String(kernelOversampling);
+
+    windowTables = TableCache::getTable(key, 1, [tableBytes]
+    {
+        juce::MemoryBlock block(tableBytes, true);
+        auto* kernelTable = static_cast<float*>(block.getData());
+        auto* windowTable = kernelTable + kernelTableSize;
+
+        // Main lobe of the window's spectrum, from the centre out (it is symmetric).
+        // Scaled so the normalised inverse FFT gives back amplitude x window.
+        for (int i = 0; i < kernelTableSize; ++i)
+        {
+            auto binOffset = (double)i / kernelOversampling;
+            double sum = 0.0;
+            for (int m = -fftSize / 2; m < fftSize / 2; ++m)
+                sum += blackmanHarris(m) * std::cos(juce::MathConstants<double>::twoPi * binOffset * m / fftSize);
+            kernelTable[i] = i < kernelHalfWidth * kernelOversampling ? (float)sum : 0.0f;
+        }
+
+        // Undo the window and apply a triangle across the middle half: triangles one hop apart sum to 1
+        for (int j = 0; j < 2 * hopSize; ++j)
+        {
+            auto offset = j - hopSize;
+            auto triangle = 1.0 - std::abs(offset) / (double)hopSize;
+            windowTable[j] = (float)(triangle / blackmanHarris(offset));
+        }
+
+        return block;
+    }, tableBytes);
+    kernel = windowTables->getAs<float>();
+    synthesisWindow = kernel + kernelTableSize;
+
+    // Time-invariant spectral shape of each preset, normalised to a similar loudness
+    for (int p = 0; p < numPresets; ++p)
+    {
+        const auto& preset = presets[p];
+        double energy = 0.0;
+        for (int k = 1; k <= maxPartials; ++k)
+        {
+            auto shape = std::pow((float)k, preset.slopeDbPerOctave / 6.0206f) * (k % 2 == 0 ? preset.evenGain : 1.0f);
+            presetShape[(size_t)p][(size_t)(k - 1)] = shape;
+            energy += shape * shape;
+        }
+        presetGain[(size_t)p] = (float)(0.5 / std::sqrt(energy));
+    }
+
+    prepare(currentSampleRate);
+}
+
+const AdditiveSynth::Preset& AdditiveSynth::getPreset(int index) noexcept
+{
+    return presets[juce::jlimit(0, numPresets - 1, index)];
+}
+
+void AdditiveSynth::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+
+    // Higher partials die away faster; stored as the gain lost per frame
+    auto frameSeconds = hopSize / sampleRate;
+    for (int p = 0; p < numPresets; ++p)
+    {
+        const auto& preset = presets[p];
+        for (int k = 1; k <= maxPartials; ++k)
+        {
+            auto decay = 1.0f;
+            if (preset.decaySeconds > 0.0f)
+            {
+                auto seconds = preset.decaySeconds / (1.0f + preset.decaySpread * (float)(k - 1));
+                decay = (float)std::exp(-minus60DbLog * frameSeconds / seconds);
+            }
+            presetFrameDecay[(size_t)p][(size_t)(k - 1)] = decay;
+        }
+    }
+}
+
+void AdditiveSynth::noteOn(VoiceState& voice, bool freshVoice) const noexcept
+{
+    voice.decayGain.fill(1.0f);
+
+    if (freshVoice)
+    {
+        // Quadratic (Newman) start phases: all partials starting at 0 would pile up into one spike
+        for (int k = 0; k < maxPartials; ++k)
+            voice.phase[(size_t)k] = (float)std::fmod(juce::MathConstants<double>::pi * k * k / maxPartials,
+                                                      juce::MathConstants<double>::twoPi);
+        voice.overlap.fill(0.0f);
+        voice.readIndex = hopSize;
+    }
+    // A retrigger keeps its phases and pending overlap, so it doesn't click
+}
+
+//==============================================================================
+void AdditiveSynth::render(VoiceState& voice, int presetIndex, double frequency, float* output, int numSamples) noexcept
+{
+    jassert(presetIndex >= 0 && presetIndex < numPresets);
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        if (voice.readIndex >= hopSize)
+        {
+            synthesiseFrame(voice, presetIndex, frequency);
+            voice.readIndex = 0;
+        }
+
+        auto count = juce::jmin(numSamples - done, hopSize - voice.readIndex);
+        juce::FloatVectorOperations::copy(output + done, voice.ready.data() + voice.readIndex, count);
+        voice.readIndex += count;
+        done += count;
+    }
+}
+
+float AdditiveSynth::getKernel(float binOffset) const noexcept
+{
+    auto position = std::abs(binOffset) * (float)kernelOversampling;
+    auto index = (int)position;
+    if (index >= kernelHalfWidth * kernelOversampling)
+        return 0.0f;
+
+    auto fraction = position - (float)index;
+    return kernel[(size_t)index] + fraction * (kernel[(size_t)index + 1] - kernel[(size_t)index]);
+}
+
+void AdditiveSynth::synthesiseFrame(VoiceState& voice, int presetIndex, double frequency) noexcept
+{
+    const auto& preset = presets[presetIndex];
+    const auto& shape = presetShape[(size_t)presetIndex];
+    const auto& frameDecay = presetFrameDecay[(size_t)presetIndex];
+    const auto gain = presetGain[(size_t)presetIndex];
+
+    std::fill(spectrum.begin(), spectrum.begin() + fftSize + 2, 0.0f); // Bins 0 to N/2, interleaved re/im
+
+    const auto binsPerHz = fftSize / currentSampleRate;
+    const auto highestBin = (double)(fftSize / 2 - kernelHalfWidth); // Keep every lobe below Nyquist
+    const auto radiansPerHop = juce::MathConstants<double>::twoPi * hopSize / currentSampleRate;
+
+    // 1. Each partial drops its window lobe into the spectrum at its fractional bin
+    for (int k = 1; k <= maxPartials; ++k)
+    {
+        auto partialHz = frequency * k;
+        if (preset.inharmonicity > 0.0f)
+            partialHz *= std::sqrt(1.0 + preset.inharmonicity * k * k);
+
+        auto bin = partialHz * binsPerHz;
+        if (bin >= highestBin)
+            break; // Partial frequencies only rise with k
+
+        auto partial = (size_t)(k - 1);
+        auto amplitude = shape[partial] * voice.decayGain[partial] * gain;
+        if (preset.formantGainDb != 0.0f)
+        {
+            auto octavesAway = std::log2(partialHz / preset.formantHz) / preset.formantWidthOctaves;
+            amplitude *= juce::Decibels::decibelsToGain(preset.formantGainDb * (float)std::exp(-0.5 * octavesAway * octavesAway));
+        }
+
+        auto& phase = voice.phase[partial];
+        if (amplitude > 1.0e-6f)
+        {
+            auto binF = (float)bin;
+            auto re = 0.5f * amplitude * std::cos(phase);
+            auto im = 0.5f * amplitude * std::sin(phase);
+
+            auto first = juce::jmax(0, (int)std::ceil(binF - kernelHalfWidth));
+            auto last = juce::jmin(fftSize / 2, (int)std::floor(binF + kernelHalfWidth));
+            for (int b = first; b <= last; ++b)
+            {
+                auto weight = getKernel((float)b - binF);
+                spectrum[(size_t)(2 * b)] += weight * re;
+                spectrum[(size_t)(2 * b + 1)] += weight * im;
+            }
+
+            // Low partials: the negative-frequency lobe reaches into the first bins too
+            for (int b = 0; (float)b + binF < (float)kernelHalfWidth; ++b)
+            {
+                auto weight = getKernel((float)b + binF);
+                spectrum[(size_t)(2 * b)] += weight * re;
+                spectrum[(size_t)(2 * b + 1)] -= weight * im;
+            }
+        }
+
+        phase = (float)std::fmod(phase + radiansPerHop * partialHz, juce::MathConstants<double>::twoPi);
+        voice.decayGain[partial] *= frameDecay[partial];
+    }
+
+    // 2. One inverse FFT for all of them (normalised, real output in the first N floats)
+    fft.performRealOnlyInverseTransform(spectrum.data());
+
+    // 3. Overlap-add the middle half of the frame; its centre sits one hop into the accumulator
+    for (int j = 0; j < 2 * hopSize; ++j)
+    {
+        auto sampleIndex = (j - hopSize + fftSize) & (fftSize - 1); // Frame is circular around sample 0
+        voice.overlap[(size_t)j] += spectrum[(size_t)sampleIndex] * synthesisWindow[(size_t)j];
+    }
+
+    // The first hop is now complete; the second waits for the next frame's rising half
+    std::copy(voice.overlap.begin(), voice.overlap.begin() + hopSize, voice.ready.begin());
+    std::copy(voice.overlap.begin() + hopSize, voice.overlap.end(), voice.overlap.begin());
+    std::fill(voice.overlap.begin() + hopSize, voice.overlap.end(), 0.0f);
+}
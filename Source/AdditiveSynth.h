@@ -0,0 +1,91 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h> // For FFT
+#include <array>
+#include "TableCache.h"
+
+//==============================================================================
+/*
+    Additive voice renderer with up to 256 partials, used by SynthEngine's
+    additive voice type.
+
+    The partials are not run as sine oscillators. Once per frame (every hop of
+    128 samples), each partial adds the main lobe of a Blackman-Harris window's
+    spectrum (9 bins) into one spectrum at its fractional bin, with its
+    amplitude and phase. One inverse FFT then gives the sum of every windowed
+    partial. Dividing out the window and applying a triangle over the middle
+    half of the frame lets consecutive frames overlap-add to a flat gain, with
+    amplitudes interpolated linearly between frames. The cost per partial is a
+    handful of complex adds per hop, so a voice costs roughly the inverse FFT
+    plus a term that grows slowly with the partial count (FFT^-1 synthesis,
+    Rodet & Depalle).
+
+    Partial amplitudes come from the preset's spectral envelope: a tilt, an
+    even-harmonic balance, an optional formant peak and a per-partial decay,
+    all evaluated per frame (control rate). The output lags by one hop.
+
+    VoiceState is per voice; the AdditiveSynth object holds the FFT, the kernel
+    tables and shared scratch (voices render one at a time). The kernel tables
+    come from TableCache, so they are computed once per machine, not per engine.
+*/
+class AdditiveSynth
+{
+public:
+    static constexpr int fftOrder = 9;
+    static constexpr int fftSize = 1 << fftOrder;  // 512
+    static constexpr int hopSize = fftSize / 4;    // Triangle spans the middle half of the frame
+    static constexpr int maxPartials = 256;
+    static constexpr int numPresets = 5;
+
+    struct Preset
+    {
+        const char* name = "";
+        float slopeDbPerOctave = -6.0f; // Spectral tilt across the partials
+        float evenGain = 1.0f;          // Even harmonics relative to odd ones (0 = hollow)
+        float inharmonicity = 0.0f;     // Partial k at k * f0 * sqrt(1 + B k^2)
+        float decaySeconds = 0.0f;      // Partial 1's time to fall 60 dB (0 = sustained)
+        float decaySpread = 0.0f;       // Partial k decays (1 + spread * (k - 1)) times faster
+        float formantHz = 0.0f;         // Resonant peak, fixed in Hz (0 = none)
+        float formantWidthOctaves = 1.0f;
+        float formantGainDb = 0.0f;
+    };
+
+    struct VoiceState
+    {
+        std::array<float, maxPartials> phase{};       // Radians, at the centre of the next frame
+        std::array<float, maxPartials> decayGain{};   // Running product of the per-frame decay
+        std::array<float, 2 * hopSize> overlap{};     // Overlap-add accumulator
+        std::array<float, hopSize> ready{};           // Finished output, read from readIndex
+        int readIndex = hopSize;                      // hopSize = empty, synthesise the next frame
+    };
+
+    AdditiveSynth();
+
+    static const Preset& getPreset(int index) noexcept;
+
+    void prepare(double sampleRate);
+
+    // --- Audio thread ---
+    void noteOn(VoiceState& voice, bool freshVoice) const noexcept;
+    // Writes (not adds) numSamples of the voice's output. presetIndex: 0 to numPresets - 1.
+    void render(VoiceState& voice, int presetIndex, double frequency, float* output, int numSamples) noexcept;
+
+private:
+    void synthesiseFrame(VoiceState& voice, int presetIndex, double frequency) noexcept;
+    float getKernel(float binOffset) const noexcept;
+
+    static constexpr int kernelHalfWidth = 4;      // Blackman-Harris main lobe, in bins
+    static constexpr int kernelOversampling = 64;  // Table points per bin
+    static constexpr int kernelTableSize = kernelHalfWidth * kernelOversampling + 2;
+
+    double currentSampleRate = 44100.0;
+    juce::dsp::FFT fft{ fftOrder };
+    std::array<float, 2 * fftSize> spectrum{};                                  // Interleaved complex, FFT in place
+    std::shared_ptr<const TableCache::Table> windowTables;                      // The two below, cached on disk
+    const float* kernel = nullptr;                                              // Window spectrum, |offset| 0-4 bins
+    const float* synthesisWindow = nullptr;                                     // Triangle / window, middle half
+    std::array<std::array<float, maxPartials>, numPresets> presetShape{};       // Time-invariant part of the envelope
+    std::array<std::array<float, maxPartials>, numPresets> presetFrameDecay{};  // Per-frame decay factor
+    std::array<float, numPresets> presetGain{};                                 // Normalises each preset's loudness
+};
@@ -0,0 +1,165 @@
+#include "AudioRecorder.h"
+
+//==============================================================================
+AudioRecorder::AudioRecorder()
+    : juce::Thread("CSYNTH Recorder")
+{
+    startThread();
+}
+
+AudioRecorder::~AudioRecorder()
+{
+    stopRecording();
+    stopThread(1000);
+}
+
+void AudioRecorder::prepare(double sampleRate, int numChannels)
+{
+    currentSampleRate = sampleRate;
+    recordingChannels = juce::jlimit(1, 2, numChannels);
+}
+
+juce::File AudioRecorder::getDefaultFile(Format format)
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::userMusicDirectory).getChildFile("CSYNTH Recordings");
+    auto name = "CSYNTH_" + juce::Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S");
+    return folder.getChildFile(name).withFileExtension(format == flac ? "flac" : "wav");
+}
+
+//==============================================================================
+bool AudioRecorder::startRecording(const juce::File& file, Format format)
+{
+    stopRecording();
+
+    if (currentSampleRate <= 0.0)
+    {
+        DBG("AudioRecorder::startRecording - No audio device running yet");
+        return false;
+    }
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    std::unique_ptr<juce::FileOutputStream> fileStream(file.createOutputStream());
+    if (fileStream == nullptr)
+    {
+        DBG("AudioRecorder::startRecording - Can't open " + file.getFullPathName());
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormat> audioFormat;
+    if (format == flac)
+        audioFormat = std::make_unique<juce::FlacAudioFormat>();
+    else
+        audioFormat = std::make_unique<juce::WavAudioFormat>();
+
+    // 24-bit for both - headroom for quiet passages without float WAV compatibility issues
+    std::unique_ptr<juce::AudioFormatWriter> newWriter(audioFormat->createWriterFor(fileStream.get(), currentSampleRate,
+                                                                                   (unsigned int)recordingChannels, 24, {}, 0));
+    if (newWriter == nullptr)
+    {
+        DBG("AudioRecorder::startRecording - " + audioFormat->getFormatName() + " writer creation failed");
+        return false;
+    }
+
+    fileStream.release(); // The writer owns the stream now
+
+    {
+        // Nobody else touches the FIFO now: the audio thread only writes while recording is set
+        const juce::ScopedLock sl(writerLock);
+        fifo.reset();
+        writer = std::move(newWriter);
+        currentFile = file;
+    }
+    droppedBlocks.store(0);
+    recording.store(true); // From here on the audio thread writes into the FIFO
+
+    DBG("AudioRecorder: Recording to " + file.getFullPathName());
+    return true;
+}
+
+void AudioRecorder::stopRecording()
+{
+    if (! recording.load())
+        return;
+
+    // Detach from the audio thread first, then wait until it has left writeBlock
+    recording.store(false);
+    while (writesInFlight.load() > 0)
+        juce::Thread::yield();
+
+    // Write out what's left in the FIFO; destroying the writer closes the file
+    {
+        const juce::ScopedLock sl(writerLock);
+        drainFifo();
+        writer.reset();
+    }
+
+    DBG("AudioRecorder: Stopped recording " + currentFile.getFullPathName()
+        + " (dropped blocks: " + juce::String(droppedBlocks.load()) + ")");
+}
+
+//==============================================================================
+void AudioRecorder::writeBlock(const float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    ++writesInFlight; // Must come before loading the pointer, see stopRecording
+
+    if (recording.load())
+    {
+        if (fifo.getFreeSpace() < numSamples)
+        {
+            ++droppedBlocks; // FIFO full - the disk isn't keeping up
+        }
+        else
+        {
+            // Always two channels; with a mono source the second one just repeats channel 0
+            const float* channels[2] = { channelData[0], channelData[numChannels > 1 ? 1 : 0] };
+            const auto scope = fifo.write(numSamples);
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                if (scope.blockSize1 > 0)
+                    fifoBuffer.copyFrom(channel, scope.startIndex1, channels[channel], scope.blockSize1);
+                if (scope.blockSize2 > 0)
+                    fifoBuffer.copyFrom(channel, scope.startIndex2, channels[channel] + scope.blockSize1, scope.blockSize2);
+            }
+        }
+    }
+
+    --writesInFlight;
+}
+
+//==============================================================================
+void AudioRecorder::run()
+{
+    // Polled rather than signalled: the audio thread never wakes us (notify() takes a lock)
+    while (! threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(writerLock);
+            drainFifo();
+        }
+        wait(10);
+    }
+}
+
+void AudioRecorder::drainFifo()
+{
+    if (writer == nullptr)
+        return;
+
+    const auto scope = fifo.read(fifo.getNumReady());
+    const float* channels[2];
+    auto writeRun = [&](int start, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        channels[0] = fifoBuffer.getReadPointer(0, start);
+        channels[1] = fifoBuffer.getReadPointer(1, start);
+        if (! writer->writeFromFloatArrays(channels, recordingChannels, numSamples))
+            DBG("AudioRecorder: write failed for " + currentFile.getFullPathName());
+    };
+
+    writeRun(scope.startIndex1, scope.blockSize1);
+    writeRun(scope.startIndex2, scope.blockSize2);
+}
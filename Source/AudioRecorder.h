@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/*
+    Streams the master output to a WAV or FLAC file.
+
+    The audio thread hands each finished block to writeBlock(), which copies it into
+    a fixed-size lock-free FIFO (an AbstractFifo over a preallocated buffer). A
+    background thread polls that FIFO and drains it into the format writer. The
+    audio thread never touches the file, allocates or signals the thread (notify()
+    takes a lock), and memory use stays constant however long the recording runs.
+    If the disk can't keep up the block is dropped and counted, rather than blocking.
+*/
+class AudioRecorder : private juce::Thread
+{
+public:
+    enum Format
+    {
+        wav = 1,  // Matches the ComboBox IDs in ControlsComponent
+        flac
+    };
+
+    AudioRecorder();
+    ~AudioRecorder() override;
+
+    // Called from prepareToPlay, before any writeBlock
+    void prepare(double sampleRate, int numChannels);
+
+    // --- Message thread ---
+    bool startRecording(const juce::File& file, Format format);
+    void stopRecording();
+    bool isRecording() const noexcept { return recording.load(); }
+    juce::File getCurrentFile() const { return currentFile; }
+    int getNumDroppedBlocks() const noexcept { return droppedBlocks.load(); }
+
+    // Default location: <Music>/CSYNTH Recordings/CSYNTH_<date>_<time>.<ext>
+    static juce::File getDefaultFile(Format format);
+
+    // --- Audio thread ---
+    void writeBlock(const float* const* channelData, int numChannels, int numSamples) noexcept;
+
+private:
+    static constexpr int fifoSizeSamples = 65536; // ~1.4s at 48kHz of slack for slow disks
+
+    void run() override;
+    void drainFifo(); // Writer thread, or the message thread once the audio thread has detached
+
+    // Audio thread -> writer thread. Allocated once; only the positions move while recording.
+    juce::AbstractFifo fifo{ fifoSizeSamples };
+    juce::AudioBuffer<float> fifoBuffer{ 2, fifoSizeSamples };
+
+    juce::CriticalSection writerLock;                // Writer and message threads only, never the audio thread
+    std::unique_ptr<juce::AudioFormatWriter> writer; // Guarded by writerLock
+
+    // What the audio thread sees. Cleared before the writer is closed.
+    std::atomic<bool> recording{ false };
+    std::atomic<int> writesInFlight{ 0 }; // > 0 while the audio thread is inside writeBlock
+    std::atomic<int> droppedBlocks{ 0 };
+
+    double currentSampleRate = 0.0;
+    int    recordingChannels = 2;
+    juce::File currentFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioRecorder)
+};
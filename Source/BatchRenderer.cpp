@@ -0,0 +1,312 @@
+#include "BatchRenderer.h"
+#include "SynthEngine.h"
+#include "MainComponent.h" // For the Waveform enum
+#include <set>
+
+namespace
+{
+    struct VoiceInfo
+    {
+        const char* name;
+        int voiceType;
+        int numPresets;
+    };
+
+    const VoiceInfo voiceInfos[] =
+    {
+        { "oscillator", SynthEngine::oscillatorVoice, 4 }, // MainComponent::Waveform sine..triangle
+        { "fm",         SynthEngine::fmVoice,         FmSynth::numAlgorithms },
+        { "additive",   SynthEngine::additiveVoice,   AdditiveSynth::numPresets },
+    };
+
+    const char* const waveformNames[] = { "Sine", "Square", "Saw", "Triangle" };
+
+    juce::String getPresetName(int voiceType, int presetIndex)
+    {
+        if (voiceType == SynthEngine::fmVoice)
+            return FmSynth::getPatch(presetIndex).name;
+        if (voiceType == SynthEngine::additiveVoice)
+            return AdditiveSynth::getPreset(presetIndex).name;
+        return waveformNames[presetIndex];
+    }
+
+    juce::String getVoiceName(int voiceType)
+    {
+        for (const auto& info : voiceInfos)
+            if (info.voiceType == voiceType)
+                return info.name;
+        return "unknown";
+    }
+
+    // Names every parameter of the job, so no two different jobs write the same file
+    juce::String getFileName(const BatchRenderer::Job& job)
+    {
+        return juce::File::createLegalFileName(getVoiceName(job.voiceType) + "_" + job.presetName.replaceCharacter(' ', '-')
+                                               + "_" + juce::String(job.midiNote) + "_v" + juce::String(job.velocity)
+                                               + "_h" + juce::String(job.holdSeconds) + "s.wav");
+    }
+
+    struct JobResult
+    {
+        bool   ok = false;
+        double audioSeconds = 0.0;  // Written, after trimming
+        juce::String message;
+    };
+
+    // One job, start to finish, on whichever pool thread picked it up
+    JobResult renderJob(const BatchRenderer::Job& job, double sampleRate, const juce::File& outputFolder)
+    {
+        SynthEngine engine; // Its own everything: no state is shared between jobs
+        engine.prepareToPlay(sampleRate, BatchRenderer::blockSize, 1);
+        engine.setVoiceType(job.voiceType);
+        if (job.voiceType == SynthEngine::fmVoice)
+            engine.setFmPatch(job.presetIndex);
+        else if (job.voiceType == SynthEngine::additiveVoice)
+            engine.setAdditivePreset(job.presetIndex);
+        else
+            engine.setWaveform(MainComponent::sine + job.presetIndex);
+
+        const auto holdSamples = (int)std::ceil(job.holdSeconds * sampleRate);
+        const auto maxSamples = holdSamples + (int)std::ceil(BatchRenderer::maxTailSeconds * sampleRate);
+        juce::AudioBuffer<float> audio(1, maxSamples + BatchRenderer::blockSize);
+
+        // Hold, then release and run until the last voice has gone silent
+        engine.noteOn(job.midiNote, (float)job.velocity / 127.0f);
+        int rendered = 0;
+        while (rendered < holdSamples)
+        {
+            auto numSamples = juce::jmin(BatchRenderer::blockSize, holdSamples - rendered);
+            engine.renderNextBlock(audio, rendered, numSamples);
+            rendered += numSamples;
+        }
+        engine.noteOff(job.midiNote);
+        while (engine.isActive() && rendered < maxSamples)
+        {
+            engine.renderNextBlock(audio, rendered, BatchRenderer::blockSize);
+            rendered += BatchRenderer::blockSize;
+        }
+
+        // Trim trailing silence (keeping a few ms so the file doesn't end mid-ramp)
+        const auto* samples = audio.getReadPointer(0);
+        auto length = rendered;
+        while (length > 0 && std::abs(samples[length - 1]) < BatchRenderer::silenceThreshold)
+            --length;
+        length = juce::jmin(rendered, length + (int)(0.005 * sampleRate));
+
+        auto file = outputFolder.getChildFile(getFileName(job));
+        file.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return { false, 0.0, "can't create " + file.getFullPathName() };
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, 1, 24, {}, 0));
+        if (writer == nullptr)
+            return { false, 0.0, "WAV writer creation failed for " + file.getFullPathName() };
+        stream.release(); // The writer owns the stream now
+
+        if (! writer->writeFromAudioSampleBuffer(audio, 0, length))
+            return { false, 0.0, "write failed for " + file.getFullPathName() };
+
+        return { true, length / sampleRate, file.getFileName() };
+    }
+}
+
+//==============================================================================
+std::optional<BatchRenderer::Options> BatchRenderer::Options::fromCommandLine(const juce::String& commandLine)
+{
+    juce::ArgumentList args("CSYNTH", commandLine);
+    if (! args.containsOption("--batch-render"))
+        return std::nullopt;
+
+    Options result;
+    result.jobList = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--batch-render"));
+
+    auto output = args.getValueForOption("--output");
+    result.outputFolder = output.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile(output)
+                                              : juce::File::getSpecialLocation(juce::File::userMusicDirectory).getChildFile("CSYNTH Renders");
+
+    auto sampleRate = args.getValueForOption("--sample-rate");
+    if (sampleRate.isNotEmpty())
+        result.sampleRate = juce::jlimit(8000.0, 384000.0, sampleRate.getDoubleValue());
+
+    result.numThreads = juce::jmax(0, args.getValueForOption("--threads").getIntValue());
+    return result;
+}
+
+bool BatchRenderer::parseJobList(const juce::String& text, std::vector<Job>& jobs, juce::String& error)
+{
+    // A job listed twice (on one line or on several) would render the same file twice, in parallel
+    std::set<juce::String> fileNames;
+
+    auto lines = juce::StringArray::fromLines(text);
+    for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex)
+    {
+        auto line = lines[lineIndex].upToFirstOccurrenceOf("#", false, false).trim();
+        if (line.isEmpty())
+            continue;
+
+        auto fail = [&](const juce::String& message)
+        {
+            error = "line " + juce::String(lineIndex + 1) + ": " + message;
+            return false;
+        };
+
+        juce::StringArray fields;
+        fields.addTokens(line, ",", "\"");
+        fields.trim();
+        if (fields.size() != 5)
+            return fail("expected <voice>, <presets>, <notes>, <velocities>, <hold seconds>");
+
+        const VoiceInfo* voice = nullptr;
+        for (const auto& info : voiceInfos)
+            if (fields[0].equalsIgnoreCase(info.name))
+                voice = &info;
+        if (voice == nullptr)
+            return fail("unknown voice '" + fields[0] + "' (oscillator, fm or additive)");
+
+        // Presets: "all", indices or names
+        juce::Array<int> presets;
+        juce::StringArray presetTokens;
+        presetTokens.addTokens(fields[1], " ", "\"");
+        presetTokens.removeEmptyStrings();
+        for (auto token : presetTokens)
+        {
+            token = token.unquoted();
+            if (token.equalsIgnoreCase("all"))
+            {
+                for (int i = 0; i < voice->numPresets; ++i)
+                    presets.addIfNotAlreadyThere(i);
+                continue;
+            }
+
+            auto index = token.containsOnly("0123456789") ? token.getIntValue() : -1;
+            for (int i = 0; index < 0 && i < voice->numPresets; ++i)
+                if (token.equalsIgnoreCase(getPresetName(voice->voiceType, i)))
+                    index = i;
+            if (index < 0 || index >= voice->numPresets)
+                return fail("no " + juce::String(voice->name) + " preset '" + token + "'");
+            presets.addIfNotAlreadyThere(index);
+        }
+
+        auto parseNumbers = [](const juce::String& field, bool integers, double minimum, double maximum, juce::Array<double>& values)
+        {
+            juce::StringArray tokens;
+            tokens.addTokens(field, " ", "");
+            tokens.removeEmptyStrings();
+            for (const auto& token : tokens)
+            {
+                if (! token.containsOnly(integers ? "0123456789" : "0123456789.")
+                    || token.getDoubleValue() < minimum || token.getDoubleValue() > maximum)
+                    return false;
+                values.addIfNotAlreadyThere(token.getDoubleValue());
+            }
+            return ! values.isEmpty();
+        };
+
+        juce::Array<double> notes, velocities, holds;
+        if (presets.isEmpty())
+            return fail("no presets");
+        if (! parseNumbers(fields[2], true, 0.0, 127.0, notes))
+            return fail("notes must be MIDI note numbers 0-127");
+        if (! parseNumbers(fields[3], true, 1.0, 127.0, velocities))
+            return fail("velocities must be whole numbers 1-127");
+        if (! parseNumbers(fields[4], false, 0.001, 600.0, holds))
+            return fail("hold times must be seconds, up to 600");
+
+        // Every combination
+        for (auto preset : presets)
+            for (auto note : notes)
+                for (auto velocity : velocities)
+                    for (auto hold : holds)
+                    {
+                        Job job { voice->voiceType, preset, getPresetName(voice->voiceType, preset), (int)note, (int)velocity, hold };
+                        if (fileNames.insert(getFileName(job)).second)
+                            jobs.push_back(std::move(job));
+                    }
+    }
+
+    if (jobs.empty())
+    {
+        error = "no jobs in the list";
+        return false;
+    }
+    return true;
+}
+
+//==============================================================================
+int BatchRenderer::run(const Options& options)
+{
+    std::vector<Job> jobs;
+    juce::String error;
+    if (! options.jobList.existsAsFile())
+        error = "job list " + options.jobList.getFullPathName() + " not found";
+    else
+        parseJobList(options.jobList.loadFileAsString(), jobs, error);
+
+    if (error.isNotEmpty())
+    {
+        juce::Logger::writeToLog("Batch render: " + error);
+        return 1;
+    }
+
+    if (! options.outputFolder.createDirectory())
+    {
+        juce::Logger::writeToLog("Batch render: can't create " + options.outputFolder.getFullPathName());
+        return 1;
+    }
+
+    auto numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    juce::Logger::writeToLog("Batch render: " + juce::String((int)jobs.size()) + " jobs on " + juce::String(numThreads)
+                             + " threads at " + juce::String(options.sampleRate, 0) + " Hz -> " + options.outputFolder.getFullPathName());
+
+    // Results go to fixed slots, so the jobs never touch anything another job uses
+    std::vector<JobResult> results(jobs.size());
+    std::atomic<int> numFinished{ 0 };
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+    {
+        juce::ThreadPool pool(numThreads);
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            pool.addJob([&, i]
+            {
+                results[i] = renderJob(jobs[i], options.sampleRate, options.outputFolder);
+                ++numFinished;
+            });
+        }
+
+        // Before the message loop, so nothing else needs this thread: report progress until done
+        for (int lastReported = 0; numFinished.load() < (int)jobs.size();)
+        {
+            juce::Thread::sleep(200);
+            auto finished = numFinished.load();
+            if (finished - lastReported >= juce::jmax(1, (int)jobs.size() / 10))
+            {
+                juce::Logger::writeToLog("  " + juce::String(finished) + " / " + juce::String((int)jobs.size()));
+                lastReported = finished;
+            }
+        }
+    }
+    auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+
+    // Summary
+    int numFailed = 0;
+    double audioSeconds = 0.0;
+    for (const auto& result : results)
+    {
+        if (! result.ok)
+        {
+            ++numFailed;
+            juce::Logger::writeToLog("  failed: " + result.message);
+        }
+        audioSeconds += result.audioSeconds;
+    }
+
+    juce::Logger::writeToLog("Batch render: " + juce::String((int)jobs.size() - numFailed) + " files, "
+                             + juce::String(audioSeconds, 1) + " s of audio in " + juce::String(elapsedSeconds, 2) + " s ("
+                             + juce::String(audioSeconds / juce::jmax(1.0e-3, elapsedSeconds), 1) + "x real time, "
+                             + juce::String(jobs.size() / juce::jmax(1.0e-3, elapsedSeconds), 1) + " jobs/s)"
+                             + (numFailed > 0 ? ", " + juce::String(numFailed) + " failed" : juce::String()));
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <optional>
+#include <vector>
+
+//==============================================================================
+/*
+    Offline batch rendering of presets into WAV files: --batch-render.
+
+    A job list names voice type, presets, notes, velocities and hold times.
+    Each line expands to every combination of its values. Each job renders
+    through its own SynthEngine on a thread pool with one thread per core.
+    Jobs share nothing, so they scale with the cores and run much faster
+    than real time. A job holds the note for its hold time, releases it,
+    and renders until every voice has finished (up to maxTailSeconds). The
+    trailing silence is trimmed and the result written as 24-bit mono WAV.
+
+    Job list format, one job line per row, '#' starts a comment:
+        <voice>, <presets>, <notes>, <velocities>, <hold seconds>
+    voice:       oscillator | fm | additive
+    presets:     indices or names (a name with spaces needs quotes), or "all"
+    notes:       MIDI note numbers (whole numbers)
+    velocities:  1-127 (whole numbers)
+    Lists within a field are space-separated, e.g.
+        fm, all, 36 48 60 72, 64 127, 2.0
+    A combination that was already listed, on this line or an earlier one,
+    is only rendered once. File names include every value, hold time too.
+
+    Sampler and granular voices aren't offered: they play sample libraries
+    that are streamed from disk, which an offline job doesn't load.
+*/
+class BatchRenderer
+{
+public:
+    struct Options
+    {
+        juce::File jobList;
+        juce::File outputFolder;     // Default: Music/CSYNTH Renders
+        double sampleRate = 48000.0;
+        int    numThreads = 0;       // 0 = one per CPU core
+
+        // --batch-render=<job list> [--output=<folder>] [--sample-rate=<hz>] [--threads=<n>]
+        // Returns nothing unless --batch-render is given.
+        static std::optional<Options> fromCommandLine(const juce::String& commandLine);
+    };
+
+    struct Job
+    {
+        int    voiceType = 0;        // SynthEngine::VoiceType
+        int    presetIndex = 0;
+        juce::String presetName;
+        int    midiNote = 60;
+        int    velocity = 100;       // 1-127
+        double holdSeconds = 1.0;
+    };
+
+    static constexpr double maxTailSeconds = 10.0;
+    static constexpr float silenceThreshold = 3.2e-5f; // -90 dBFS
+    static constexpr int blockSize = 512;
+
+    // Parses the list; false with a message (naming the line) on the first bad line
+    static bool parseJobList(const juce::String& text, std::vector<Job>& jobs, juce::String& error);
+
+    // Renders every job and logs a throughput summary. Returns the process exit code.
+    static int run(const Options& options);
+
+private:
+    BatchRenderer() = delete;
+};
@@ -1,5 +1,6 @@
 #include "ControlsComponent.h"
 #include "MainComponent.h" // Needs to be included for calling MainComponent methods & enums
+#include "TraceRecorder.h"
 #include <juce_core/system/juce_TargetPlatform.h> // For DBG
 
 //==============================================================================
@@ -23,8 +24,7 @@ ControlsComponent::ControlsComponent(MainComponent* mainComp,
     rootNoteRef(rootNoteSelection),           // <-- Initialize NEW Ref
     scaleTypeRef(scaleTypeSelection)          // <-- Initialize NEW Ref
 {
-    // Ensure the pointer is valid before proceeding
-    jassert(mainComponentPtr != nullptr);
+    // mainComponentPtr may be null (the paint benchmark): the controls then show, but report nowhere
 
     // --- Waveform Selector ---
     waveformLabel.setText("Waveform:", juce::dontSendNotification);
@@ -52,6 +52,8 @@ ControlsComponent::ControlsComponent(MainComponent* mainComp,
     levelSlider.setValue(levelSmootherRef.getCurrentValue(), juce::dontSendNotification);
     levelSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
     levelSlider.addListener(this);
+    addAndMakeVisible(loadGraphButton); // Master bus patch, shares the level row
+    loadGraphButton.addListener(this);
 
     // --- Fine Tune Slider ---
     tuneLabel.setText("Fine Tune:", juce::dontSendNotification);
@@ -171,7 +173,7 @@ ControlsComponent::ControlsComponent(MainComponent* mainComp,
     scaleTypeSelector.setJustificationType(juce::Justification::centred);
     scaleTypeSelector.clear();
     // Populate using the names provided by MainComponent's getter
-    const auto& scaleNames = mainComponentPtr->getScaleNames();
+    const auto scaleNames = mainComponentPtr != nullptr ? mainComponentPtr->getScaleNames() : juce::StringArray();
     for (int i = 0; i < scaleNames.size(); ++i) {
         // Assuming scale IDs defined in MainComponent::ScaleType start from 1 and match vector index+1
         scaleTypeSelector.addItem(scaleNames[i], i + 1); // ID = index + 1
@@ -179,6 +181,84 @@ ControlsComponent::ControlsComponent(MainComponent* mainComp,
     scaleTypeSelector.setSelectedId(scaleTypeRef.load(), juce::dontSendNotification); // Set initial based on atomic state (1, 2, 3...)
     scaleTypeSelector.addListener(this);
 
+    // --- Recorder ---
+    recordLabel.setText("Record:", juce::dontSendNotification);
+    recordLabel.attachToComponent(&recordFormatSelector, true);
+    recordLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(recordLabel);
+    addAndMakeVisible(recordFormatSelector);
+    recordFormatSelector.addItem("WAV", AudioRecorder::wav);
+    recordFormatSelector.addItem("FLAC", AudioRecorder::flac);
+    recordFormatSelector.setSelectedId(AudioRecorder::wav, juce::dontSendNotification);
+    addAndMakeVisible(recordButton);
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::darkred);
+    recordButton.addListener(this);
+    updateRecordButton();
+
+    // --- Sampler ---
+    voiceTypeLabel.setText("Voice:", juce::dontSendNotification);
+    voiceTypeLabel.attachToComponent(&voiceTypeSelector, true);
+    voiceTypeLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(voiceTypeLabel);
+    addAndMakeVisible(voiceTypeSelector);
+    voiceTypeSelector.setJustificationType(juce::Justification::centred);
+    voiceTypeSelector.addItem("Oscillator", SynthEngine::oscillatorVoice);
+    voiceTypeSelector.addItem("Sampler", SynthEngine::samplerVoice);
+    voiceTypeSelector.addItem("FM", SynthEngine::fmVoice);
+    voiceTypeSelector.addItem("Additive", SynthEngine::additiveVoice);
+    voiceTypeSelector.addItem("Granular", SynthEngine::granularVoice);
+    voiceTypeSelector.setSelectedId(SynthEngine::oscillatorVoice, juce::dontSendNotification);
+    voiceTypeSelector.addListener(this);
+    addAndMakeVisible(patchSelector);
+    patchSelector.addListener(this);
+    updatePatchSelector();
+    addAndMakeVisible(loadSamplesButton);
+    loadSamplesButton.addListener(this);
+    addAndMakeVisible(sampleStatusLabel);
+    sampleStatusLabel.setFont(juce::FontOptions(12.0f));
+    if (mainComponentPtr != nullptr)
+        sampleStatusLabel.setText(mainComponentPtr->getSampleStatusText(), juce::dontSendNotification);
+
+    // --- Wavetables ---
+    wavetablePositionLabel.setText("Table Pos:", juce::dontSendNotification);
+    wavetablePositionLabel.attachToComponent(&wavetablePositionSlider, true);
+    wavetablePositionLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(wavetablePositionLabel);
+    addAndMakeVisible(wavetablePositionSlider);
+    wavetablePositionSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    wavetablePositionSlider.setRange(0.0, 1.0, 0.001);
+    wavetablePositionSlider.setValue(0.0, juce::dontSendNotification);
+    wavetablePositionSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    wavetablePositionSlider.addListener(this);
+    addAndMakeVisible(loadWavetableButton);
+    loadWavetableButton.addListener(this);
+
+    // --- Reverb ---
+    reverbLabel.setText("Reverb:", juce::dontSendNotification);
+    reverbLabel.attachToComponent(&reverbMixSlider, true);
+    reverbLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(reverbLabel);
+    addAndMakeVisible(reverbMixSlider);
+    reverbMixSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    reverbMixSlider.setRange(0.0, 1.0, 0.01);
+    reverbMixSlider.setValue(0.0, juce::dontSendNotification); // Off by default
+    reverbMixSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    reverbMixSlider.addListener(this);
+    addAndMakeVisible(loadImpulseButton);
+    loadImpulseButton.addListener(this);
+
+    // --- Vocoder (audio input as the modulator) ---
+    vocoderLabel.setText("Vocoder:", juce::dontSendNotification);
+    vocoderLabel.attachToComponent(&vocoderSelector, true);
+    vocoderLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(vocoderLabel);
+    addAndMakeVisible(vocoderSelector);
+    vocoderSelector.addItem("Off", 1);
+    for (auto bands : { 16, 24, 32, 40 })
+        vocoderSelector.addItem(juce::String(bands) + " bands (audio input)", bands);
+    vocoderSelector.setSelectedId(1, juce::dontSendNotification); // Off by default: no input device is opened
+    vocoderSelector.addListener(this);
+
     // Call once initially to set default ADSR params in MainComponent from slider values
     updateADSRParameters();
     // Initial filter update happens in MainComponent::prepareToPlay
@@ -189,6 +269,7 @@ ControlsComponent::~ControlsComponent() // No override
     // Remove all listeners
     waveformSelector.removeListener(this);
     levelSlider.removeListener(this);
+    loadGraphButton.removeListener(this);
     tuneSlider.removeListener(this);
     transposeSlider.removeListener(this);
     attackSlider.removeListener(this);
@@ -199,6 +280,15 @@ ControlsComponent::~ControlsComponent() // No override
     filterResonanceSlider.removeListener(this);
     rootNoteSelector.removeListener(this);    // <-- Remove new listeners
     scaleTypeSelector.removeListener(this);   // <-- Remove new listeners
+    recordButton.removeListener(this);
+    voiceTypeSelector.removeListener(this);
+    patchSelector.removeListener(this);
+    loadSamplesButton.removeListener(this);
+    wavetablePositionSlider.removeListener(this);
+    loadWavetableButton.removeListener(this);
+    reverbMixSlider.removeListener(this);
+    loadImpulseButton.removeListener(this);
+    vocoderSelector.removeListener(this);
 }
 
 void ControlsComponent::paint(juce::Graphics& g) // No override
@@ -207,41 +297,93 @@ void ControlsComponent::paint(juce::Graphics& g) // No override
     g.drawRect(getLocalBounds(), 1);   // Draw outline
 }
 
-// UPDATE resized to include scale controls
-// --- REPLACE resized function in ControlsComponent.cpp ---
+// Two columns: pitch/tone controls on the left, envelope and utilities on the right
 void ControlsComponent::resized() // No override
 {
     auto bounds = getLocalBounds().reduced(10); // Internal margin
     auto labelWidth = 80;    // Width for labels
     auto controlHeight = 25; // Height for controls
     auto spacing = 5;        // Vertical spacing
+    auto columnGap = 10;
+
+    auto leftColumn = bounds.removeFromLeft((bounds.getWidth() - columnGap) / 2);
+    bounds.removeFromLeft(columnGap);
+    auto rightColumn = bounds;
 
-    // Helper lambda (no changes needed)
-    auto layoutRow = [&](juce::Component& control) {
-        auto rowBounds = bounds.removeFromTop(controlHeight);
-        if (rowBounds.getHeight() < controlHeight) return; // Stop if not enough vertical space
-        control.setBounds(labelWidth, rowBounds.getY(), rowBounds.getWidth() - labelWidth, controlHeight);
-        bounds.removeFromTop(spacing);
+    // Lays out one row in the given column; the attached label sits in the labelWidth gap on its left
+    auto layoutRow = [&](juce::Rectangle<int>& column, juce::Component& control) {
+        auto rowBounds = column.removeFromTop(controlHeight);
+        if (rowBounds.getHeight() < controlHeight) return juce::Rectangle<int>(); // Stop if not enough vertical space
+        auto controlBounds = rowBounds.withTrimmedLeft(labelWidth);
+        control.setBounds(controlBounds);
+        column.removeFromTop(spacing);
+        return controlBounds;
         };
 
-    // --- REORDERED Layout ---
-    layoutRow(rootNoteSelector);    // <-- Moved Up
-    layoutRow(scaleTypeSelector);   // <-- Moved Up
-    layoutRow(waveformSelector);    // <-- Now 3rd
-    layoutRow(levelSlider);
-    layoutRow(tuneSlider);
-    layoutRow(transposeSlider);
-    layoutRow(attackSlider);
-    layoutRow(decaySlider);
-    layoutRow(sustainSlider);
-    layoutRow(releaseSlider);
-    layoutRow(filterCutoffSlider);
-    layoutRow(filterResonanceSlider);
+    layoutRow(leftColumn, rootNoteSelector);
+    layoutRow(leftColumn, scaleTypeSelector);
+    layoutRow(leftColumn, waveformSelector);
+    // Level slider and graph button share one row
+    auto levelRow = layoutRow(leftColumn, levelSlider);
+    if (! levelRow.isEmpty())
+    {
+        loadGraphButton.setBounds(levelRow.removeFromRight(100));
+        levelSlider.setBounds(levelRow.withTrimmedRight(spacing));
+    }
+    layoutRow(leftColumn, tuneSlider);
+    layoutRow(leftColumn, transposeSlider);
+    layoutRow(leftColumn, filterCutoffSlider);
+    layoutRow(leftColumn, filterResonanceSlider);
+
+    // Mix slider and IR button share one row
+    auto reverbRow = layoutRow(leftColumn, reverbMixSlider);
+    if (! reverbRow.isEmpty())
+    {
+        loadImpulseButton.setBounds(reverbRow.removeFromRight(100));
+        reverbMixSlider.setBounds(reverbRow.withTrimmedRight(spacing));
+    }
+
+    layoutRow(leftColumn, vocoderSelector);
+
+    layoutRow(rightColumn, attackSlider);
+    layoutRow(rightColumn, decaySlider);
+    layoutRow(rightColumn, sustainSlider);
+    layoutRow(rightColumn, releaseSlider);
+
+    // Format selector and record button share one row
+    auto recordRow = layoutRow(rightColumn, recordFormatSelector);
+    if (! recordRow.isEmpty())
+    {
+        recordFormatSelector.setBounds(recordRow.removeFromLeft(recordRow.getWidth() / 2));
+        recordButton.setBounds(recordRow.withTrimmedLeft(spacing));
+    }
+
+    // Morph slider and load button share one row
+    auto wavetableRow = layoutRow(rightColumn, wavetablePositionSlider);
+    if (! wavetableRow.isEmpty())
+    {
+        loadWavetableButton.setBounds(wavetableRow.removeFromRight(100));
+        wavetablePositionSlider.setBounds(wavetableRow.withTrimmedRight(spacing));
+    }
+
+    // Voice type and its patch share one row
+    auto voiceRow = layoutRow(rightColumn, voiceTypeSelector);
+    if (! voiceRow.isEmpty())
+    {
+        voiceTypeSelector.setBounds(voiceRow.removeFromLeft(voiceRow.getWidth() / 2));
+        patchSelector.setBounds(voiceRow.withTrimmedLeft(spacing));
+    }
+
+    // Load button on the label side of the row, status text beside it
+    auto sampleRow = rightColumn.removeFromTop(controlHeight);
+    loadSamplesButton.setBounds(sampleRow.removeFromLeft(labelWidth + 60));
+    sampleStatusLabel.setBounds(sampleRow.withTrimmedLeft(spacing));
 }
 
 // UPDATE comboBoxChanged to handle new selectors
 void ControlsComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) // No override
 {
+    const TraceRecorder::ScopedEvent trace("ControlsComponent::comboBoxChanged");
     if (mainComponentPtr == nullptr) return;
 
     if (comboBoxThatHasChanged == &waveformSelector)
@@ -265,11 +407,73 @@ void ControlsComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
         // Assuming scaleId corresponds directly to MainComponent::ScaleType enum values (1, 2, 3...)
         mainComponentPtr->setScaleType(scaleId); // Call setter on MainComponent
     }
+    else if (comboBoxThatHasChanged == &vocoderSelector)
+    {
+        auto bands = vocoderSelector.getSelectedId() > 1 ? vocoderSelector.getSelectedId() : 0;
+        auto error = mainComponentPtr->setVocoderBands(bands);
+        sampleStatusLabel.setText(error.isNotEmpty() ? error
+                                  : bands > 0 ? "Vocoder: " + juce::String(bands) + " bands, audio input as modulator"
+                                  : juce::String("Vocoder off"),
+                                  juce::dontSendNotification);
+    }
+    else if (comboBoxThatHasChanged == &voiceTypeSelector)
+    {
+        mainComponentPtr->setVoiceType(voiceTypeSelector.getSelectedId());
+        updatePatchSelector();
+    }
+    else if (comboBoxThatHasChanged == &patchSelector)
+    {
+        // ID = index + 1 within whichever list is showing
+        if (voiceTypeSelector.getSelectedId() == SynthEngine::fmVoice)
+        {
+            fmPatchId = patchSelector.getSelectedId();
+            mainComponentPtr->setFmPatch(fmPatchId - 1);
+        }
+        else if (voiceTypeSelector.getSelectedId() == SynthEngine::additiveVoice)
+        {
+            additivePresetId = patchSelector.getSelectedId();
+            mainComponentPtr->setAdditivePreset(additivePresetId - 1);
+        }
+        else if (voiceTypeSelector.getSelectedId() == SynthEngine::granularVoice)
+        {
+            granularPresetId = patchSelector.getSelectedId();
+            mainComponentPtr->setGranularPreset(granularPresetId - 1);
+        }
+    }
+}
+
+void ControlsComponent::updatePatchSelector()
+{
+    // FM, additive and granular voices each have their own preset list; the other voice types have none
+    patchSelector.clear(juce::dontSendNotification);
+    auto voiceType = voiceTypeSelector.getSelectedId();
+
+    if (voiceType == SynthEngine::fmVoice)
+    {
+        for (int i = 0; i < FmSynth::numAlgorithms; ++i)
+            patchSelector.addItem(FmSynth::getPatch(i).name, i + 1);
+        patchSelector.setSelectedId(fmPatchId, juce::dontSendNotification);
+    }
+    else if (voiceType == SynthEngine::additiveVoice)
+    {
+        for (int i = 0; i < AdditiveSynth::numPresets; ++i)
+            patchSelector.addItem(AdditiveSynth::getPreset(i).name, i + 1);
+        patchSelector.setSelectedId(additivePresetId, juce::dontSendNotification);
+    }
+    else if (voiceType == SynthEngine::granularVoice)
+    {
+        for (int i = 0; i < GranularSynth::numPresets; ++i)
+            patchSelector.addItem(GranularSynth::getPreset(i).name, i + 1);
+        patchSelector.setSelectedId(granularPresetId, juce::dontSendNotification);
+    }
+
+    patchSelector.setEnabled(patchSelector.getNumItems() > 0);
 }
 
 // UPDATE sliderValueChanged to use setters for Tune/Transpose/Filter
 void ControlsComponent::sliderValueChanged(juce::Slider* sliderThatWasMoved) // No override
 {
+    const TraceRecorder::ScopedEvent trace("ControlsComponent::sliderValueChanged");
     if (mainComponentPtr == nullptr) return;
 
     if (sliderThatWasMoved == &levelSlider)
@@ -285,6 +489,14 @@ void ControlsComponent::sliderValueChanged(juce::Slider* sliderThatWasMoved) //
     {
         mainComponentPtr->setTranspose((int)transposeSlider.getValue()); // Call setter
     }
+    else if (sliderThatWasMoved == &wavetablePositionSlider)
+    {
+        mainComponentPtr->setWavetablePosition((float)wavetablePositionSlider.getValue());
+    }
+    else if (sliderThatWasMoved == &reverbMixSlider)
+    {
+        mainComponentPtr->setReverbMix((float)reverbMixSlider.getValue());
+    }
     else if (sliderThatWasMoved == &filterCutoffSlider ||
         sliderThatWasMoved == &filterResonanceSlider)
     {
@@ -313,4 +525,123 @@ void ControlsComponent::updateADSRParameters()
         float r = (float)releaseSlider.getValue();
         mainComponentPtr->updateADSR(a, d, s, r);
     }
+}
+
+void ControlsComponent::buttonClicked(juce::Button* buttonThatWasClicked)
+{
+    const TraceRecorder::ScopedEvent trace("ControlsComponent::buttonClicked");
+    if (mainComponentPtr == nullptr) return;
+
+    if (buttonThatWasClicked == &recordButton)
+    {
+        if (mainComponentPtr->isRecording())
+            mainComponentPtr->stopRecording();
+        else if (! mainComponentPtr->startRecording(recordFormatSelector.getSelectedId()))
+            DBG("ControlsComponent: Recording could not be started");
+
+        updateRecordButton();
+    }
+    else if (buttonThatWasClicked == &loadSamplesButton)
+    {
+        sampleFolderChooser = std::make_unique<juce::FileChooser>("Choose a folder of samples (e.g. Piano_C4_v127.wav)",
+                                                                  juce::File::getSpecialLocation(juce::File::userMusicDirectory));
+        sampleFolderChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+            [this](const juce::FileChooser& chooser)
+            {
+                auto folder = chooser.getResult();
+                if (folder == juce::File() || mainComponentPtr == nullptr)
+                    return;
+
+                mainComponentPtr->loadSampleLibrary(folder);
+                statusSource = sampleStatus;
+                voiceTypeSelector.setSelectedId(SynthEngine::samplerVoice); // Notifies MainComponent
+                startTimerHz(4);
+                timerCallback();
+            });
+    }
+    else if (buttonThatWasClicked == &loadWavetableButton)
+    {
+        wavetableFileChooser = std::make_unique<juce::FileChooser>("Choose a wavetable (single cycle, or 2048-sample frames)",
+                                                                   juce::File::getSpecialLocation(juce::File::userMusicDirectory),
+                                                                   "*.wav;*.aif;*.aiff;*.flac");
+        wavetableFileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser)
+            {
+                auto file = chooser.getResult();
+                if (! file.existsAsFile() || mainComponentPtr == nullptr)
+                    return;
+
+                mainComponentPtr->loadWavetable(file);
+                statusSource = wavetableStatus;
+                startTimerHz(4);
+                timerCallback();
+            });
+    }
+    else if (buttonThatWasClicked == &loadImpulseButton)
+    {
+        impulseFileChooser = std::make_unique<juce::FileChooser>("Choose an impulse response",
+                                                                 juce::File::getSpecialLocation(juce::File::userMusicDirectory),
+                                                                 "*.wav;*.aif;*.aiff;*.flac");
+        impulseFileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser)
+            {
+                auto file = chooser.getResult();
+                if (! file.existsAsFile() || mainComponentPtr == nullptr)
+                    return;
+
+                mainComponentPtr->loadImpulseResponse(file);
+                statusSource = reverbStatus;
+                startTimerHz(4);
+                timerCallback();
+            });
+    }
+    else if (buttonThatWasClicked == &loadGraphButton)
+    {
+        graphFileChooser = std::make_unique<juce::FileChooser>("Choose a graph patch",
+                                                               juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
+                                                               "*.txt;*.graph");
+        graphFileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser)
+            {
+                auto file = chooser.getResult();
+                if (! file.existsAsFile() || mainComponentPtr == nullptr)
+                    return;
+
+                mainComponentPtr->loadGraph(file); // Compiled right away; errors show on the status line
+                statusSource = graphStatus;
+                timerCallback();
+            });
+    }
+}
+
+void ControlsComponent::timerCallback()
+{
+    const auto& bank = mainComponentPtr->getWavetableBank();
+    sampleStatusLabel.setText(statusSource == wavetableStatus ? bank.getStatusText()
+                              : statusSource == reverbStatus ? mainComponentPtr->getReverbStatusText()
+                              : statusSource == graphStatus ? mainComponentPtr->getGraphStatusText()
+                              : mainComponentPtr->getSampleStatusText(),
+                              juce::dontSendNotification);
+
+    // Newly built wavetables join the waveform list; the latest one gets selected
+    if (bank.getNumTables() > numWavetablesListed)
+    {
+        while (numWavetablesListed < bank.getNumTables())
+        {
+            waveformSelector.addItem(bank.getTableName(numWavetablesListed), WavetableBank::firstTableId + numWavetablesListed);
+            ++numWavetablesListed;
+        }
+        waveformSelector.setSelectedId(WavetableBank::firstTableId + numWavetablesListed - 1); // Notifies MainComponent
+    }
+
+    if (! mainComponentPtr->isSampleLibraryLoading() && ! bank.isLoading() && ! mainComponentPtr->isImpulseResponseLoading())
+        stopTimer();
+}
+
+void ControlsComponent::updateRecordButton()
+{
+    bool recording = mainComponentPtr != nullptr && mainComponentPtr->isRecording();
+    recordButton.setButtonText(recording ? "Stop" : "Record");
+    recordButton.setToggleState(recording, juce::dontSendNotification);
+    recordFormatSelector.setEnabled(! recording);
 }
\ No newline at end of file
@@ -13,10 +13,12 @@ class MainComponent;
 */
 class ControlsComponent : public juce::Component,
     public juce::ComboBox::Listener,
-    public juce::Slider::Listener
+    public juce::Slider::Listener,
+    public juce::Button::Listener,
+    private juce::Timer
 {
 public:
-    // Constructor takes pointer to MainComponent and references to ALL states it controls
+    // Constructor takes pointer to MainComponent (null: controls that report nowhere) and references to ALL states it controls
     ControlsComponent(MainComponent* mainComp,
         std::atomic<int>& waveformSelection,
         juce::SmoothedValue<float>& levelSmoother,
@@ -36,6 +38,7 @@ public:
     // Listener Callbacks
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override; // Keep override here
     void sliderValueChanged(juce::Slider* sliderThatWasMoved) override;   // Keep override here
+    void buttonClicked(juce::Button* buttonThatWasClicked) override;
 
 private:
     // UI Elements
@@ -73,6 +76,44 @@ private:
     juce::Label scaleTypeLabel;         // <-- NEW Declaration
     juce::ComboBox scaleTypeSelector;   // <-- NEW Declaration
 
+    // --- Recorder Controls ---
+    juce::Label recordLabel;
+    juce::ComboBox recordFormatSelector;
+    juce::TextButton recordButton{ "Record" };
+
+    // --- Sampler Controls ---
+    juce::Label voiceTypeLabel;
+    juce::ComboBox voiceTypeSelector;
+    juce::ComboBox patchSelector;       // FM, additive or granular preset for the selected voice type, ID = index + 1
+    int fmPatchId = 1, additivePresetId = 1, granularPresetId = 1; // Remembered while another list is showing
+    juce::TextButton loadSamplesButton{ "Load Samples..." };
+    juce::Label sampleStatusLabel;
+    std::unique_ptr<juce::FileChooser> sampleFolderChooser;
+
+    // --- Wavetable Controls ---
+    juce::Label wavetablePositionLabel;
+    juce::Slider wavetablePositionSlider;
+    juce::TextButton loadWavetableButton{ "Load Table..." };
+    std::unique_ptr<juce::FileChooser> wavetableFileChooser;
+    int numWavetablesListed = 0;
+
+    // --- Reverb Controls ---
+    juce::Label reverbLabel;
+    juce::Slider reverbMixSlider;
+    juce::TextButton loadImpulseButton{ "Load IR..." };
+    std::unique_ptr<juce::FileChooser> impulseFileChooser;
+
+    // --- Vocoder Controls ---
+    juce::Label vocoderLabel;
+    juce::ComboBox vocoderSelector;     // ID 1 = off, otherwise the band count
+
+    // --- Master Graph Controls ---
+    juce::TextButton loadGraphButton{ "Load Graph..." };
+    std::unique_ptr<juce::FileChooser> graphFileChooser;
+
+    // The status line follows whichever load was started last
+    enum StatusSource { sampleStatus, wavetableStatus, reverbStatus, graphStatus };
+    StatusSource statusSource = sampleStatus;
 
     // Pointer back to MainComponent (used for updateADSR)
     MainComponent* mainComponentPtr;
@@ -89,6 +130,9 @@ private:
 
     // Helper function to trigger update in MainComponent for ADSR
     void updateADSRParameters();
+    void updateRecordButton();
+    void updatePatchSelector();
+    void timerCallback() override; // Polls the sample library / wavetable / IR status while they load
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlsComponent)
@@ -0,0 +1,613 @@
+#include "ConvolutionReverb.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // The real-only FFT works in place on interleaved (re, im) pairs
+    std::complex<float>* asComplex(std::vector<float>& buffer) { return reinterpret_cast<std::complex<float>*>(buffer.data()); }
+}
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+    : juce::Thread("CSYNTH Reverb Tail")
+{
+    // Everything the audio thread touches is allocated here, once - sizes don't depend on the IR
+    firHistory.assign((size_t)(2 * headSize - 1), 0.0f);
+    blockInput.assign((size_t)(2 * headSize), 0.0f);
+    headFftBuffer.assign((size_t)(4 * headSize), 0.0f);
+    headFdl.assign((size_t)(maxHeadPartitions * (headSize + 1)), {});
+    headAccumulator.assign((size_t)(headSize + 1), {});
+    partitionOutput.assign((size_t)headSize, 0.0f);
+    tailInputRing.assign((size_t)tailRingSize, 0.0f);
+    tailOutputRing.assign((size_t)tailRingSize, 0.0f);
+
+    tailFftBuffer.assign((size_t)(4 * tailPartitionSize), 0.0f);
+    tailWindow.assign((size_t)(2 * tailPartitionSize), 0.0f);
+    tailAccumulator.assign((size_t)(tailPartitionSize + 1), {});
+
+    startThread(juce::Thread::Priority::high); // Has a hard deadline of one tail partition
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    loaderPool.removeAllJobs(true, 10000);
+    stopThread(2000);
+
+    // No other thread is running now
+    delete pendingKernel.exchange(nullptr);
+    delete retiredKernel.exchange(nullptr);
+    delete activeKernel;
+}
+
+void ConvolutionReverb::prepare(double sampleRate)
+{
+    wetGain.reset(sampleRate, 0.05);
+    wetGain.setCurrentAndTargetValue(mix.load());
+    isBypassed = true; // Forces a state reset on the first processed block
+    audioBypassed.store(true);
+
+    // IRs are resampled to the device rate when they're built
+    if (preparedSampleRate.exchange(sampleRate) != sampleRate)
+    {
+        juce::File source;
+        {
+            const juce::ScopedLock sl(statusLock);
+            source = currentSource;
+        }
+        startKernelBuild(source);
+    }
+}
+
+void ConvolutionReverb::prebuild(double expectedSampleRate)
+{
+    // Only before the first prepare - after that the real rate is known
+    double notPrepared = 0.0;
+    if (preparedSampleRate.compare_exchange_strong(notPrepared, expectedSampleRate))
+    {
+        juce::File source;
+        {
+            const juce::ScopedLock sl(statusLock);
+            source = currentSource;
+        }
+        startKernelBuild(source);
+    }
+}
+
+//==============================================================================
+void ConvolutionReverb::loadImpulseResponseAsync(const juce::File& file)
+{
+    startKernelBuild(file);
+}
+
+void ConvolutionReverb::useBuiltInImpulseResponse()
+{
+    startKernelBuild({});
+}
+
+void ConvolutionReverb::setMix(float wetLevel)
+{
+    mix.store(juce::jlimit(0.0f, 1.0f, wetLevel));
+    notify(); // The tail thread sleeps while the reverb is bypassed
+}
+
+juce::String ConvolutionReverb::getStatusText() const
+{
+    const juce::ScopedLock sl(statusLock);
+    return statusText;
+}
+
+void ConvolutionReverb::startKernelBuild(const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(statusLock);
+        currentSource = file;
+        statusText = "Loading " + (file == juce::File() ? juce::String("built-in IR") : file.getFileName()) + "...";
+    }
+
+    // Jobs run one at a time in order, so the most recent request is the one that ends up pending
+    ++numLoadsQueued;
+    loaderPool.addJob([this, file]
+    {
+        auto sampleRate = preparedSampleRate.load();
+        if (sampleRate <= 0.0)
+        {
+            // No device yet - prepare() starts another build once the rate is known
+            --numLoadsQueued;
+            return;
+        }
+
+        juce::String error;
+        std::unique_ptr<Kernel> kernel;
+        if (file == juce::File())
+        {
+            kernel = loadBuiltInKernel(sampleRate);
+        }
+        else
+        {
+            auto impulse = readImpulse(file, sampleRate, error);
+            if (error.isEmpty())
+                kernel = buildKernel(std::move(impulse), sampleRate, file.getFileNameWithoutExtension());
+        }
+
+        if (kernel != nullptr)
+        {
+            auto summary = kernel->name + ": " + juce::String(kernel->length / sampleRate, 2) + " s";
+            delete pendingKernel.exchange(kernel.release()); // Replaces one the audio thread hasn't picked up yet
+            notify(); // Wakes the tail thread to serve the new IR and delete the old one
+
+            const juce::ScopedLock sl(statusLock);
+            statusText = summary;
+        }
+        else
+        {
+            const juce::ScopedLock sl(statusLock);
+            statusText = error;
+        }
+
+        --numLoadsQueued;
+    });
+}
+
+//==============================================================================
+std::vector<float> ConvolutionReverb::readImpulse(const juce::File& file, double sampleRate, juce::String& errorMessage)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        errorMessage = "Can't read " + file.getFileName();
+        return {};
+    }
+
+    // Mono mixdown of (at most) the first maxImpulseSeconds
+    auto length = (int)juce::jmin(reader->lengthInSamples, (juce::int64)(maxImpulseSeconds * reader->sampleRate));
+    auto numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+    juce::AudioBuffer<float> source(numChannels, length);
+    reader->read(&source, 0, length, 0, true, numChannels > 1);
+    if (numChannels > 1)
+    {
+        source.addFrom(0, 0, source, 1, 0, length);
+        source.applyGain(0, 0, length, 0.5f);
+    }
+
+    std::vector<float> impulse(source.getReadPointer(0), source.getReadPointer(0) + length);
+    if (reader->sampleRate == sampleRate)
+        return impulse;
+
+    // Resample to the device rate
+    auto ratio = reader->sampleRate / sampleRate;
+    auto outputLength = (int)(length / ratio);
+    impulse.resize((size_t)length + 8, 0.0f); // Interpolator reads a few samples past the end
+    std::vector<float> resampled((size_t)outputLength);
+    juce::LagrangeInterpolator interpolator;
+    interpolator.process(ratio, impulse.data(), resampled.data(), outputLength);
+    return resampled;
+}
+
+std::vector<float> ConvolutionReverb::createBuiltInImpulse(double sampleRate)
+{
+    // Exponentially decaying noise with a few early reflections, darkening as it decays
+    const auto length = (int)(2.5 * sampleRate);
+    const auto decayPerSample = std::pow(0.001, 1.0 / (2.2 * sampleRate)); // -60 dB after 2.2s
+    std::vector<float> impulse((size_t)length, 0.0f);
+
+    juce::Random random(0x5eed); // Fixed seed - the same hall every time
+    double envelope = 1.0;
+    float lowpassState = 0.0f;
+    for (int i = 0; i < length; ++i)
+    {
+        auto damping = 0.15f + 0.8f * (float)i / (float)length; // One-pole coefficient, rising over time
+        lowpassState += (1.0f - damping) * (random.nextFloat() * 2.0f - 1.0f - lowpassState);
+        impulse[(size_t)i] = lowpassState * (float)envelope;
+        envelope *= decayPerSample;
+    }
+
+    const double reflectionTimesMs[] = { 7.0, 11.5, 17.0, 23.5, 31.0 };
+    auto gain = 0.8f;
+    for (auto timeMs : reflectionTimesMs)
+    {
+        impulse[(size_t)(timeMs * 0.001 * sampleRate)] += gain;
+        gain *= -0.75f;
+    }
+
+    return impulse;
+}
+
+std::unique_ptr<ConvolutionReverb::Kernel> ConvolutionReverb::buildKernel(std::vector<float> impulse, double sampleRate, const juce::String& name)
+{
+    // Drop the inaudible end (below -90 dB of the peak) - it would only cost tail partitions
+    auto peak = 0.0f;
+    for (auto sample : impulse)
+        peak = juce::jmax(peak, std::abs(sample));
+    auto threshold = peak * 3.16e-5f;
+    while (! impulse.empty() && std::abs(impulse.back()) <= threshold)
+        impulse.pop_back();
+
+    // Normalise the energy so the wet level doesn't depend on the IR's length or gain
+    double energy = 0.0;
+    for (auto sample : impulse)
+        energy += (double)sample * sample;
+    if (energy > 0.0)
+    {
+        auto gain = (float)(0.5 / std::sqrt(energy));
+        for (auto& sample : impulse)
+            sample *= gain;
+    }
+
+    auto kernel = std::make_unique<Kernel>();
+    kernel->name = name;
+    kernel->sampleRate = sampleRate;
+
+    const auto length = (int)impulse.size();
+    kernel->length = length;
+    auto tapAt = [&](int index) { return index < length ? impulse[(size_t)index] : 0.0f; };
+
+    // Direct-form head
+    kernel->headTaps.resize((size_t)headSize);
+    for (int i = 0; i < headSize; ++i)
+        kernel->headTaps[(size_t)i] = tapAt(i);
+
+    // Transforms one partition of the IR, zero-padded to twice its size
+    auto transformPartitions = [&](int firstTap, int partitionSize, int numPartitions, juce::dsp::FFT& fft,
+                                   std::vector<std::complex<float>>& spectra)
+    {
+        const auto numBins = partitionSize + 1;
+        spectra.assign((size_t)(numPartitions * numBins), {});
+        std::vector<float> buffer((size_t)(4 * partitionSize));
+
+        for (int partition = 0; partition < numPartitions; ++partition)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            for (int i = 0; i < partitionSize; ++i)
+                buffer[(size_t)i] = tapAt(firstTap + partition * partitionSize + i);
+
+            fft.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy_n(asComplex(buffer), numBins, spectra.begin() + partition * numBins);
+        }
+    };
+
+    // Uniform 128-sample partitions up to tailStart
+    kernel->numHeadPartitions = juce::jlimit(0, maxHeadPartitions, (length - headSize + headSize - 1) / headSize);
+    juce::dsp::FFT headTransform(8);
+    transformPartitions(headSize, headSize, kernel->numHeadPartitions, headTransform, kernel->headSpectra);
+
+    // 2048-sample partitions for everything after that
+    kernel->numTailPartitions = juce::jmax(0, (length - tailStart + tailPartitionSize - 1) / tailPartitionSize);
+    juce::dsp::FFT tailTransform(12);
+    transformPartitions(tailStart, tailPartitionSize, kernel->numTailPartitions, tailTransform, kernel->tailSpectra);
+
+    kernel->taps = kernel->headTaps.data();
+    kernel->headFilters = kernel->headSpectra.data();
+    kernel->tailFilters = kernel->tailSpectra.data();
+
+    DBG("ConvolutionReverb: Built '" + name + "' - " + juce::String(length) + " taps, "
+        + juce::String(kernel->numHeadPartitions) + " head + " + juce::String(kernel->numTailPartitions) + " tail partitions");
+    return kernel;
+}
+
+std::unique_ptr<ConvolutionReverb::Kernel> ConvolutionReverb::loadBuiltInKernel(double sampleRate)
+{
+    // Cached layout: counts, then the head taps, head spectra and tail spectra exactly as Kernel holds them
+    struct Counts { juce::int32 length, numHeadPartitions, numTailPartitions, reserved; };
+    const auto headBytes = sizeof(float) * (size_t)headSize;
+    auto spectraBytes = [](int numPartitions, int partitionSize)
+    {
+        return sizeof(std::complex<float>) * (size_t)(numPartitions * (partitionSize + 1));
+    };
+
+    auto table = TableCache::getTable("reverb-hall-" + juce::String(juce::roundToInt(sampleRate)), 1, [&]
+    {
+        auto built = buildKernel(createBuiltInImpulse(sampleRate), sampleRate, "Built-in hall");
+        Counts counts{ built->length, built->numHeadPartitions, built->numTailPartitions, 0 };
+
+        juce::MemoryBlock block;
+        block.append(&counts, sizeof(counts));
+        block.append(built->headTaps.data(), headBytes);
+        block.append(built->headSpectra.data(), spectraBytes(built->numHeadPartitions, headSize));
+        block.append(built->tailSpectra.data(), spectraBytes(built->numTailPartitions, tailPartitionSize));
+        return block;
+    });
+
+    auto kernel = std::make_unique<Kernel>();
+    kernel->name = "Built-in hall";
+    kernel->sampleRate = sampleRate;
+
+    const auto& counts = *table->getAs<Counts>();
+    const auto headOffset = sizeof(Counts) + headBytes;
+    const auto tailOffset = headOffset + spectraBytes(counts.numHeadPartitions, headSize);
+    if (table->getSize() != tailOffset + spectraBytes(counts.numTailPartitions, tailPartitionSize)
+        || counts.numHeadPartitions < 0 || counts.numHeadPartitions > maxHeadPartitions || counts.numTailPartitions < 0)
+    {
+        jassertfalse; // The checksum passed, so the layout changed without a version bump
+        return buildKernel(createBuiltInImpulse(sampleRate), sampleRate, kernel->name);
+    }
+
+    kernel->length = counts.length;
+    kernel->numHeadPartitions = counts.numHeadPartitions;
+    kernel->numTailPartitions = counts.numTailPartitions;
+    kernel->taps = table->getAs<float>(sizeof(Counts));
+    kernel->headFilters = counts.numHeadPartitions > 0 ? table->getAs<std::complex<float>>(headOffset) : nullptr;
+    kernel->tailFilters = counts.numTailPartitions > 0 ? table->getAs<std::complex<float>>(tailOffset) : nullptr;
+    kernel->cachedTable = std::move(table);
+    return kernel;
+}
+
+//==============================================================================
+void ConvolutionReverb::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const TraceRecorder::ScopedEvent trace("ConvolutionReverb::process");
+
+    // A new IR is ready: swap it in between blocks. The tail thread deletes the old one once it
+    // has seen the reset below - and only one can be waiting for deletion at a time.
+    if (pendingKernel.load() != nullptr && retiredKernel.load() == nullptr)
+    {
+        auto* oldKernel = activeKernel;
+        activeKernel = pendingKernel.exchange(nullptr);
+        tailKernel.store(activeKernel);
+        resetState();
+        retiredKernel.store(oldKernel);
+    }
+
+    wetGain.setTargetValue(mix.load());
+    if (activeKernel == nullptr || (! wetGain.isSmoothing() && wetGain.getCurrentValue() <= 0.0f))
+    {
+        if (! isBypassed)
+            audioBypassed.store(true);
+        isBypassed = true; // Costs nothing while the mix is at zero
+        return;
+    }
+
+    if (isBypassed)
+    {
+        // Whatever is in the delay lines is from before the bypass
+        resetState();
+        isBypassed = false;
+        audioBypassed.store(false);
+    }
+
+    // Work in pieces that end on the 128-sample partition boundaries
+    auto* samples = buffer.getWritePointer(0, startSample);
+    for (int done = 0; done < numSamples;)
+    {
+        auto chunkSize = juce::jmin(numSamples - done, headSize - inputFill);
+        processChunk(samples + done, chunkSize);
+        done += chunkSize;
+    }
+
+    if (tailWasLate)
+    {
+        ++lateTailBlocks;
+        tailWasLate = false;
+    }
+
+    for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+        buffer.copyFrom(channel, startSample, buffer, 0, startSample, numSamples);
+}
+
+void ConvolutionReverb::resetState() noexcept
+{
+    std::fill(firHistory.begin(), firHistory.end(), 0.0f);
+    std::fill(blockInput.begin(), blockInput.end(), 0.0f);
+    std::fill(headFdl.begin(), headFdl.end(), std::complex<float>());
+    std::fill(partitionOutput.begin(), partitionOutput.end(), 0.0f);
+    inputFill = 0;
+    headFdlIndex = 0;
+    samplePosition = 0;
+
+    // The tail thread starts over when it sees the new generation
+    tailInputEnd.store(0);
+    tailGeneration.store(tailGeneration.load() + 1);
+}
+
+void ConvolutionReverb::processChunk(float* samples, int numSamples) noexcept
+{
+    float wet[headSize];
+
+    // --- Queue the dry input for each stage ---
+    auto* history = firHistory.data() + (headSize - 1); // Current chunk, after headSize - 1 past samples
+    std::copy_n(samples, numSamples, history);
+    std::copy_n(samples, numSamples, blockInput.data() + headSize + inputFill);
+    for (int i = 0; i < numSamples; ++i)
+        tailInputRing[(size_t)((samplePosition + i) & (tailRingSize - 1))] = samples[i];
+    tailInputEnd.store(samplePosition + numSamples); // Released after the samples are in the ring
+
+    // --- Taps 0-127: direct form, plus the FFT stage's output computed at the last boundary ---
+    const auto* taps = activeKernel->taps;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto* x = history + i;
+        auto sum = 0.0f;
+        for (int tap = 0; tap < headSize; ++tap)
+            sum += taps[tap] * x[-tap];
+        wet[i] = sum + partitionOutput[(size_t)(inputFill + i)];
+    }
+
+    // --- Taps 4096+: whatever the tail thread has delivered ---
+    if (activeKernel->numTailPartitions > 0 && tailServedGeneration.load() == tailGeneration.load())
+    {
+        auto available = tailOutputEnd.load();
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto position = samplePosition + i;
+            if (position < available)
+                wet[i] += tailOutputRing[(size_t)(position & (tailRingSize - 1))];
+            else
+                tailWasLate = true;
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] += wet[i] * wetGain.getNextValue();
+
+    // Keep the last headSize - 1 inputs for the next chunk's direct taps
+    std::copy(firHistory.begin() + numSamples, firHistory.begin() + numSamples + (headSize - 1), firHistory.begin());
+
+    inputFill += numSamples;
+    samplePosition += numSamples;
+    if (inputFill == headSize)
+    {
+        runHeadPartitionStep();
+        inputFill = 0;
+    }
+}
+
+void ConvolutionReverb::runHeadPartitionStep() noexcept
+{
+    const auto numPartitions = activeKernel->numHeadPartitions;
+    if (numPartitions > 0)
+    {
+        constexpr auto numBins = headSize + 1;
+
+        // Spectrum of the last two blocks (overlap-save), into the delay line
+        std::fill(headFftBuffer.begin(), headFftBuffer.end(), 0.0f);
+        std::copy(blockInput.begin(), blockInput.end(), headFftBuffer.begin());
+        headFft.performRealOnlyForwardTransform(headFftBuffer.data(), true);
+        auto* spectrum = asComplex(headFftBuffer);
+        std::copy_n(spectrum, numBins, headFdl.begin() + headFdlIndex * numBins);
+
+        // Each partition multiplies the input spectrum from that many blocks ago
+        std::fill(headAccumulator.begin(), headAccumulator.end(), std::complex<float>());
+        for (int partition = 0; partition < numPartitions; ++partition)
+        {
+            auto slot = (headFdlIndex - partition + numPartitions) % numPartitions;
+            const auto* input = headFdl.data() + slot * numBins;
+            const auto* filter = activeKernel->headFilters + partition * numBins;
+            for (int bin = 0; bin < numBins; ++bin)
+                headAccumulator[(size_t)bin] += input[bin] * filter[bin];
+        }
+
+        std::fill(headFftBuffer.begin(), headFftBuffer.end(), 0.0f);
+        std::copy(headAccumulator.begin(), headAccumulator.end(), spectrum);
+        headFft.performRealOnlyInverseTransform(headFftBuffer.data());
+
+        // The second half is the valid (non-wrapped) part: output for the next headSize samples
+        std::copy_n(headFftBuffer.begin() + headSize, headSize, partitionOutput.begin());
+        headFdlIndex = (headFdlIndex + 1) % numPartitions;
+    }
+
+    std::copy(blockInput.begin() + headSize, blockInput.end(), blockInput.begin());
+}
+
+//==============================================================================
+void ConvolutionReverb::run()
+{
+    while (! threadShouldExit())
+    {
+        // Read before servicing, so the reset that retired it has been seen when it gets deleted
+        auto* retired = retiredKernel.load();
+
+        auto didWork = serviceTail();
+
+        if (retired != nullptr)
+        {
+            delete retired;
+            retiredKernel.store(nullptr);
+        }
+
+        if (didWork)
+            continue;
+
+        // Bypassed: sleep until setMix() or a new IR wakes us. Otherwise poll, since the audio
+        // thread can't signal; a 2048-sample partition is ~43ms at 48kHz, so 1ms leaves plenty of margin.
+        wait(hasNothingToServe() ? -1 : 1);
+    }
+}
+
+bool ConvolutionReverb::hasNothingToServe() const noexcept
+{
+    // A new IR waiting to be swapped in, or an old one waiting to be deleted
+    if (pendingKernel.load() != nullptr || retiredKernel.load() != nullptr)
+        return false;
+
+    // Only the audio thread changes the kernel, and only from pending, so this one can't be deleted under us
+    const auto* kernel = tailKernel.load();
+    if (kernel == nullptr || kernel->numTailPartitions == 0)
+        return true;
+
+    // Mix at zero and the fade-out finished. Raising the mix notifies before the audio thread can leave bypass.
+    return mix.load() <= 0.0f && audioBypassed.load();
+}
+
+bool ConvolutionReverb::serviceTail()
+{
+    constexpr auto blockSize = tailPartitionSize;
+    constexpr auto numBins = tailPartitionSize + 1;
+
+    // --- The audio thread reset (new IR, or coming out of bypass): start over ---
+    auto generation = tailGeneration.load();
+    if (generation != tailServedGeneration.load())
+    {
+        tailThreadKernel = tailKernel.load();
+        auto numPartitions = tailThreadKernel != nullptr ? tailThreadKernel->numTailPartitions : 0;
+        tailFdl.assign((size_t)(numPartitions * numBins), {});
+        std::fill(tailWindow.begin(), tailWindow.end(), 0.0f);
+        std::fill(tailOutputRing.begin(), tailOutputRing.end(), 0.0f);
+        tailFdlIndex = 0;
+        nextTailBlock = 0;
+        tailOutputEnd.store(tailStart); // Nothing from the tail is due before tap tailStart
+        tailServedGeneration.store(generation);
+    }
+
+    if (tailThreadKernel == nullptr || tailThreadKernel->numTailPartitions == 0)
+        return false;
+
+    const auto numPartitions = tailThreadKernel->numTailPartitions;
+    auto inputEnd = tailInputEnd.load();
+
+    // So far behind that the input has been overwritten: skip ahead and accept the gap
+    if (inputEnd - nextTailBlock * blockSize > tailRingSize - blockSize)
+    {
+        ++lateTailBlocks;
+        nextTailBlock = inputEnd / blockSize;
+        std::fill(tailFdl.begin(), tailFdl.end(), std::complex<float>());
+        std::fill(tailWindow.begin(), tailWindow.end(), 0.0f);
+        std::fill(tailOutputRing.begin(), tailOutputRing.end(), 0.0f);
+        tailOutputEnd.store(nextTailBlock * blockSize + tailStart);
+    }
+
+    bool didWork = false;
+    while ((nextTailBlock + 1) * blockSize <= inputEnd && ! threadShouldExit())
+    {
+        auto blockStart = nextTailBlock * blockSize;
+
+        // Slide the overlap-save window along by one block
+        std::copy(tailWindow.begin() + blockSize, tailWindow.end(), tailWindow.begin());
+        for (int i = 0; i < blockSize; ++i)
+            tailWindow[(size_t)(blockSize + i)] = tailInputRing[(size_t)((blockStart + i) & (tailRingSize - 1))];
+
+        std::fill(tailFftBuffer.begin(), tailFftBuffer.end(), 0.0f);
+        std::copy(tailWindow.begin(), tailWindow.end(), tailFftBuffer.begin());
+        tailFft.performRealOnlyForwardTransform(tailFftBuffer.data(), true);
+        auto* spectrum = asComplex(tailFftBuffer);
+        std::copy_n(spectrum, numBins, tailFdl.begin() + tailFdlIndex * numBins);
+
+        std::fill(tailAccumulator.begin(), tailAccumulator.end(), std::complex<float>());
+        for (int partition = 0; partition < numPartitions; ++partition)
+        {
+            auto slot = (tailFdlIndex - partition + numPartitions) % numPartitions;
+            const auto* input = tailFdl.data() + slot * numBins;
+            const auto* filter = tailThreadKernel->tailFilters + partition * numBins;
+            for (int bin = 0; bin < numBins; ++bin)
+                tailAccumulator[(size_t)bin] += input[bin] * filter[bin];
+        }
+
+        std::fill(tailFftBuffer.begin(), tailFftBuffer.end(), 0.0f);
+        std::copy(tailAccumulator.begin(), tailAccumulator.end(), spectrum);
+        tailFft.performRealOnlyInverseTransform(tailFftBuffer.data());
+
+        // This input block's tail contribution starts tailStart samples after the block did
+        for (int i = 0; i < blockSize; ++i)
+            tailOutputRing[(size_t)((blockStart + tailStart + i) & (tailRingSize - 1))] = tailFftBuffer[(size_t)(blockSize + i)];
+        tailOutputEnd.store(blockStart + tailStart + blockSize);
+
+        tailFdlIndex = (tailFdlIndex + 1) % numPartitions;
+        ++nextTailBlock;
+        didWork = true;
+    }
+
+    return didWork;
+}
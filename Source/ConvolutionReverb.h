@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h> // For dsp::FFT
+#include <atomic>
+#include <complex>
+#include <vector>
+#include "TableCache.h"
+
+//==============================================================================
+/*
+    Zero-latency convolution reverb for the master bus.
+
+    The impulse response is split into three non-uniform stages so a long IR
+    costs a small, constant amount per block on the audio thread:
+
+      taps [0, 128)       direct-form FIR, sample by sample - this is what makes
+                          the reverb latency-free
+      taps [128, 4096)    uniformly partitioned FFT convolution (overlap-save)
+                          with 128-sample partitions, run on the audio thread
+                          every 128 samples
+      taps [4096, end)    2048-sample partitions, convolved on a background
+                          thread. A finished input block isn't needed at the
+                          output until 2048 samples later, which is the time
+                          the thread has to deliver it.
+
+    The synth's master is mono (one channel copied to the others), so the
+    reverb convolves channel 0 and writes the result to every channel. The wet
+    signal is added on top of the dry one, like a send.
+
+    IRs are loaded, resampled and transformed on a worker thread and swapped in
+    by the audio thread between blocks; the old one is deleted by the tail
+    thread once it has stopped using it. The built-in hall is the same for a
+    given sample rate, so its transformed partitions are kept in TableCache
+    and later starts at that rate map them instead of building them.
+*/
+class ConvolutionReverb : private juce::Thread
+{
+public:
+    static constexpr int headSize = 128;             // Direct taps, and the first stage's partition size
+    static constexpr int tailStart = 4096;           // First tap handled by the background thread
+    static constexpr int tailPartitionSize = 2048;
+    static constexpr double maxImpulseSeconds = 10.0;
+
+    ConvolutionReverb();
+    ~ConvolutionReverb() override;
+
+    // Called from prepareToPlay, while the audio callback isn't running. Rebuilds the
+    // current IR in the background if the sample rate changed.
+    void prepare(double sampleRate);
+
+    // --- Message thread ---
+    // Starts building the current IR for the rate the device will probably open at, so the build
+    // overlaps with opening the device. prepare() with the same rate then has nothing left to do.
+    void prebuild(double expectedSampleRate);
+    void loadImpulseResponseAsync(const juce::File& file);
+    void useBuiltInImpulseResponse(); // Synthetic ~2.5s hall, the default
+    void setMix(float wetLevel);      // 0 bypasses the reverb entirely
+    bool isLoading() const noexcept { return numLoadsQueued.load() > 0; }
+    juce::String getStatusText() const;
+    int getNumLateTailBlocks() const noexcept { return lateTailBlocks.load(); }
+
+    // --- Audio thread ---
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    // An impulse response cut up and transformed for the three stages. Immutable once built.
+    struct Kernel
+    {
+        juce::String name;
+        double sampleRate = 0.0;
+        int length = 0;                                     // Taps after trimming the silent end
+        std::vector<float> headTaps;                        // h[0, headSize)
+        int numHeadPartitions = 0;
+        std::vector<std::complex<float>> headSpectra;       // [partition][headSize + 1]
+        int numTailPartitions = 0;
+        std::vector<std::complex<float>> tailSpectra;       // [partition][tailPartitionSize + 1]
+        std::shared_ptr<const TableCache::Table> cachedTable; // Holds the three instead of the vectors, if cached
+
+        // What the stages read: the vectors above, or the same layout in cachedTable
+        const float* taps = nullptr;
+        const std::complex<float>* headFilters = nullptr;
+        const std::complex<float>* tailFilters = nullptr;
+    };
+
+    static constexpr int maxHeadPartitions = (tailStart - headSize) / headSize;
+    static constexpr int tailRingSize = 8192; // Power of two, > tailStart + tailPartitionSize
+
+    static std::unique_ptr<Kernel> buildKernel(std::vector<float> impulse, double sampleRate, const juce::String& name);
+    static std::unique_ptr<Kernel> loadBuiltInKernel(double sampleRate); // From TableCache, built on a miss
+    static std::vector<float> readImpulse(const juce::File& file, double sampleRate, juce::String& errorMessage);
+    static std::vector<float> createBuiltInImpulse(double sampleRate);
+    void startKernelBuild(const juce::File& file); // Empty file = built-in IR
+
+    // Audio thread
+    void resetState() noexcept;
+    void processChunk(float* samples, int numSamples) noexcept; // numSamples <= headSize - inputFill
+    void runHeadPartitionStep() noexcept;
+
+    // Tail thread
+    void run() override;
+    bool serviceTail();
+    bool hasNothingToServe() const noexcept; // True while bypassed: the thread then sleeps until notify()
+
+    // --- Audio thread state ---
+    Kernel* activeKernel = nullptr;
+    juce::dsp::FFT headFft{ 8 };                   // 2 * headSize
+    std::vector<float> firHistory;                 // headSize - 1 past samples, then the current chunk
+    std::vector<float> blockInput;                 // [previous block | current block], 2 * headSize
+    std::vector<float> headFftBuffer;              // 4 * headSize, as the real-only FFT wants
+    std::vector<std::complex<float>> headFdl;      // Frequency-domain delay line of input spectra
+    std::vector<std::complex<float>> headAccumulator;
+    std::vector<float> partitionOutput;            // FFT-stage output for the current block
+    int inputFill = 0;
+    int headFdlIndex = 0;
+    juce::int64 samplePosition = 0;                // Samples processed since the last reset
+    juce::SmoothedValue<float> wetGain;
+    bool isBypassed = true;
+    bool tailWasLate = false;
+
+    // --- Shared with the tail thread ---
+    std::vector<float> tailInputRing, tailOutputRing;         // Indexed by samplePosition & (tailRingSize - 1)
+    std::atomic<juce::int64> tailInputEnd{ 0 };               // Audio thread has written input up to here
+    std::atomic<juce::int64> tailOutputEnd{ 0 };              // Tail thread has written output up to here
+    std::atomic<juce::uint32> tailGeneration{ 0 };            // Bumped by resetState
+    std::atomic<juce::uint32> tailServedGeneration{ 0 };
+    std::atomic<Kernel*> tailKernel{ nullptr };
+    std::atomic<int> lateTailBlocks{ 0 };
+    std::atomic<bool> audioBypassed{ true };                  // The audio thread's isBypassed, for the tail thread
+
+    // --- Tail thread state ---
+    Kernel* tailThreadKernel = nullptr;
+    juce::dsp::FFT tailFft{ 12 };                  // 2 * tailPartitionSize
+    std::vector<float> tailFftBuffer;
+    std::vector<float> tailWindow;                 // [previous block | current block]
+    std::vector<std::complex<float>> tailFdl, tailAccumulator;
+    int tailFdlIndex = 0;
+    juce::int64 nextTailBlock = 0;
+
+    // --- Kernel hand-over: loader -> pending -> (audio thread) active -> retired -> deleted by run() ---
+    std::atomic<Kernel*> pendingKernel{ nullptr };
+    std::atomic<Kernel*> retiredKernel{ nullptr };
+    juce::ThreadPool loaderPool{ 1 };
+    std::atomic<int> numLoadsQueued{ 0 };
+    std::atomic<double> preparedSampleRate{ 0.0 };
+    std::atomic<float> mix{ 0.0f };
+
+    juce::CriticalSection statusLock; // Loader, message and prepare callers
+    juce::String statusText{ "Reverb off" };
+    juce::File currentSource;         // Rebuilt from this when the sample rate changes (empty = built-in)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
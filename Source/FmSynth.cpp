@@ -0,0 +1,310 @@
+#include "FmSynth.h"
+#include <cmath>
+
+namespace
+{
+    constexpr juce::uint8 op(int index) { return (juce::uint8)(1 << index); }
+
+    // Modulator output of 1.0 moves the carrier's phase by this many cycles (~4.4 rad)
+    constexpr float modulationDepthCycles = 0.7f;
+    constexpr float feedbackDepthCycles = 0.25f;
+
+    volatile float benchmarkSink = 0.0f;
+
+    // sin(2 pi x) for any x: wrap to [-0.5, 0.5), parabola, one refinement step (error ~1e-3).
+    // No branches or table lookups, so loops over it vectorise.
+    inline float sinCycles(float x) noexcept
+    {
+        x -= std::floor(x + 0.5f);
+        auto y = 8.0f * x - 16.0f * x * std::abs(x);
+        return 0.225f * (y * std::abs(y) - y) + y;
+    }
+
+    //  ratio, level, attack, decay, sustain, release
+    const FmSynth::Patch patches[FmSynth::numAlgorithms] =
+    {
+        { "Stack: Brass",
+          { op(1), op(2), op(3), op(4), op(5), 0 }, op(0), 5, 0.4f,
+          { { 1.0f, 1.0f,  0.05f,  0.3f, 0.8f, 0.3f },
+            { 1.0f, 0.7f,  0.08f,  0.4f, 0.6f, 0.3f },
+            { 1.0f, 0.4f,  0.1f,   0.5f, 0.5f, 0.3f },
+            { 2.0f, 0.25f, 0.1f,   0.5f, 0.4f, 0.3f },
+            { 1.0f, 0.2f,  0.1f,   0.5f, 0.4f, 0.3f },
+            { 1.0f, 0.2f,  0.1f,   0.5f, 0.4f, 0.3f } } },
+
+        { "Two Stacks: E.Piano",
+          { op(1), op(2), 0, op(4), op(5), 0 }, op(0) | op(3), 5, 0.2f,
+          { { 1.0f,  0.6f,  0.001f, 1.5f, 0.3f, 0.4f },
+            { 1.0f,  0.35f, 0.001f, 1.0f, 0.2f, 0.4f },
+            { 1.0f,  0.2f,  0.001f, 0.8f, 0.1f, 0.4f },
+            { 1.0f,  0.5f,  0.001f, 2.0f, 0.2f, 0.5f },
+            { 14.0f, 0.25f, 0.001f, 0.3f, 0.0f, 0.2f },
+            { 1.0f,  0.1f,  0.001f, 0.5f, 0.0f, 0.2f } } },
+
+        { "Three Pairs: Bells",
+          { op(1), 0, op(3), 0, op(5), 0 }, op(0) | op(2) | op(4), -1, 0.0f,
+          { { 1.0f, 0.6f, 0.001f, 3.0f, 0.0f, 1.5f },
+            { 3.5f, 0.5f, 0.001f, 2.0f, 0.0f, 1.0f },
+            { 2.0f, 0.4f, 0.001f, 2.5f, 0.0f, 1.5f },
+            { 5.0f, 0.4f, 0.001f, 1.5f, 0.0f, 1.0f },
+            { 3.0f, 0.3f, 0.001f, 2.0f, 0.0f, 1.5f },
+            { 7.0f, 0.3f, 0.001f, 1.0f, 0.0f, 1.0f } } },
+
+        { "Three Into One: Bass",
+          { op(1) | op(2) | op(3), 0, 0, 0, op(5), 0 }, op(0) | op(4), 1, 0.3f,
+          { { 1.0f, 1.0f,  0.001f, 0.4f,  0.7f, 0.15f },
+            { 1.0f, 0.5f,  0.001f, 0.25f, 0.2f, 0.1f },
+            { 2.0f, 0.3f,  0.001f, 0.2f,  0.1f, 0.1f },
+            { 3.0f, 0.15f, 0.001f, 0.15f, 0.0f, 0.1f },
+            { 0.5f, 0.4f,  0.001f, 0.5f,  0.6f, 0.15f },
+            { 0.5f, 0.3f,  0.001f, 0.3f,  0.2f, 0.1f } } },
+
+        { "Stack + Pair: Lead",
+          { op(1), op(2), op(3), 0, op(5), 0 }, op(0) | op(4), 3, 0.5f,
+          { { 1.0f,   1.0f, 0.01f, 0.2f, 0.9f, 0.2f },
+            { 1.0f,   0.6f, 0.01f, 0.3f, 0.7f, 0.2f },
+            { 2.0f,   0.4f, 0.01f, 0.3f, 0.5f, 0.2f },
+            { 1.0f,   0.3f, 0.01f, 0.3f, 0.5f, 0.2f },
+            { 1.005f, 0.5f, 0.01f, 0.2f, 0.9f, 0.2f },
+            { 1.0f,   0.4f, 0.01f, 0.3f, 0.6f, 0.2f } } },
+
+        { "One Into Three: Pad",
+          { op(3), op(3), op(3), op(4), op(5), 0 }, op(0) | op(1) | op(2), -1, 0.0f,
+          { { 1.0f,   0.6f,  0.8f, 1.0f, 0.8f, 1.5f },
+            { 1.003f, 0.6f,  0.9f, 1.0f, 0.8f, 1.5f },
+            { 2.0f,   0.4f,  1.0f, 1.0f, 0.7f, 1.5f },
+            { 1.0f,   0.35f, 1.5f, 2.0f, 0.5f, 1.5f },
+            { 3.0f,   0.2f,  2.0f, 2.0f, 0.4f, 1.5f },
+            { 0.5f,   0.15f, 2.0f, 2.0f, 0.4f, 1.5f } } },
+
+        { "4-Op Stack: Pluck",
+          { op(1), op(2), op(3), 0, 0, 0 }, op(0), 3, 0.3f,
+          { { 1.0f, 1.0f, 0.001f, 0.6f,  0.0f, 0.3f },
+            { 1.0f, 0.6f, 0.001f, 0.3f,  0.0f, 0.2f },
+            { 3.0f, 0.3f, 0.001f, 0.15f, 0.0f, 0.1f },
+            { 1.0f, 0.2f, 0.001f, 0.1f,  0.0f, 0.1f },
+            {},
+            {} } },
+
+        { "Six Carriers: Organ",
+          { 0, 0, 0, 0, 0, 0 }, 0x3f, -1, 0.0f,
+          { { 0.5f, 0.6f, 0.005f, 0.1f, 1.0f, 0.05f },
+            { 1.0f, 0.8f, 0.005f, 0.1f, 1.0f, 0.05f },
+            { 2.0f, 0.5f, 0.005f, 0.1f, 1.0f, 0.05f },
+            { 3.0f, 0.4f, 0.005f, 0.1f, 1.0f, 0.05f },
+            { 4.0f, 0.3f, 0.005f, 0.1f, 1.0f, 0.05f },
+            { 6.0f, 0.2f, 0.005f, 0.1f, 1.0f, 0.05f } } },
+    };
+}
+
+//==============================================================================
+const FmSynth::Patch& FmSynth::getPatch(int index) noexcept
+{
+    return patches[juce::jlimit(0, numAlgorithms - 1, index)];
+}
+
+void FmSynth::prepare(double sampleRate, int maximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    operatorOutputs.setSize(numOperators, maxBlockSize);
+    scratch.setSize(2, maxBlockSize);
+}
+
+void FmSynth::noteOn(VoiceState& voice) const noexcept
+{
+    // Retriggers start from the current level, so a fast repeat doesn't click
+    for (auto& envelope : voice.envelopes)
+        envelope.stage = Envelope::attack;
+}
+
+void FmSynth::noteOff(VoiceState& voice) const noexcept
+{
+    for (auto& envelope : voice.envelopes)
+        if (envelope.stage != Envelope::idle)
+            envelope.stage = Envelope::release;
+}
+
+//==============================================================================
+float FmSynth::advanceEnvelope(Envelope& envelope, const OperatorSettings& settings, int numSamples) const noexcept
+{
+    // Linear segments, evaluated once per block; a segment ending mid-block hands the rest on
+    auto remaining = (float)numSamples;
+    auto samplesFor = [this](float seconds) { return juce::jmax(1.0f, seconds * (float)currentSampleRate); };
+
+    while (remaining > 0.0f)
+    {
+        switch (envelope.stage)
+        {
+        case Envelope::attack:
+        {
+            auto rate = 1.0f / samplesFor(settings.attack);
+            auto needed = (1.0f - envelope.level) / rate;
+            if (needed > remaining) { envelope.level += rate * remaining; remaining = 0.0f; }
+            else { envelope.level = 1.0f; remaining -= needed; envelope.stage = Envelope::decay; }
+            break;
+        }
+        case Envelope::decay:
+        {
+            auto rate = (1.0f - settings.sustain) / samplesFor(settings.decay);
+            auto needed = rate > 0.0f ? (envelope.level - settings.sustain) / rate : 0.0f;
+            if (needed > remaining) { envelope.level -= rate * remaining; remaining = 0.0f; }
+            else { envelope.level = settings.sustain; remaining -= juce::jmax(0.0f, needed); envelope.stage = Envelope::sustain; }
+            break;
+        }
+        case Envelope::sustain:
+            envelope.level = settings.sustain;
+            remaining = 0.0f;
+            break;
+        case Envelope::release:
+        {
+            auto rate = 1.0f / samplesFor(settings.release);
+            auto needed = envelope.level / rate;
+            if (needed > remaining) { envelope.level -= rate * remaining; }
+            else { envelope.level = 0.0f; envelope.stage = Envelope::idle; }
+            remaining = 0.0f;
+            break;
+        }
+        case Envelope::idle:
+        default:
+            envelope.level = 0.0f;
+            remaining = 0.0f;
+            break;
+        }
+    }
+
+    return envelope.level;
+}
+
+void FmSynth::render(VoiceState& voice, const Patch& patch, double frequency, float* output, int numSamples) noexcept
+{
+    jassert(numSamples <= maxBlockSize);
+    auto* phaseBuffer = scratch.getWritePointer(0);
+    auto* envelopeRamp = scratch.getWritePointer(1);
+    int renderedOperators = 0; // Bit per operator holding valid output this block
+
+    // Modulators have higher indices than what they modulate, so count down
+    for (int opIndex = numOperators - 1; opIndex >= 0; --opIndex)
+    {
+        const auto& settings = patch.operators[opIndex];
+        auto& envelope = voice.envelopes[(size_t)opIndex];
+        auto& phase = voice.phase[(size_t)opIndex];
+        auto phaseDelta = settings.ratio * frequency / currentSampleRate;
+
+        auto startLevel = envelope.level;
+        auto endLevel = advanceEnvelope(envelope, settings, numSamples);
+
+        // Unused or finished operators keep their phase running but cost nothing else
+        if (settings.level <= 0.0f || (startLevel <= 0.0f && endLevel <= 0.0f))
+        {
+            phase = std::fmod(phase + phaseDelta * numSamples, 1.0);
+            continue;
+        }
+
+        auto* out = operatorOutputs.getWritePointer(opIndex);
+
+        // Phase ramp plus every rendered modulator, scaled to cycles
+        auto basePhase = (float)phase;
+        auto delta = (float)phaseDelta;
+        for (int i = 0; i < numSamples; ++i)
+            phaseBuffer[i] = basePhase + delta * (float)i;
+
+        for (int modulator = opIndex + 1; modulator < numOperators; ++modulator)
+            if ((patch.modulators[opIndex] & op(modulator)) != 0 && (renderedOperators & op(modulator)) != 0)
+                juce::FloatVectorOperations::addWithMultiply(phaseBuffer, operatorOutputs.getReadPointer(modulator), modulationDepthCycles, numSamples);
+
+        // Envelope ramp, including the operator level
+        auto rampStart = startLevel * settings.level;
+        auto rampStep = (endLevel - startLevel) * settings.level / (float)numSamples;
+        for (int i = 0; i < numSamples; ++i)
+            envelopeRamp[i] = rampStart + rampStep * (float)(i + 1);
+
+        if (opIndex == patch.feedbackOperator && patch.feedback > 0.0f)
+        {
+            // Feedback needs the previous output sample - the only per-sample dependency
+            auto depth = patch.feedback * feedbackDepthCycles;
+            auto history0 = voice.feedbackHistory[0], history1 = voice.feedbackHistory[1];
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto sample = sinCycles(phaseBuffer[i] + depth * 0.5f * (history0 + history1)) * envelopeRamp[i];
+                history1 = history0;
+                history0 = sample;
+                out[i] = sample;
+            }
+            voice.feedbackHistory[0] = history0;
+            voice.feedbackHistory[1] = history1;
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = sinCycles(phaseBuffer[i]);
+            juce::FloatVectorOperations::multiply(out, envelopeRamp, numSamples);
+        }
+
+        phase = std::fmod(phase + phaseDelta * numSamples, 1.0);
+        renderedOperators |= op(opIndex);
+    }
+
+    // Sum the carriers; more carriers means a lower gain each, so patches sit at similar levels
+    juce::FloatVectorOperations::clear(output, numSamples);
+    int numCarriers = 0;
+    for (int opIndex = 0; opIndex < numOperators; ++opIndex)
+    {
+        if ((patch.carriers & op(opIndex)) == 0)
+            continue;
+        ++numCarriers;
+        if ((renderedOperators & op(opIndex)) != 0)
+            juce::FloatVectorOperations::add(output, operatorOutputs.getReadPointer(opIndex), numSamples);
+    }
+
+    if (numCarriers > 1)
+        juce::FloatVectorOperations::multiply(output, 1.0f / std::sqrt((float)numCarriers), numSamples);
+}
+
+//==============================================================================
+void FmSynth::runBenchmark(double sampleRate, int blockSize)
+{
+    constexpr int numVoices = 64;
+    constexpr double secondsOfAudio = 10.0;
+    const auto numBlocks = (int)(secondsOfAudio * sampleRate / blockSize);
+    const auto blockDeadlineMs = blockSize * 1000.0 / sampleRate;
+
+    FmSynth synth;
+    synth.prepare(sampleRate, blockSize);
+    std::vector<VoiceState> voices((size_t)numVoices);
+    std::vector<float> output((size_t)blockSize);
+
+    juce::Logger::writeToLog("FM benchmark: " + juce::String(numVoices) + " voices, " + juce::String(secondsOfAudio, 0)
+                             + " s at " + juce::String(sampleRate, 0) + " Hz, block " + juce::String(blockSize));
+
+    for (int patchIndex = 0; patchIndex < numAlgorithms; ++patchIndex)
+    {
+        const auto& patch = getPatch(patchIndex);
+        for (auto& voice : voices)
+        {
+            voice = {};
+            synth.noteOn(voice);
+        }
+
+        auto checksum = 0.0f; // Keeps the optimiser from dropping the work
+        auto startMs = juce::Time::getMillisecondCounterHiRes();
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int v = 0; v < numVoices; ++v)
+            {
+                synth.render(voices[(size_t)v], patch, juce::MidiMessage::getMidiNoteInHertz(36 + v % 48), output.data(), blockSize);
+                checksum += output[0];
+            }
+        }
+        auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+        auto nsPerVoiceSample = elapsedMs * 1.0e6 / ((double)numBlocks * blockSize * numVoices);
+        auto voiceBlockMs = elapsedMs / ((double)numBlocks * numVoices);
+        auto voicesAtHalfLoad = (int)(0.5 * blockDeadlineMs / voiceBlockMs);
+
+        juce::Logger::writeToLog("  " + juce::String(patch.name).paddedRight(' ', 24)
+                                 + juce::String(nsPerVoiceSample, 1) + " ns/voice-sample, ~"
+                                 + juce::String(voicesAtHalfLoad) + " voices in 50% of the block deadline");
+        benchmarkSink = checksum;
+    }
+}
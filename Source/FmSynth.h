@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/*
+    Six-operator FM (phase modulation) voice renderer, used by SynthEngine's FM
+    voice type.
+
+    An algorithm says which operators modulate which (a modulator always has a
+    higher index than what it modulates, so rendering from operator 5 down to 0
+    is a valid order) and which operators are carriers that reach the output.
+    Each algorithm comes with a preset patch: frequency ratios, levels,
+    per-operator envelopes and one self-feedback operator.
+
+    Rendering is block-wise, one operator at a time into its own buffer:
+    phase ramp + summed modulator buffers -> branch-free sine approximation ->
+    envelope ramp. Those loops have no loop-carried dependencies, so the
+    compiler vectorises them. Only an operator with feedback needs its previous
+    output sample, and only that one runs a per-sample loop. Envelopes advance
+    once per block and are ramped linearly across it.
+
+    VoiceState is per voice; the FmSynth object holds only shared scratch
+    buffers (voices render one at a time) and is set up in prepare().
+*/
+class FmSynth
+{
+public:
+    static constexpr int numOperators = 6;
+    static constexpr int numAlgorithms = 8;
+
+    struct OperatorSettings
+    {
+        float ratio = 1.0f;   // Of the note frequency
+        float level = 0.0f;   // Carrier: output gain. Modulator: depth (1 = ~4.4 rad). 0 = unused.
+        float attack = 0.01f, decay = 0.3f, sustain = 1.0f, release = 0.3f; // Seconds / level
+    };
+
+    struct Patch
+    {
+        const char* name = "";
+        juce::uint8 modulators[numOperators]{}; // Bit m set in modulators[op]: operator m modulates op
+        juce::uint8 carriers = 1;               // Bit op set: op is heard
+        int   feedbackOperator = -1;
+        float feedback = 0.0f;                  // Modulation depth of its own output, 0-1
+        OperatorSettings operators[numOperators];
+    };
+
+    struct Envelope
+    {
+        enum Stage { idle, attack, decay, sustain, release };
+        Stage stage = idle;
+        float level = 0.0f;
+    };
+
+    struct VoiceState
+    {
+        std::array<double, numOperators> phase{};      // Cycles, 0-1
+        std::array<Envelope, numOperators> envelopes{};
+        float feedbackHistory[2]{};                    // Last two outputs of the feedback operator
+    };
+
+    // Preset patch (and algorithm) by index, 0 to numAlgorithms - 1
+    static const Patch& getPatch(int index) noexcept;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    // --- Audio thread ---
+    void noteOn(VoiceState& voice) const noexcept;
+    void noteOff(VoiceState& voice) const noexcept;
+    // Writes (not adds) numSamples (<= the prepared block size) of the voice's output
+    void render(VoiceState& voice, const Patch& patch, double frequency, float* output, int numSamples) noexcept;
+
+    // Renders many voices headlessly and logs throughput and the polyphony that fits a
+    // real-time budget (see --benchmark-fm in Main.cpp)
+    static void runBenchmark(double sampleRate = 48000.0, int blockSize = 256);
+
+private:
+    float advanceEnvelope(Envelope& envelope, const OperatorSettings& settings, int numSamples) const noexcept;
+
+    double currentSampleRate = 44100.0;
+    int maxBlockSize = 0;
+    juce::AudioBuffer<float> operatorOutputs; // One channel per operator
+    juce::AudioBuffer<float> scratch;         // 0: phase/modulation, 1: envelope ramp
+};
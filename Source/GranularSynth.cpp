@@ -0,0 +1,266 @@
+#include "GranularSynth.h"
+#include <cmath>
+
+namespace
+{
+    const GranularSynth::Preset presets[GranularSynth::numPresets] =
+    {
+        //  name            source                       window                          ms      jit.   Hz       jit.  scan   spread  pitch  delay
+        { "Cloud",        GranularSynth::sampleSource, GranularSynth::hannWindow,      80.0f,  0.3f,  200.0f,  0.5f, 0.25f, 40.0f,  0.1f,  0.0f   },
+        { "Dense Swarm",  GranularSynth::sampleSource, GranularSynth::gaussianWindow,  30.0f,  0.5f,  2000.0f, 0.8f, 1.0f,  10.0f,  0.3f,  0.0f   },
+        { "Frozen",       GranularSynth::sampleSource, GranularSynth::hannWindow,      120.0f, 0.2f,  60.0f,   0.3f, 0.0f,  80.0f,  0.0f,  0.0f   },
+        { "Live Shimmer", GranularSynth::liveSource,   GranularSynth::gaussianWindow,  60.0f,  0.3f,  400.0f,  0.5f, 0.0f,  200.0f, 0.05f, 50.0f  },
+        { "Live Stutter", GranularSynth::liveSource,   GranularSynth::expodecWindow,   40.0f,  0.0f,  25.0f,   0.0f, 0.0f,  0.0f,   0.0f,  100.0f },
+    };
+
+    constexpr double liveRootHz = 261.625565; // Middle C plays the live source at its own pitch
+}
+
+//==============================================================================
+GranularSynth::GranularSynth()
+{
+    // The key names every constant the tables are built from
+    const auto tableBytes = sizeof(float) * (size_t)(numWindowShapes * (windowTableSize + 1));
+    const auto key = "granular-windows-" + juce::String(numWindowShapes) + "x" + juce::String(windowTableSize);
+
+    windowTables = TableCache::getTable(key, 1, [tableBytes]
+    {
+        constexpr int stride = windowTableSize + 1;
+        juce::MemoryBlock block(tableBytes, true);
+        auto* tables = static_cast<float*>(block.getData());
+        const auto gaussianEdge = std::exp(-0.5 * (0.5 / 0.15) * (0.5 / 0.15));
+
+        for (int i = 0; i <= windowTableSize; ++i)
+        {
+            auto x = (double)i / windowTableSize;
+            auto decayPart = (x - 0.02) / 0.98;
+            auto gaussian = std::exp(-0.5 * ((x - 0.5) / 0.15) * ((x - 0.5) / 0.15));
+
+            tables[hannWindow * stride + i]      = (float)(0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * x));
+            tables[gaussianWindow * stride + i]  = (float)((gaussian - gaussianEdge) / (1.0 - gaussianEdge));
+            tables[trapezoidWindow * stride + i] = (float)juce::jmin(1.0, x / 0.2, (1.0 - x) / 0.2);
+            tables[expodecWindow * stride + i]   = (float)(x < 0.02 ? x / 0.02 : std::exp(-4.0 * decayPart) * (1.0 - decayPart));
+        }
+
+        return block;
+    }, tableBytes);
+
+    currentWindow = getWindowTable(hannWindow);
+}
+
+const float* GranularSynth::getWindowTable(int shape) const noexcept
+{
+    return windowTables->getAs<float>() + shape * (windowTableSize + 1);
+}
+
+const GranularSynth::Preset& GranularSynth::getPreset(int index) noexcept
+{
+    return presets[juce::jlimit(0, numPresets - 1, index)];
+}
+
+void GranularSynth::prepare(double sampleRate, int maximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+    scratch.setSize(2, juce::jmax(1, maximumBlockSize));
+    liveBuffer.assign((size_t)liveBufferSize, 0.0f);
+    liveWritePosition = 0;
+}
+
+void GranularSynth::noteOn(VoiceState& voice, bool freshVoice) const noexcept
+{
+    if (freshVoice)
+    {
+        // Whole pool free again
+        voice.numActive = 0;
+        voice.numFree = maxGrainsPerVoice;
+        for (int i = 0; i < maxGrainsPerVoice; ++i)
+            voice.freeGrains[(size_t)i] = (juce::uint8)(maxGrainsPerVoice - 1 - i);
+    }
+    // A retrigger lets the grains already playing finish their windows
+
+    voice.samplesToNextGrain = 0.0; // First grain on the note's first sample
+    voice.scanPosition = 0.0;
+}
+
+void GranularSynth::captureLive(const float* samples, int numSamples) noexcept
+{
+    if (liveBuffer.empty())
+        return;
+
+    auto writeIndex = (int)(liveWritePosition & (liveBufferSize - 1));
+    auto firstPart = juce::jmin(numSamples, liveBufferSize - writeIndex);
+    std::copy(samples, samples + firstPart, liveBuffer.begin() + writeIndex);
+    std::copy(samples + firstPart, samples + numSamples, liveBuffer.begin());
+    liveWritePosition += numSamples;
+}
+
+//==============================================================================
+void GranularSynth::render(VoiceState& voice, const Preset& preset, const SampleLibrary::Zone* zone,
+                           double frequency, float* output, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::clear(output, numSamples);
+
+    SourceView source;
+    double rootHz = liveRootHz, sourceRateRatio = 1.0;
+    if (preset.source == liveSource)
+    {
+        source = { liveBuffer.data(), liveBufferSize, true };
+    }
+    else
+    {
+        if (zone == nullptr || zone->headLength <= 0)
+            return; // No library loaded, or a gap in it
+        source = { zone->head.getReadPointer(0), zone->headLength, false };
+        rootHz = juce::MidiMessage::getMidiNoteInHertz(zone->rootNote);
+        sourceRateRatio = zone->sampleRate / currentSampleRate;
+    }
+
+    currentWindow = getWindowTable(preset.window);
+    auto baseIncrement = frequency / rootHz * sourceRateRatio;
+
+    // 1. Schedule this block's grains at their exact onset samples
+    auto interval = currentSampleRate / preset.densityHz;
+    while (voice.samplesToNextGrain < numSamples)
+    {
+        spawnGrain(voice, preset, source, (int)voice.samplesToNextGrain, baseIncrement, numSamples);
+        auto jitter = preset.densityJitter * (voice.random.nextFloat() * 2.0f - 1.0f);
+        voice.samplesToNextGrain += juce::jmax(1.0, interval * (1.0 + jitter));
+    }
+    voice.samplesToNextGrain -= numSamples;
+
+    // 2. Sum every active grain; finished ones go back to the free list
+    for (int i = 0; i < voice.numActive;)
+    {
+        auto index = voice.activeGrains[(size_t)i];
+        if (renderGrain(voice.grains[index], source, output, numSamples))
+        {
+            voice.activeGrains[(size_t)i] = voice.activeGrains[(size_t)--voice.numActive];
+            voice.freeGrains[(size_t)voice.numFree++] = index;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // 3. Move the read position through the sample
+    if (! source.isRing && preset.scanRate != 0.0f)
+        voice.scanPosition = std::fmod(voice.scanPosition + preset.scanRate * sourceRateRatio * numSamples, (double)source.length);
+}
+
+void GranularSynth::spawnGrain(VoiceState& voice, const Preset& preset, const SourceView& source,
+                               int onset, double baseIncrement, int blockLength) noexcept
+{
+    if (voice.numFree == 0)
+    {
+        ++voice.droppedGrains; // Pool exhausted - density x length is beyond what the pool holds
+        return;
+    }
+
+    auto& random = voice.random;
+    auto bipolar = [&random] { return random.nextFloat() * 2.0f - 1.0f; };
+    auto samplesPerMs = currentSampleRate * 0.001;
+
+    auto lengthSamples = juce::jmax(16.0, preset.grainMs * samplesPerMs * (1.0 + preset.grainJitter * bipolar()));
+    auto increment = baseIncrement;
+    if (preset.pitchJitterSemitones > 0.0f)
+        increment *= std::exp2(preset.pitchJitterSemitones * bipolar() / 12.0f);
+    auto span = lengthSamples * increment; // Source samples the grain reads
+    auto spread = preset.positionSpreadMs * samplesPerMs;
+
+    double position;
+    if (source.isRing)
+    {
+        // End the read at (output time - delay - spread), so the grain never overtakes the write position
+        auto now = (double)(liveWritePosition - blockLength + onset);
+        position = now - preset.liveDelayMs * samplesPerMs - spread * random.nextFloat() - span;
+        position = juce::jmax(position, (double)(liveWritePosition - liveBufferSize + blockLength), 0.0);
+    }
+    else
+    {
+        auto lastStart = (double)source.length - span - 2.0;
+        if (lastStart <= 0.0)
+            return; // Zone head is shorter than one grain
+        position = juce::jlimit(0.0, lastStart, voice.scanPosition + spread * bipolar());
+    }
+
+    // Overlapping grains add up; keep the sum near unity whatever the density
+    auto overlap = preset.densityHz * preset.grainMs * 0.001f;
+
+    auto index = voice.freeGrains[(size_t)--voice.numFree];
+    voice.activeGrains[(size_t)voice.numActive++] = index;
+    auto& grain = voice.grains[index];
+    grain.position = position;
+    grain.increment = increment;
+    grain.windowPhase = 0.0f;
+    grain.windowStep = (float)(windowTableSize / lengthSamples);
+    grain.gain = 1.0f / std::sqrt(juce::jmax(1.0f, overlap));
+    grain.startOffset = onset;
+}
+
+bool GranularSynth::renderGrain(Grain& grain, const SourceView& source, float* output, int numSamples) noexcept
+{
+    auto start = grain.startOffset;
+    grain.startOffset = 0;
+
+    auto remaining = (int)std::ceil((windowTableSize - grain.windowPhase) / grain.windowStep);
+    auto count = juce::jmin(numSamples - start, remaining);
+
+    // A grain left over from a retrigger on a different zone may not fit this source
+    if (! source.isRing)
+    {
+        auto readable = (int)(((double)source.length - 2.0 - grain.position) / grain.increment);
+        if (readable < count)
+        {
+            count = juce::jmax(0, readable);
+            remaining = count;
+        }
+    }
+
+    if (count > 0)
+    {
+        auto* sourceRun = scratch.getWritePointer(0);
+        auto* windowRun = scratch.getWritePointer(1);
+
+        // Window (with the grain's gain) from the table, linearly interpolated. The float phase can
+        // round up to the table's end on the last sample, so the pair read is kept inside the table.
+        for (int i = 0; i < count; ++i)
+        {
+            auto phase = juce::jmin(grain.windowPhase + grain.windowStep * (float)i, (float)windowTableSize);
+            auto index = juce::jmin((int)phase, windowTableSize - 1);
+            auto fraction = phase - (float)index;
+            windowRun[i] = grain.gain * (currentWindow[index] + fraction * (currentWindow[index + 1] - currentWindow[index]));
+        }
+
+        // Source at the grain's pitch, linearly interpolated
+        if (source.isRing)
+        {
+            constexpr auto mask = (juce::int64)liveBufferSize - 1;
+            for (int i = 0; i < count; ++i)
+            {
+                auto position = grain.position + grain.increment * i;
+                auto index = (juce::int64)position;
+                auto fraction = (float)(position - (double)index);
+                auto a = source.data[index & mask], b = source.data[(index + 1) & mask];
+                sourceRun[i] = a + fraction * (b - a);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                auto position = grain.position + grain.increment * i;
+                auto index = (juce::int64)position;
+                auto fraction = (float)(position - (double)index);
+                sourceRun[i] = source.data[index] + fraction * (source.data[index + 1] - source.data[index]);
+            }
+        }
+
+        juce::FloatVectorOperations::addWithMultiply(output + start, sourceRun, windowRun, count);
+
+        grain.position += grain.increment * count;
+        grain.windowPhase += grain.windowStep * (float)count;
+    }
+
+    return count >= remaining;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "SampleLibrary.h"
+#include "TableCache.h"
+
+//==============================================================================
+/*
+    Granular voice renderer, used by SynthEngine's granular voice type.
+
+    A grain is a short windowed read of a source at the note's pitch. The
+    source is either the in-memory head of the sampler zone for the note, or
+    a ring of the engine's own recent output (the other voices; see
+    captureLive), so a live preset granulates whatever else is playing.
+
+    Grains come from a fixed pool per voice (no allocation after
+    construction). A free list and an active list both hold pool indices.
+    The scheduler keeps fractional time, so grain onsets land on the exact
+    sample inside the block at any density, and the long-run rate is exact.
+    When the pool is full a grain is dropped and counted.
+
+    Window shapes are precomputed tables, cached on disk by TableCache.
+    Rendering a grain fills a source run and a window run (loops with no
+    loop-carried dependency), then one FloatVectorOperations::addWithMultiply
+    sums them into the voice output.
+*/
+class GranularSynth
+{
+public:
+    static constexpr int maxGrainsPerVoice = 128;     // ~2000 grains/s at 60 ms each
+    static constexpr int windowTableSize = 1024;
+    static constexpr int liveBufferSize = 1 << 17;    // ~2.7 s at 48 kHz, power of two
+    static constexpr int numPresets = 5;
+
+    enum WindowShape { hannWindow, gaussianWindow, trapezoidWindow, expodecWindow, numWindowShapes };
+    enum Source { sampleSource, liveSource };
+
+    struct Preset
+    {
+        const char* name = "";
+        Source source = sampleSource;
+        WindowShape window = hannWindow;
+        float grainMs = 60.0f;
+        float grainJitter = 0.0f;         // Random +- fraction of the length
+        float densityHz = 100.0f;         // Grains per second
+        float densityJitter = 0.0f;       // Random +- fraction of the interval
+        float scanRate = 0.0f;            // Sample source: source seconds per second (0 = frozen)
+        float positionSpreadMs = 0.0f;    // Random offset of each grain's read position
+        float pitchJitterSemitones = 0.0f;
+        float liveDelayMs = 0.0f;         // Live source: how far behind the output grains read
+    };
+
+    struct Grain
+    {
+        double position = 0.0;    // Source samples (absolute ring position for the live source)
+        double increment = 1.0;
+        float  windowPhase = 0.0f;
+        float  windowStep = 0.0f; // Table points per output sample
+        float  gain = 1.0f;
+        int    startOffset = 0;   // Onset within the block it was scheduled in
+    };
+
+    struct VoiceState
+    {
+        std::array<Grain, maxGrainsPerVoice> grains{};
+        std::array<juce::uint8, maxGrainsPerVoice> activeGrains{}; // Pool indices, first numActive in use
+        std::array<juce::uint8, maxGrainsPerVoice> freeGrains{};   // Pool indices, first numFree available
+        int numActive = 0, numFree = 0;
+        double samplesToNextGrain = 0.0;
+        double scanPosition = 0.0;      // Source samples into the zone head
+        juce::Random random;
+        int droppedGrains = 0;
+    };
+
+    GranularSynth();
+
+    static const Preset& getPreset(int index) noexcept;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    // --- Audio thread ---
+    void noteOn(VoiceState& voice, bool freshVoice) const noexcept;
+    // Appends the engine's mix (without granular voices) to the live ring
+    void captureLive(const float* samples, int numSamples) noexcept;
+    // Render-ahead rollback rewinds the live ring's write position with the rest of the engine
+    juce::int64 getLiveWritePosition() const noexcept { return liveWritePosition; }
+    void setLiveWritePosition(juce::int64 position) noexcept { liveWritePosition = position; }
+    // Writes (not adds) numSamples of the voice's output. zone may be nullptr (a sample preset stays silent).
+    void render(VoiceState& voice, const Preset& preset, const SampleLibrary::Zone* zone,
+                double frequency, float* output, int numSamples) noexcept;
+
+private:
+    struct SourceView
+    {
+        const float* data = nullptr;
+        juce::int64 length = 0;   // Sample source: readable samples
+        bool isRing = false;      // Live source: index with & (liveBufferSize - 1)
+    };
+
+    void spawnGrain(VoiceState& voice, const Preset& preset, const SourceView& source,
+                    int onset, double baseIncrement, int blockLength) noexcept;
+    bool renderGrain(Grain& grain, const SourceView& source, float* output, int numSamples) noexcept;
+    const float* getWindowTable(int shape) const noexcept;
+
+    double currentSampleRate = 44100.0;
+    std::shared_ptr<const TableCache::Table> windowTables; // numWindowShapes x (windowTableSize + 1), cached on disk
+    const float* currentWindow = nullptr;   // Table for the preset being rendered
+    std::vector<float> liveBuffer;
+    juce::int64 liveWritePosition = 0;
+    juce::AudioBuffer<float> scratch;       // 0: source run, 1: window run
+};
@@ -1,180 +1,141 @@
 #include "InputHandler.h"
 #include "MainComponent.h" // Included for ScaleInfo, enum, DBG usually via JuceHeader.h anyway
-#include <cmath>           // For std::round, std::floor, std::fmod, std::abs
+#include "LatencyMonitor.h" // For the InputPath tag
+#include <cmath>           // For std::round, std::floor
 #include <juce_core/system/juce_TargetPlatform.h> // For DBG
 
 //==============================================================================
-InputHandler::InputHandler(Listener& listener,
+InputHandler::InputHandler(NoteEventQueue& eventQueue,
                            const std::vector<MainComponent::ScaleInfo>& scaleData,
                            const std::atomic<int>& rootNote,
-                           const std::atomic<int>& scaleType,
-                           const std::atomic<int>& transpose) :
-    listenerRef(listener), // Initialize listener reference
+                           const std::atomic<int>& scaleType) :
+    queue(eventQueue),
     scaleDataRef(scaleData), // Initialize references to read state from MainComponent
     rootNoteRef(rootNote),
-    scaleTypeRef(scaleType),
-    transposeRef(transpose)
-    // currentlyPlayingNote defaults to -1, keysDown map defaults to empty
+    scaleTypeRef(scaleType)
 {
-    // Constructor body can be empty for now
+    // Build the key-code lookup once, so every key event is a single array read
+    keyCodeToIndex.fill(-1);
+    for (int i = 0; i < numKeys; ++i)
+        keyCodeToIndex[(size_t)keyOrder[i]] = i;
+
+    heldMidiNote.fill(-1);
 }
 
 // Method called by MainComponent::keyPressed
-void InputHandler::handleKeyPress(const juce::KeyPress& key)
+bool InputHandler::handleKeyPress(const juce::KeyPress& key)
 {
-    int keyCode = key.getKeyCode();
-    // Check if key is *already* logically down according to our map
-    if (keysDown.count(keyCode) && keysDown[keyCode]) {
-         DBG("InputHandler::handleKeyPress: Key code " + juce::String(keyCode) + " ignored (already down).");
-         return; // Prevent auto-repeat trigger by OS
-    }
-
-    // --- Map KeyCode to an index ---
-    int keyIndex = keyOrder.indexOfChar((juce::juce_wchar)keyCode);
-    if (keyIndex == -1) { // Key not in our defined layout
-        DBG("InputHandler::handleKeyPress: Key code " + juce::String(keyCode) + " (" + key.getTextDescription() + ") - Not in keyOrder map.");
-        return;
-    }
+    // Timestamp on entry - this is the start of the key-to-sound latency measurement
+    auto timestampTicks = juce::Time::getHighResolutionTicks();
 
-    DBG("InputHandler::handleKeyPress: Key code " + juce::String(keyCode) + " (" + key.getTextDescription() + ")");
+    int keyIndex = getKeyIndex(key.getKeyCode());
+    if (keyIndex < 0) // Key not in our defined layout
+        return false;
 
-    // --- Calculate MIDI Note based on Root, Scale, and Key Index ---
-    int rootNoteIndex = rootNoteRef.load(); // 0-11 (C=0)
-    int scaleTypeId = scaleTypeRef.load(); // 1=Major, 2=Minor, ...
-    int scalePatternIndex = scaleTypeId - 1; // Adjust for 0-based vector index
+    // Already held: this is the OS auto-repeat, don't retrigger
+    if (keysDown[(size_t)keyIndex])
+        return true;
 
-    // Validate scale data access
-    if (scalePatternIndex < 0 || scalePatternIndex >= scaleDataRef.size() || scaleDataRef[scalePatternIndex].intervals.size() != 7) {
-        DBG("InputHandler::handleKeyPress - Invalid scale type selected or scaleData incorrect! ScaleID=" + juce::String(scaleTypeId));
-        return; // Cannot proceed
+    int midiNote = mapKeyIndexToMidiNote(keyIndex);
+    if (midiNote < 0)
+    {
+        DBG("InputHandler::handleKeyPress - Invalid scale type selected or scaleData incorrect! ScaleID=" + juce::String(scaleTypeRef.load()));
+        return false; // Cannot proceed
     }
-    const auto& intervals = scaleDataRef[scalePatternIndex].intervals; // Get intervals {0, 2, 4...}
-
-    // Calculate reference MIDI note for 'A' key (index 10) - Root Note in octave closest to Middle C (60)
-    int refMidiNote = 12 * (int)std::round((60.0 - rootNoteIndex) / 12.0) + rootNoteIndex;
-
-    int offset = keyIndex - refKeyIndex; // Offset in scale steps from 'A'
-
-    // Calculate octave shift and degree index within the scale pattern
-    int octaveShift = floor((double)offset / 7.0); // How many full octaves up/down
-    int degreeIndex = ((offset % 7) + 7) % 7; // Index within the 7 scale intervals (0-6)
-
-    // Get the interval (in semitones) from the root for this scale degree
-    int interval = intervals[degreeIndex];
-
-    // Calculate the final MIDI note number (Root + Octave + Interval relative to root)
-    int finalMidiNote = refMidiNote + (octaveShift * 12) + (interval - intervals[0]); // intervals[0] is always 0
 
-    // Clamp to valid MIDI range
-    finalMidiNote = juce::jlimit(0, 127, finalMidiNote);
+    NoteEvent event;
+    event.type = NoteEvent::noteOn;
+    event.midiNote = midiNote;
+    event.velocity = 1.0f; // Computer keys have no velocity
+    event.timestampTicks = timestampTicks;
+    event.inputPath = LatencyMonitor::computerKeyboard;
 
-    // --- Store state and trigger listener ---
-    keysDown[keyCode] = true; // Mark key down in our map NOW
-    currentlyPlayingNote = finalMidiNote; // Store the MIDI note being played
-
-    // Apply transpose *before* sending note to listener (MainComponent applies fine tune)
-    int currentTranspose = transposeRef.load();
-    int transposedMidiNote = juce::jlimit(0, 127, finalMidiNote + currentTranspose);
+    if (! queue.push(event))
+    {
+        DBG("InputHandler::handleKeyPress - Event queue full, note dropped");
+        return true;
+    }
 
-    // Tell the listener (MainComponent) to turn the note ON
-    listenerRef.inputNoteOn(transposedMidiNote); // Pass the transposed note
+    keysDown.set((size_t)keyIndex);
+    heldMidiNote[(size_t)keyIndex] = midiNote;
 
-    DBG("InputHandler::handleKeyPress - Key Mapped: Key='" + key.getTextDescription() + "', Offset=" + juce::String(offset)
-        + ", OctShift=" + juce::String(octaveShift) + ", DegIdx=" + juce::String(degreeIndex)
-        + ", Interval=" + juce::String(interval)
-        + ", BaseMIDI=" + juce::String(finalMidiNote) // Log the note BEFORE transpose
-        + ", Transpose=" + juce::String(currentTranspose)
-        + ", FinalMIDI Sent=" + juce::String(transposedMidiNote) + " -> Note ON");
+    DBG("InputHandler::handleKeyPress - Key='" + key.getTextDescription() + "', Index=" + juce::String(keyIndex)
+        + ", MIDI=" + juce::String(midiNote) + " -> Note ON");
+    return true;
 }
 
 // Method called by MainComponent::keyStateChanged
-void InputHandler::handleKeyStateChange()
+bool InputHandler::handleKeyStateChange(bool isKeyDown)
 {
-    DBG("InputHandler::handleKeyStateChange called.");
-    bool shouldBePlaying = false;
-    int lastKeyDownCode = -1;
-    int highestKeyIndex = -1; // Track index of highest priority key still down
+    // Presses arrive through handleKeyPress; only a release needs us to find out which key went up.
+    // JUCE doesn't say which one, so check just the keys we know are held - never the whole layout.
+    if (isKeyDown || keysDown.none())
+        return false;
 
-    // Update internal map based on which keys *we care about* are physically down
-    for (auto it = keysDown.begin(); it != keysDown.end(); )
+    auto timestampTicks = juce::Time::getHighResolutionTicks();
+    bool anyReleased = false;
+
+    for (int keyIndex = 0; keyIndex < numKeys; ++keyIndex)
     {
-        int currentKeyCode = it->first;
-        // Check the actual current state using JUCE's function
-        if (juce::KeyPress::isKeyCurrentlyDown(currentKeyCode))
-        {
-            shouldBePlaying = true;
-            it->second = true; // Update map state
-
-            // Find the index of this key to determine priority (later keys = higher pitch)
-            int currentKeyIndex = keyOrder.indexOfChar((juce::juce_wchar)currentKeyCode);
-            if (currentKeyIndex > highestKeyIndex) {
-                highestKeyIndex = currentKeyIndex;
-                lastKeyDownCode = currentKeyCode; // Store the code of the highest key
-            }
-            ++it;
-        }
-        else
+        if (keysDown[(size_t)keyIndex] && ! juce::KeyPress::isKeyCurrentlyDown((int)keyOrder[keyIndex]))
         {
-            // If key is UP, remove it from our map of tracked keys
-             DBG("InputHandler::handleKeyStateChange - Key Up detected: " + juce::String(currentKeyCode));
-            it = keysDown.erase(it); // Erase returns iterator to the next element
+            sendNoteOff(keyIndex, timestampTicks);
+            anyReleased = true;
         }
     }
 
+    return anyReleased;
+}
+
+void InputHandler::releaseAllKeys()
+{
+    auto timestampTicks = juce::Time::getHighResolutionTicks();
+    for (int keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+        if (keysDown[(size_t)keyIndex])
+            sendNoteOff(keyIndex, timestampTicks);
+}
 
-    if (shouldBePlaying)
+//==============================================================================
+void InputHandler::sendNoteOff(int keyIndex, juce::int64 timestampTicks)
+{
+    NoteEvent event;
+    event.type = NoteEvent::noteOff;
+    event.midiNote = heldMidiNote[(size_t)keyIndex]; // The note this key started, even if the scale changed since
+    event.velocity = 0.0f;
+    event.timestampTicks = timestampTicks;
+    event.inputPath = LatencyMonitor::computerKeyboard;
+
+    if (! queue.push(event))
     {
-        // --- Handle potential note change if multiple keys were held ---
-        // Calculate the MIDI note for the highest key still held down
-        int rootNoteIndex = rootNoteRef.load();
-        int scaleTypeId = scaleTypeRef.load();
-        int scalePatternIndex = juce::jlimit(0, (int)scaleDataRef.size() - 1, scaleTypeId - 1);
-
-        if (scaleDataRef.empty() || scaleDataRef[scalePatternIndex].intervals.size() != 7) {
-             DBG("InputHandler::handleKeyStateChange - Invalid scale data! Forcing note off.");
-             if (currentlyPlayingNote != -1) {
-                 listenerRef.inputNoteOff(currentlyPlayingNote); // Use last known note for note off
-                 currentlyPlayingNote = -1;
-             }
-             return;
-        }
-        const auto& intervals = scaleDataRef[scalePatternIndex].intervals;
-        int refMidiNote = 12 * (int)std::round((60.0 - rootNoteIndex) / 12.0) + rootNoteIndex;
-        int refKeyIndex = keyOrder.indexOfChar('A');
-        int offset = highestKeyIndex - refKeyIndex;
-        int octaveShift = floor((double)offset / 7.0);
-        int degreeIndex = ((offset % 7) + 7) % 7;
-        int interval = intervals[degreeIndex];
-        int newMidiNote = juce::jlimit(0, 127, refMidiNote + (octaveShift * 12) + interval);
-
-        // Check if the highest sounding note has changed
-        if (newMidiNote != currentlyPlayingNote)
-        {
-            // Trigger note off for the previous note first? Optional for monophonic.
-            // listenerRef.inputNoteOff(currentlyPlayingNote);
+        DBG("InputHandler::sendNoteOff - Event queue full, keeping key " + juce::String(keyIndex) + " held");
+        return; // Retried on the next key event so the note can't get stuck
+    }
 
-            currentlyPlayingNote = newMidiNote; // Store the new note
+    DBG("InputHandler::sendNoteOff - Index=" + juce::String(keyIndex) + ", MIDI=" + juce::String(event.midiNote) + " -> Note OFF");
+    keysDown.reset((size_t)keyIndex);
+    heldMidiNote[(size_t)keyIndex] = -1;
+}
 
-            // Apply transpose before sending note to listener
-            int currentTranspose = transposeRef.load();
-            int transposedMidiNote = juce::jlimit(0, 127, currentlyPlayingNote + currentTranspose);
+int InputHandler::mapKeyIndexToMidiNote(int keyIndex) const
+{
+    int rootNoteIndex = rootNoteRef.load(); // 0-11 (C=0)
+    int scalePatternIndex = scaleTypeRef.load() - 1; // 1=Major, 2=Minor... adjust for 0-based vector index
 
-            listenerRef.inputNoteOn(transposedMidiNote); // Trigger new note ON
+    // Validate scale data access
+    if (scalePatternIndex < 0 || scalePatternIndex >= (int)scaleDataRef.size() || scaleDataRef[(size_t)scalePatternIndex].intervals.size() != 7)
+        return -1;
 
-            DBG("InputHandler::handleKeyStateChange - Note Changed/Retriggered: New BaseMIDI=" + juce::String(currentlyPlayingNote)
-                + ", FinalMIDI Sent=" + juce::String(transposedMidiNote) + " -> Note ON");
-        }
-        // If the same note is still held, do nothing - let ADSR continue
-    }
-    else // No relevant keys in our map are currently down
-    {
-        if (currentlyPlayingNote != -1) // Only trigger noteOff if a note was actually playing
-        {
-             DBG("InputHandler::handleKeyStateChange - All relevant keys released. Triggering Note OFF for MIDI=" + juce::String(currentlyPlayingNote));
-             // Apply transpose to the note being turned off as well? Not necessary.
-             // Send the base MIDI note that needs to stop.
-             listenerRef.inputNoteOff(currentlyPlayingNote); // <<< Trigger Note OFF via Listener >>>
-             currentlyPlayingNote = -1; // Mark no note as playing
-        }
-    }
-}
\ No newline at end of file
+    const auto& intervals = scaleDataRef[(size_t)scalePatternIndex].intervals; // Get intervals {0, 2, 4...}
+
+    // Reference MIDI note for the 'A' key - Root Note's pitch in octave closest to Middle C (60)
+    int refMidiNote = 12 * (int)std::round((60.0 - rootNoteIndex) / 12.0) + rootNoteIndex;
+
+    int offset = keyIndex - refKeyIndex; // Offset in scale steps from 'A'
+
+    // Octave shift and degree index within the scale pattern
+    int octaveShift = (int)std::floor((double)offset / 7.0); // How many full octaves up/down
+    int degreeIndex = ((offset % 7) + 7) % 7; // Index within the 7 scale intervals (0-6)
+
+    // Final MIDI note (Root's Octave + Octave Shift + Interval), clamped to the valid range
+    return juce::jlimit(0, 127, refMidiNote + (octaveShift * 12) + intervals[(size_t)degreeIndex]);
+}
@@ -2,57 +2,63 @@
 
 #include <JuceHeader.h>
 #include <vector>
-#include <map>
+#include <array>
+#include <bitset>
 #include <atomic>
 #include "MainComponent.h" // Include MainComponent header for ScaleInfo struct and enums
+#include "NoteEventQueue.h"
 
 //==============================================================================
 /*
-    Handles mapping computer keyboard input to MIDI notes based on selected
-    scale, root, and tuning parameters. Communicates note on/off events
-    back via a Listener interface.
+    The single input layer for the computer keyboard.
+
+    Maps the letter keys onto notes of the selected scale and root, keeps the
+    held-key state in a fixed bitset (O(1) key-code -> key-index lookup, no map
+    walking) and pushes timestamped note-on/off events into a lock-free queue that
+    the audio thread drains. Every held key sounds its own note, so chords play
+    polyphonically.
 */
 class InputHandler
 {
 public:
-    // Listener interface for communication back to the owner (MainComponent)
-    class Listener
-    {
-    public:
-        virtual ~Listener() = default;
-        // Called when a key press maps to a valid note that should start playing
-        virtual void inputNoteOn(int midiNoteNumber) = 0;
-        // Called when a key release means the currently playing note should stop
-        virtual void inputNoteOff(int midiNoteNumber) = 0;
-         // Or potentially just inputNoteOff() if monophonic? Let's include note number for future.
-    };
-
-    // Constructor needs access to scale data, relevant state atomics, and the listener
-    InputHandler(Listener& listener,
+    static constexpr int numKeys = 26; // "QWERTYUIOPASDFGHJKLZXCVBNM"
+
+    // Constructor needs access to scale data, relevant state atomics, and the queue to push events into
+    InputHandler(NoteEventQueue& eventQueue,
                  const std::vector<MainComponent::ScaleInfo>& scaleData, // Read-only access to scale definitions
                  const std::atomic<int>& rootNote,         // Read-only access to atomics
-                 const std::atomic<int>& scaleType,
-                 const std::atomic<int>& transpose);       // Only need transpose here, fine tune applied later
+                 const std::atomic<int>& scaleType);
+
+    // Methods called by MainComponent's KeyListener callbacks. Return true if the key was handled.
+    bool handleKeyPress(const juce::KeyPress& key);
+    bool handleKeyStateChange(bool isKeyDown);
 
-    // Methods called by MainComponent's KeyListener callbacks
-    void handleKeyPress(const juce::KeyPress& key);
-    void handleKeyStateChange(); // Called when *any* key state changes
+    // Sends note-offs for everything held, e.g. when keyboard focus is lost
+    void releaseAllKeys();
 
+    // Index of the key in the layout, or -1 if the key code isn't part of it
+    int getKeyIndex(int keyCode) const noexcept
+    {
+        return (keyCode >= 0 && keyCode < (int)keyCodeToIndex.size()) ? keyCodeToIndex[(size_t)keyCode] : -1;
+    }
 
 private:
-    Listener& listenerRef; // Reference to the listener (MainComponent)
+    // Scale-degree mapping shared by every key: 'A' is the root in the octave nearest middle C
+    int mapKeyIndexToMidiNote(int keyIndex) const;
+    void sendNoteOff(int keyIndex, juce::int64 timestampTicks);
+
+    NoteEventQueue& queue;
 
     // References to read state from MainComponent
     const std::vector<MainComponent::ScaleInfo>& scaleDataRef;
     const std::atomic<int>& rootNoteRef;
     const std::atomic<int>& scaleTypeRef;
-    const std::atomic<int>& transposeRef;
-
-    // Internal state for tracking pressed keys and the active note
-    std::map<int, bool> keysDown; // Map of keyCode -> isLogicallyDown
-    int                 currentlyPlayingNote = -1; // Base MIDI note (before fine tune)
 
     // Key layout information
-    const juce::String keyOrder = "QWERTYUIOPASDFGHJKLZXCVBNM";
-    const int refKeyIndex = keyOrder.indexOfChar('A'); // Index of 'A'
-};
\ No newline at end of file
+    static constexpr const char* keyOrder = "QWERTYUIOPASDFGHJKLZXCVBNM";
+    static constexpr int refKeyIndex = 10; // Index of 'A'
+
+    std::array<int, 128>     keyCodeToIndex;   // -1 for keys outside the layout
+    std::bitset<numKeys>     keysDown;         // Which layout keys are currently held
+    std::array<int, numKeys> heldMidiNote;     // Note each held key started (scale may change while held)
+};
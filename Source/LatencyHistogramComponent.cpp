@@ -0,0 +1,85 @@
+#include "LatencyHistogramComponent.h"
+
+//==============================================================================
+LatencyHistogramComponent::LatencyHistogramComponent(LatencyMonitor& monitorToShow) :
+    monitor(monitorToShow)
+{
+    startTimerHz(5);
+}
+
+LatencyHistogramComponent::~LatencyHistogramComponent()
+{
+    stopTimer();
+}
+
+void LatencyHistogramComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::grey);
+    g.drawRect(getLocalBounds(), 1);
+
+    auto bounds = getLocalBounds().reduced(4);
+    auto textArea = bounds.removeFromTop(16);
+
+    // --- Summary line ---
+    g.setColour(juce::Colours::limegreen);
+    g.setFont(juce::Font("Consolas", 13.0f, juce::Font::plain));
+
+    auto count = monitor.getTotalCount();
+    juce::String summary = "Key->sound latency  n=" + juce::String(count);
+    if (count > 0)
+    {
+        summary << "  median=" << juce::String(monitor.getPercentileMs(50.0), 1) << "ms"
+                << "  p95=" << juce::String(monitor.getPercentileMs(95.0), 1) << "ms"
+                << "  max=" << juce::String(monitor.getMaximumMs(), 1) << "ms";
+    }
+    summary << "  (block " << monitor.getBlockSize() << ", out " << monitor.getOutputLatencySamples() << " smp)";
+    g.drawText(summary, textArea, juce::Justification::centredLeft, true);
+
+    // --- Bars ---
+    int maxBinCount = 0;
+    for (int i = 0; i < LatencyMonitor::numBins; ++i)
+        maxBinCount = juce::jmax(maxBinCount, monitor.getBinCount(i));
+
+    if (maxBinCount == 0 || bounds.getHeight() <= 0)
+        return;
+
+    auto barWidth = (float)bounds.getWidth() / (float)LatencyMonitor::numBins;
+    auto bottom = (float)bounds.getBottom();
+
+    for (int i = 0; i < LatencyMonitor::numBins; ++i)
+    {
+        auto binCount = monitor.getBinCount(i);
+        if (binCount == 0)
+            continue;
+
+        auto barHeight = (float)bounds.getHeight() * (float)binCount / (float)maxBinCount;
+        g.fillRect(juce::Rectangle<float>((float)bounds.getX() + i * barWidth, bottom - barHeight,
+                                          juce::jmax(1.0f, barWidth - 1.0f), barHeight));
+    }
+
+    // Tick labels every 10 ms
+    g.setColour(juce::Colours::grey);
+    g.setFont(juce::Font("Consolas", 10.0f, juce::Font::plain));
+    for (int ms = 10; ms < LatencyMonitor::numBins; ms += 10)
+    {
+        auto x = bounds.getX() + (int)(ms / LatencyMonitor::binWidthMs * barWidth);
+        g.drawText(juce::String(ms), x - 10, bounds.getY(), 20, 12, juce::Justification::centred, false);
+    }
+}
+
+void LatencyHistogramComponent::mouseDoubleClick(const juce::MouseEvent&)
+{
+    monitor.reset();
+    repaint();
+}
+
+void LatencyHistogramComponent::timerCallback()
+{
+    auto count = monitor.getTotalCount();
+    if (count != lastDrawnCount)
+    {
+        lastDrawnCount = count;
+        repaint();
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LatencyMonitor.h"
+
+//==============================================================================
+/*
+    Draws the key-to-sound latency histogram collected by a LatencyMonitor,
+    with a summary line (count, median, p95, max, block size).
+    Double-click to reset the histogram.
+*/
+class LatencyHistogramComponent : public juce::Component,
+    public juce::Timer
+{
+public:
+    explicit LatencyHistogramComponent(LatencyMonitor& monitorToShow);
+    ~LatencyHistogramComponent() override;
+
+    void paint(juce::Graphics&) override;
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+
+private:
+    void timerCallback() override;
+
+    LatencyMonitor& monitor;
+    int lastDrawnCount = -1; // Skip repaints when nothing new arrived
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyHistogramComponent)
+};
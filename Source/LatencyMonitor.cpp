@@ -0,0 +1,174 @@
+#include "LatencyMonitor.h"
+
+//==============================================================================
+LatencyMonitor::LatencyMonitor()
+{
+    logFile = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                  .getChildFile("CSYNTH")
+                  .getChildFile("latency_log.csv");
+    startTimer(500); // Flush to disk twice a second
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+    stopTimer();
+    writePendingMeasurements(); // Don't lose whatever arrived since the last tick
+}
+
+void LatencyMonitor::setDeviceInfo(double sampleRate, int blockSize, int outputLatency)
+{
+    currentSampleRate.store(sampleRate);
+    currentBlockSize.store(blockSize);
+    outputLatencySamples.store(juce::jmax(0, outputLatency));
+    reset();
+
+    DBG("LatencyMonitor::setDeviceInfo - Rate=" + juce::String(sampleRate)
+        + ", BlockSize=" + juce::String(blockSize)
+        + ", OutputLatency=" + juce::String(outputLatency) + " samples");
+}
+
+void LatencyMonitor::clearStatistics() noexcept
+{
+    for (auto& bin : bins)
+        bin.store(0, std::memory_order_relaxed);
+    totalCount.store(0, std::memory_order_relaxed);
+    sumMicroseconds.store(0, std::memory_order_relaxed);
+    minimumMs.store(0.0, std::memory_order_relaxed);
+    maximumMs.store(0.0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void LatencyMonitor::addMeasurement(juce::int64 inputTicks, juce::int64 callbackTicks, int sampleOffset, int inputPath) noexcept
+{
+    auto sampleRate = currentSampleRate.load();
+    if (inputTicks <= 0 || sampleRate <= 0.0)
+        return;
+
+    // Time from the input event to the start of the callback that produced the sound...
+    auto inputToCallbackMs = juce::Time::highResolutionTicksToSeconds(callbackTicks - inputTicks) * 1000.0;
+    // ...plus the position of the first audible sample in the block and what the device adds on top
+    auto outputMs = (sampleOffset + outputLatencySamples.load()) * 1000.0 / sampleRate;
+    auto latencyMs = juce::jmax(0.0, inputToCallbackMs + outputMs);
+
+    // A reset clears everything here, before this sample, rather than racing it from another thread.
+    // The flag drops only after the clear, so readers see an empty histogram until then.
+    if (resetPending.load())
+    {
+        clearStatistics();
+        resetPending.store(false);
+    }
+
+    auto binIndex = juce::jlimit(0, numBins - 1, (int)(latencyMs / binWidthMs));
+    bins[(size_t)binIndex].fetch_add(1, std::memory_order_relaxed);
+
+    // Single writer (the audio thread), so plain load/store is enough for min/max
+    auto previousCount = totalCount.load(std::memory_order_relaxed);
+    if (previousCount == 0 || latencyMs < minimumMs.load(std::memory_order_relaxed))
+        minimumMs.store(latencyMs, std::memory_order_relaxed);
+    if (previousCount == 0 || latencyMs > maximumMs.load(std::memory_order_relaxed))
+        maximumMs.store(latencyMs, std::memory_order_relaxed);
+    sumMicroseconds.fetch_add((juce::int64)(latencyMs * 1000.0), std::memory_order_relaxed);
+    totalCount.store(previousCount + 1, std::memory_order_relaxed);
+
+    // Queue for the log file - if the message thread has fallen behind, drop rather than block
+    int start1, size1, start2, size2;
+    pendingFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 > 0)
+    {
+        auto& m = pendingMeasurements[(size_t)start1];
+        m.latencyMs = latencyMs;
+        m.inputPath = inputPath;
+        m.blockSize = currentBlockSize.load();
+        m.outputLatencySamples = outputLatencySamples.load();
+        m.sampleRate = sampleRate;
+        pendingFifo.finishedWrite(1);
+    }
+}
+
+//==============================================================================
+double LatencyMonitor::getMeanMs() const noexcept
+{
+    auto count = getTotalCount();
+    return count > 0 ? (double)sumMicroseconds.load() / 1000.0 / count : 0.0;
+}
+
+double LatencyMonitor::getPercentileMs(double percentile) const noexcept
+{
+    auto count = getTotalCount();
+    if (count == 0)
+        return 0.0;
+
+    auto target = juce::jlimit(1, count, (int)std::ceil(count * percentile / 100.0));
+    int runningCount = 0;
+    for (int i = 0; i < numBins; ++i)
+    {
+        runningCount += getBinCount(i);
+        if (runningCount >= target)
+            return (i + 0.5) * binWidthMs; // Bin centre
+    }
+    return getMaximumMs();
+}
+
+const char* LatencyMonitor::getInputPathName(int inputPath) noexcept
+{
+    switch (inputPath)
+    {
+    case computerKeyboard: return "computer_keyboard";
+    case midiInput:        return "midi_input";
+    default:               return "unknown";
+    }
+}
+
+//==============================================================================
+void LatencyMonitor::timerCallback()
+{
+    writePendingMeasurements();
+}
+
+void LatencyMonitor::writePendingMeasurements()
+{
+    auto numReady = pendingFifo.getNumReady();
+    if (numReady == 0)
+        return;
+
+    if (logStream == nullptr)
+    {
+        logFile.getParentDirectory().createDirectory();
+        bool isNewFile = ! logFile.existsAsFile();
+        logStream = std::make_unique<juce::FileOutputStream>(logFile); // Appends to an existing file
+
+        if (logStream->failedToOpen())
+        {
+            DBG("LatencyMonitor: Could not open " + logFile.getFullPathName());
+            logStream.reset();
+            pendingFifo.finishedRead(numReady); // Discard, otherwise the FIFO just fills up
+            return;
+        }
+
+        if (isNewFile)
+            *logStream << "time,input_path,latency_ms,block_size,sample_rate,output_latency_samples\n";
+    }
+
+    auto now = juce::Time::getCurrentTime().toISO8601(true);
+    auto writeRange = [&](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            const auto& m = pendingMeasurements[(size_t)i];
+            *logStream << now << ","
+                       << getInputPathName(m.inputPath) << ","
+                       << juce::String(m.latencyMs, 3) << ","
+                       << m.blockSize << ","
+                       << juce::String(m.sampleRate, 0) << ","
+                       << m.outputLatencySamples << "\n";
+        }
+    };
+
+    int start1, size1, start2, size2;
+    pendingFifo.prepareToRead(numReady, start1, size1, start2, size2);
+    writeRange(start1, size1);
+    writeRange(start2, size2);
+    pendingFifo.finishedRead(size1 + size2);
+
+    logStream->flush();
+}
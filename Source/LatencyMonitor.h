@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/*
+    Collects key-to-sound latency measurements.
+
+    The audio thread calls addMeasurement() once per note, when the first non-silent
+    sample for that note has been rendered. Measurements go into a fixed-size
+    histogram (atomics, readable from the UI) and into a lock-free FIFO that the
+    message thread drains into a CSV file, so different buffer sizes and input paths
+    can be compared afterwards.
+*/
+class LatencyMonitor : private juce::Timer
+{
+public:
+    // Where a note event entered the app
+    enum InputPath
+    {
+        computerKeyboard = 0,
+        midiInput,
+        numInputPaths
+    };
+
+    static constexpr int numBins = 100;          // Histogram buckets
+    static constexpr double binWidthMs = 1.0;    // Last bucket also holds everything above 99 ms
+
+    LatencyMonitor();
+    ~LatencyMonitor() override;
+
+    // Called from prepareToPlay - clears the histogram since results aren't comparable across setups
+    void setDeviceInfo(double sampleRate, int blockSize, int outputLatencySamples);
+
+    // --- Audio thread ---
+    // inputTicks:      juce::Time::getHighResolutionTicks() when the input event arrived
+    // callbackTicks:   the same clock, taken at the start of the audio callback
+    // sampleOffset:    index of the first non-zero sample inside that callback's block
+    void addMeasurement(juce::int64 inputTicks, juce::int64 callbackTicks, int sampleOffset, int inputPath) noexcept;
+
+    // --- Message thread ---
+    // While a reset is pending these read as empty, so the UI never sees half-cleared statistics
+    int    getBinCount(int binIndex) const noexcept { return isResetPending() ? 0 : bins[(size_t)binIndex].load(std::memory_order_relaxed); }
+    int    getTotalCount() const noexcept { return isResetPending() ? 0 : totalCount.load(std::memory_order_relaxed); }
+    double getMinimumMs() const noexcept { return isResetPending() ? 0.0 : minimumMs.load(std::memory_order_relaxed); }
+    double getMaximumMs() const noexcept { return isResetPending() ? 0.0 : maximumMs.load(std::memory_order_relaxed); }
+    double getMeanMs() const noexcept;
+    double getPercentileMs(double percentile) const noexcept; // Approximate, from the histogram
+    int    getBlockSize() const noexcept { return currentBlockSize.load(); }
+    int    getOutputLatencySamples() const noexcept { return outputLatencySamples.load(); }
+
+    // Any thread. The audio thread clears the statistics before its next measurement, so it
+    // stays their only writer.
+    void reset() noexcept { resetPending.store(true); }
+    juce::File getLogFile() const { return logFile; }
+
+    static const char* getInputPathName(int inputPath) noexcept;
+
+private:
+    struct Measurement
+    {
+        double latencyMs = 0.0;
+        int inputPath = computerKeyboard;
+        int blockSize = 0;
+        int outputLatencySamples = 0;
+        double sampleRate = 0.0;
+    };
+
+    bool isResetPending() const noexcept { return resetPending.load(); }
+    void clearStatistics() noexcept; // Audio thread only
+    void timerCallback() override; // Drains the FIFO into the log file
+    void writePendingMeasurements();
+
+    // Histogram (written by the audio thread, read by the UI)
+    std::array<std::atomic<int>, numBins> bins{};
+    std::atomic<int>    totalCount{ 0 };
+    std::atomic<juce::int64> sumMicroseconds{ 0 };
+    std::atomic<double> minimumMs{ 0.0 };
+    std::atomic<double> maximumMs{ 0.0 };
+    std::atomic<bool>   resetPending{ false };
+
+    // Current device setup
+    std::atomic<double> currentSampleRate{ 0.0 };
+    std::atomic<int>    currentBlockSize{ 0 };
+    std::atomic<int>    outputLatencySamples{ 0 };
+
+    // Measurements waiting to be written to disk
+    static constexpr int fifoSize = 1024;
+    juce::AbstractFifo pendingFifo{ fifoSize };
+    std::array<Measurement, fifoSize> pendingMeasurements;
+
+    juce::File logFile;
+    std::unique_ptr<juce::FileOutputStream> logStream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyMonitor)
+};
@@ -8,6 +8,23 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "StartupProfiler.h"
+#include "TraceRecorder.h"
+#include "PaintBenchmark.h"
+#include "BatchRenderer.h"
+#include <atomic>
+#include <csignal>
+
+namespace
+{
+    // Set from a signal handler, so nothing but a lock-free atomic store happens in there
+    std::atomic<bool> quitSignalled { false };
+
+    void handleQuitSignal (int)
+    {
+        quitSignalled.store (true);
+    }
+}
 
 //==============================================================================
 class NewProjectApplication  : public juce::JUCEApplication
@@ -24,8 +41,62 @@ public:
     void initialise (const juce::String& commandLine) override
     {
         // This method is where you should put your application's initialisation code..
+        StartupProfiler::mark ("initialise");
+
+        // --benchmark-fm measures FM voice throughput and exits without opening audio or a window
+        if (juce::ArgumentList ("CSYNTH", commandLine).containsOption ("--benchmark-fm"))
+        {
+            FmSynth::runBenchmark();
+            quit();
+            return;
+        }
+
+        // --benchmark-paint measures scope and controls paint time offscreen, then exits
+        if (juce::ArgumentList ("CSYNTH", commandLine).containsOption ("--benchmark-paint"))
+        {
+            PaintBenchmark::run();
+            quit();
+            return;
+        }
+
+        // --batch-render=<job list> renders presets to WAV files on every core, then exits (see BatchRenderer)
+        if (auto batchOptions = BatchRenderer::Options::fromCommandLine (commandLine))
+        {
+            setApplicationReturnValue (BatchRenderer::run (*batchOptions));
+            quit();
+            return;
+        }
+
+        // --print-stats reads the live statistics a running instance publishes, prints them and exits
+        if (juce::ArgumentList ("CSYNTH", commandLine).containsOption ("--print-stats"))
+        {
+            setApplicationReturnValue (StatsPublisher::printStats());
+            quit();
+            return;
+        }
+
+        // --trace records from launch; F9 in the window writes the trace out, and so does quitting (see shutdown)
+        if (juce::ArgumentList ("CSYNTH", commandLine).containsOption ("--trace"))
+            TraceRecorder::start();
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        // --virtual-audio runs on a virtual-clock device; --headless additionally skips the window
+        auto virtualAudio = VirtualAudioIODeviceType::Options::fromCommandLine (commandLine);
+
+        if (virtualAudio.has_value() && virtualAudio->headless)
+        {
+            headlessComponent = std::make_unique<MainComponent> (virtualAudio);
+
+            // With no window, Ctrl-C (or SIGTERM) ends a run that has no --run-seconds. It quits the
+            // normal way, so shutdown() still runs and writes a --trace capture.
+            std::signal (SIGINT, handleQuitSignal);
+            std::signal (SIGTERM, handleQuitSignal);
+            quitSignalPoller = std::make_unique<juce::TimedCallback> ([] { if (quitSignalled.load()) quit(); });
+            quitSignalPoller->startTimer (100);
+        }
+        else
+            mainWindow.reset (new MainWindow (getApplicationName(), virtualAudio));
+
+        StartupProfiler::mark ("window shown");
     }
 
     void shutdown() override
@@ -33,6 +104,13 @@ public:
         // Add your application's shutdown code here..
 
         mainWindow = nullptr; // (deletes our window)
+        quitSignalPoller = nullptr;
+        headlessComponent = nullptr;
+
+        // A --trace run nobody pressed F9 in (e.g. --headless, ended by --run-seconds or Ctrl-C) still gets its file
+        auto traceFile = TraceRecorder::stopAndWrite();
+        if (traceFile != juce::File())
+            juce::Logger::writeToLog ("Trace written to " + traceFile.getFullPathName());
     }
 
     //==============================================================================
@@ -58,14 +136,14 @@ public:
     class MainWindow    : public juce::DocumentWindow
     {
     public:
-        MainWindow (juce::String name)
+        MainWindow (juce::String name, std::optional<VirtualAudioIODeviceType::Options> virtualAudio)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (virtualAudio), true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
@@ -98,6 +176,8 @@ public:
 
 private:
     std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<MainComponent> headlessComponent; // --headless: audio runs, nothing on screen
+    std::unique_ptr<juce::TimedCallback> quitSignalPoller; // --headless: quits once Ctrl-C / SIGTERM arrived
 };
 
 //==============================================================================
@@ -1,14 +1,20 @@
 #include "MainComponent.h" // Includes ControlsComponent.h, SynthEngine.h implicitly now
+#include "InputHandler.h"
+#include "RealtimeSafetyChecker.h"
+#include "StartupProfiler.h"
+#include "TraceRecorder.h"
 #include <cmath>            // For std::pow, std::fmod, std::abs, std::sin
 #include <juce_audio_utils/juce_audio_utils.h> // For MidiMessage
 #include <juce_core/system/juce_TargetPlatform.h> // For DBG
 
 
 // --- REPLACE MainComponent Constructor ---
-MainComponent::MainComponent() :
+MainComponent::MainComponent(std::optional<VirtualAudioIODeviceType::Options> virtualAudio) :
     // REMOVE controlsPanel from initializer list
     smoothedLevel(0.75f)
 {
+    StartupProfiler::mark("members constructed");
+
     // --- Define Scale Patterns FIRST ---
     scaleData.push_back({ "Major",        { 0, 2, 4, 5, 7, 9, 11 } });
     scaleData.push_back({ "Natural Minor",{ 0, 2, 3, 5, 7, 8, 10 } });
@@ -20,6 +26,9 @@ MainComponent::MainComponent() :
         scaleNames.add(scaleInfo.name);
     // --- End Define Scale Patterns ---
 
+    // Computer keyboard input layer (reads scale/root, pushes note events for the audio thread)
+    inputHandler = std::make_unique<InputHandler>(keyboardEvents, scaleData, rootNote, currentScaleType);
+
     // --- NOW Create ControlsComponent using make_unique ---
     controlsPanel = std::make_unique<ControlsComponent>(this,
         currentWaveform,
@@ -33,27 +42,89 @@ MainComponent::MainComponent() :
 
     // Add and make child components visible
     addAndMakeVisible(oscilloscope);
+    addAndMakeVisible(spectrumView);
     addAndMakeVisible(*controlsPanel); // <-- Use * to dereference unique_ptr
+    addAndMakeVisible(latencyHistogram);
+    addAndMakeVisible(sequencerView);
+    sequencerView.onPatternChanged = [this] { publishSequencerPattern(); };
+    publishSequencerPattern();
 
     // Keyboard setup
     setWantsKeyboardFocus(true);
     addKeyListener(this); // Workaround
 
     // Window size
-    setSize(800, 550);
+    setSize(800, 770);
 
     // Set Default ADSR Parameters
     updateADSR(0.05f, 0.1f, 0.8f, 0.5f);
 
     // Set initial synth waveform
     synthEngine.setWaveform(currentWaveform.load());
+    synthEngine.setSampleStreamer(&sampleStreamer);
+    synthEngine.setWavetableBank(&wavetableBank);
+    synthEngine.setExpressionSource(&mpeInput);
+
+    StartupProfiler::mark("controls built");
+
+    // The default IR's partitions build on the reverb's loader thread while the device opens
+    reverb.prebuild(virtualAudio.has_value() ? virtualAudio->sampleRate : 48000.0);
+
+    // Initialize audio device - not here, but once the message loop is running, so the window
+    // shows up without waiting for device enumeration and opening
+    juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<MainComponent>(this), virtualAudio]
+    {
+        if (safeThis != nullptr)
+            safeThis->openAudioDevice(virtualAudio);
+    });
 
-    // Initialize audio device
-    setAudioChannels(0, 2);
+    if (virtualAudio.has_value() && virtualAudio->autoPlay)
+    {
+        autoPlayDriver = std::make_unique<juce::TimedCallback>([this] { autoPlayStep(); });
+        autoPlayDriver->startTimer(125);
+    }
+
+    // Writes the startup report once the first callback (and later the first sound) has happened
+    startupReportPoller = std::make_unique<juce::TimedCallback>([this]
+    {
+        if (StartupProfiler::reportIfReady())
+            startupReportPoller->stopTimer();
+    });
+    startupReportPoller->startTimer(50);
+
+    StartupProfiler::mark("MainComponent constructed");
+}
+
+void MainComponent::openAudioDevice(std::optional<VirtualAudioIODeviceType::Options> virtualAudio)
+{
+    StartupProfiler::mark("device open started");
+    statsPublisher.open(); // Before the first callback publishes; not in the constructor, so a benchmark's instance never takes the segment over
+
+    if (virtualAudio.has_value())
+    {
+        // Register the virtual-clock device and select it instead of the system default
+        auto deviceType = std::make_unique<VirtualAudioIODeviceType>(*virtualAudio);
+        auto deviceSetup = deviceType->createDeviceSetupXml();
+        deviceManager.addAudioDeviceType(std::move(deviceType));
+        setAudioChannels(0, 2, &deviceSetup);
+    }
+    else
+    {
+        setAudioChannels(0, 2);
+    }
+
+    StartupProfiler::mark("device opened");
+
+    // MIDI/MPE controllers
+    mpeInput.attachTo(deviceManager);
+    StartupProfiler::mark("MIDI inputs enabled");
 }
 
 MainComponent::~MainComponent() // No override needed on definition
 {
+    autoPlayDriver = nullptr;
+    startupReportPoller = nullptr;
+    mpeInput.detachFrom(deviceManager);
     removeKeyListener(this);
     shutdownAudio();
     // Child components (oscilloscope, controlsPanel, synthEngine) are direct members,
@@ -68,7 +139,8 @@ void MainComponent::setRootNote(int rootNoteIndex) // rootNoteIndex is 0-11
         rootNote.store(rootNoteIndex); // Store the 0-11 value
         DBG("MainComponent: Root Note set to index: " + juce::String(rootNoteIndex)
             + " (" + juce::MidiMessage::getMidiNoteName(rootNoteIndex, true, false, 3) + ")");
-        // Pitch of held note will update automatically via keyStateChanged check or next key press
+        // Held notes keep their pitch; the new root applies from the next key press
+        publishSequencerPattern();
     }
 }
 
@@ -82,7 +154,8 @@ void MainComponent::setScaleType(int scaleId) // scaleId is 1, 2, 3...
             currentScaleType.store(scaleId); // Store the ScaleType enum value
             DBG("MainComponent: Scale Type set to ID: " + juce::String(scaleId)
                 + " (" + scaleData[scaleId - 1].name + ")");
-            // Pitch of held note will update automatically via keyStateChanged check or next key press
+            // Held notes keep their pitch; the new scale applies from the next key press
+            publishSequencerPattern();
         }
     }
     else {
@@ -94,6 +167,7 @@ void MainComponent::setScaleType(int scaleId) // scaleId is 1, 2, 3...
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate) // No override definition
 {
     currentSampleRate = sampleRate; // Store sample rate
+    renderAhead.suspend(); // Its worker may be inside the engine - take it back before re-preparing
 
     // Prepare the level smoother
     smoothedLevel.reset(sampleRate, 0.02);
@@ -103,8 +177,24 @@ void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate
     int numOutputChannels = 2; // <<< FIXED: Use 2 directly since we called setAudioChannels(0, 2)
     synthEngine.prepareToPlay(sampleRate, samplesPerBlockExpected, numOutputChannels);
 
-    // Reset note state
-    currentlyPlayingNote = -1;
+    // Reset note state - anything queued belonged to the previous device session
+    keyboardEvents.clear();
+    mpeInput.getEventQueue().clear();
+    sequencer.prepare(sampleRate);
+    renderAhead.prepare(sampleRate, samplesPerBlockExpected);
+
+    // Latency measurements include what the device adds after our callback
+    int outputLatency = 0;
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        outputLatency = device->getOutputLatencyInSamples();
+    latencyMonitor.setDeviceInfo(sampleRate, samplesPerBlockExpected, outputLatency);
+    qualityGovernor.prepare(sampleRate, samplesPerBlockExpected);
+
+    recorder.prepare(sampleRate, numOutputChannels);
+    vocoder.prepare(sampleRate, samplesPerBlockExpected);
+    processingGraph.prepare(sampleRate, samplesPerBlockExpected);
+    reverb.prepare(sampleRate);
+    spectrumAnalyzer.setSampleRate(sampleRate);
 
     // Call update methods once initially AFTER prepareToPlay
     updateEnginePitch();
@@ -117,14 +207,54 @@ void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) // No override definition
 {
+    // Everything below runs on the audio thread - flag allocations/locks/syscalls when checks are enabled
+    const RealtimeSafetyChecker::ScopedAudioCallback realtimeScope;
+    TraceRecorder::labelThisThread("Audio callback");
+    const TraceRecorder::ScopedEvent trace("MainComponent::getNextAudioBlock");
+
+    // Taken first thing so key-to-sound latency covers the whole callback
+    auto callbackTicks = juce::Time::getHighResolutionTicks();
+    StartupProfiler::markFirstCallback();
+
     // Get buffer pointer and number of samples
     auto* buffer = bufferToFill.buffer;
     auto numSamples = buffer->getNumSamples();
     auto startSample = bufferToFill.startSample;
 
-    // --- 1. Let the SynthEngine render its output (Osc -> Filter -> ADSR) ---
-    // The engine handles its own internal state checks (e.g., adsr.isActive)
-    synthEngine.renderNextBlock(*buffer, startSample, numSamples);
+    // --- 0. Audio input arrives in the output buffer, which the engine is about to overwrite ---
+    vocoder.captureModulator(*buffer, startSample, numSamples);
+
+    // --- 0/1. Engine output: copied from the render-ahead ring while the worker owns the engine,
+    //          otherwise rendered right here (Osc -> Filter -> ADSR) ---
+    synthEngine.setQualityTier(qualityGovernor.getCurrentTier()); // Chosen from the previous blocks' load
+    auto suppliedSamples = renderAhead.readBlock(*buffer, startSample, numSamples);
+
+    NoteEvent noteEvent;
+    if (renderAhead.isWorkerRendering())
+    {
+        // Live input goes to the worker, which re-renders from the earliest point not yet played
+        while (keyboardEvents.pop(noteEvent))
+            renderAhead.pushLiveEvent(noteEvent);
+        while (mpeInput.getEventQueue().pop(noteEvent))
+            renderAhead.pushLiveEvent(noteEvent);
+    }
+    else
+    {
+        // Note events queued by the input layer since the last block (and any the worker didn't get to)
+        while (renderAhead.popLiveEvent(noteEvent))
+            applyInputEvent(noteEvent);
+        while (keyboardEvents.pop(noteEvent))
+            applyInputEvent(noteEvent);
+        while (mpeInput.getEventQueue().pop(noteEvent))
+            applyInputEvent(noteEvent);
+
+        renderEngine(*buffer, startSample + suppliedSamples, numSamples - suppliedSamples, callbackTicks);
+    }
+
+    // --- 1b. Master bus effects (the graph is a no-op until a patch is loaded, the reverb while its mix is at zero) ---
+    vocoder.process(*buffer, startSample, numSamples); // Live, so after render-ahead: the input can't be rendered early
+    processingGraph.process(*buffer, startSample, numSamples);
+    reverb.process(*buffer, startSample, numSamples);
 
     // --- 2. Apply the smoothed Master Level gain ---
     // Apply gain sample-by-sample using the SmoothedValue
@@ -145,7 +275,58 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
     oscilloscope.copySamples(leftChan, // Use the final processed left channel data
         numSamples,
         currentFreq); // Pass frequency to scope
+    spectrumAnalyzer.pushSamples(leftChan, numSamples); // Same tap; the FFT runs on the analyzer's thread
+    StartupProfiler::markOutput(leftChan, numSamples);
+
+    // --- 4. Hand the final master block to the recorder (lock-free, no-op when not recording) ---
+    const float* masterChannels[2] = { leftChan, rightChan != nullptr ? rightChan : leftChan };
+    recorder.writeBlock(masterChannels, 2, numSamples);
+
+    // --- 5. Measure this callback against its deadline (may change the tier for the next block) ---
+    auto blockLoad = qualityGovernor.endCallback(callbackTicks, numSamples);
+
+    // --- 6. Live statistics for external monitoring (a few stores into shared memory) ---
+    statsPublisher.publish(currentSampleRate, numSamples, blockLoad, qualityGovernor.getSmoothedLoad(),
+                           qualityGovernor.getCurrentTier(), synthEngine.getNumSoundingVoices(),
+                           buffer->getMagnitude(startSample, numSamples));
+}
+
+void MainComponent::applyInputEvent(const NoteEvent& event)
+{
+    if (! sequencer.handleInputEvent(event)) // The arpeggiator takes held keys for itself
+        synthEngine.handleNoteEvent(event);
 }
+
+void MainComponent::renderEngine(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, juce::int64 callbackTicks)
+{
+    // The engine handles its own internal state checks (e.g., adsr.isActive).
+    // The render is split at each sequencer event so steps start on their exact sample.
+    auto numSequencerEvents = sequencer.processBlock(numSamples, sequencerEvents);
+    int renderedSamples = 0;
+
+    for (int eventIndex = 0; eventIndex <= numSequencerEvents; ++eventIndex)
+    {
+        auto segmentEnd = eventIndex < numSequencerEvents ? sequencerEvents[(size_t)eventIndex].sampleOffset : numSamples;
+        if (segmentEnd > renderedSamples)
+        {
+            synthEngine.renderNextBlock(buffer, startSample + renderedSamples, segmentEnd - renderedSamples);
+
+            // If new notes became audible in this segment, record how long each took since its key press
+            // (not measured when rendering ahead - there's no callback to measure against)
+            juce::int64 inputTicks = 0;
+            int inputPath = 0, firstSoundOffset = 0;
+            while (synthEngine.popFirstSoundEvent(inputTicks, inputPath, firstSoundOffset))
+                if (callbackTicks != 0)
+                    latencyMonitor.addMeasurement(inputTicks, callbackTicks, renderedSamples + firstSoundOffset, inputPath);
+
+            renderedSamples = segmentEnd;
+        }
+
+        if (eventIndex < numSequencerEvents)
+            synthEngine.handleNoteEvent(sequencerEvents[(size_t)eventIndex].event);
+    }
+}
+
 void MainComponent::updateFilter(float cutoff, float resonance)
 {   
     DBG("MainComponent::updateFilter called. Cutoff=" + juce::String(cutoff) + ", Res=" + juce::String(resonance) + ". Calling synthEngine.setFilterParameters...");
@@ -155,6 +336,7 @@ void MainComponent::updateFilter(float cutoff, float resonance)
 
     // Tell the synth engine to update its internal filter parameters
     synthEngine.setFilterParameters(cutoff, resonance);
+    renderAhead.invalidate(); // Audio already rendered ahead has the old filter
 
     DBG("MainComponent: Filter updated - Cutoff: " + juce::String(cutoff, 1)
         + " Hz, Resonance: " + juce::String(resonance, 2));
@@ -180,6 +362,7 @@ void MainComponent::updateADSR(float attack, float decay, float sustain, float r
 
     // Tell the synth engine to update its parameters
     synthEngine.setParameters(newParams);
+    renderAhead.invalidate();
 
     DBG("MainComponent: ADSR Params Updated: A=" + juce::String(newParams.attack, 3)
         + " D=" + juce::String(newParams.decay, 3)
@@ -191,6 +374,7 @@ void MainComponent::setWaveform(int typeId)
 {
     currentWaveform.store(typeId); // Update our atomic state
     synthEngine.setWaveform(typeId); // Tell the engine
+    renderAhead.invalidate();
     DBG("MainComponent: Waveform set to ID: " + juce::String(typeId));
 }
 
@@ -215,6 +399,126 @@ void MainComponent::setTranspose(int semitones)
 }
 
 
+bool MainComponent::startRecording(int formatId)
+{
+    auto format = formatId == AudioRecorder::flac ? AudioRecorder::flac : AudioRecorder::wav;
+    return recorder.startRecording(AudioRecorder::getDefaultFile(format), format);
+}
+
+void MainComponent::stopRecording()
+{
+    recorder.stopRecording();
+}
+
+void MainComponent::setVoiceType(int voiceTypeId)
+{
+    synthEngine.setVoiceType(voiceTypeId);
+    renderAhead.invalidate();
+    DBG("MainComponent: Voice type set to ID: " + juce::String(voiceTypeId));
+}
+
+void MainComponent::setFmPatch(int patchIndex)
+{
+    synthEngine.setFmPatch(patchIndex);
+    renderAhead.invalidate();
+    DBG("MainComponent: FM patch set to " + juce::String(FmSynth::getPatch(patchIndex).name));
+}
+
+void MainComponent::setAdditivePreset(int presetIndex)
+{
+    synthEngine.setAdditivePreset(presetIndex);
+    renderAhead.invalidate();
+    DBG("MainComponent: Additive preset set to " + juce::String(AdditiveSynth::getPreset(presetIndex).name));
+}
+
+void MainComponent::setGranularPreset(int presetIndex)
+{
+    synthEngine.setGranularPreset(presetIndex);
+    renderAhead.invalidate();
+    DBG("MainComponent: Granular preset set to " + juce::String(GranularSynth::getPreset(presetIndex).name));
+}
+
+void MainComponent::loadSampleLibrary(const juce::File& folder)
+{
+    // The audio thread swaps the new library in at the start of a block once it's ready
+    sampleStreamer.loadLibraryAsync(folder);
+}
+
+void MainComponent::loadWavetable(const juce::File& file)
+{
+    // Mip levels are built in the background; the engine can use the table as soon as it's published
+    wavetableBank.loadAsync(file);
+}
+
+void MainComponent::setWavetablePosition(float position)
+{
+    synthEngine.setWavetablePosition(position);
+    renderAhead.invalidate();
+}
+
+void MainComponent::setReverbMix(float wetLevel)
+{
+    reverb.setMix(wetLevel);
+}
+
+void MainComponent::loadImpulseResponse(const juce::File& file)
+{
+    // Resampled and partitioned in the background, then swapped in between audio blocks
+    reverb.loadImpulseResponseAsync(file);
+}
+
+juce::String MainComponent::setVocoderBands(int numBands)
+{
+    vocoder.setNumBands(numBands);
+    return enableAudioInput(numBands > 0);
+}
+
+juce::String MainComponent::enableAudioInput(bool shouldBeEnabled)
+{
+    // Mobile platforms (and macOS sandboxes) ask the user first; the request calls back here once granted
+    if (shouldBeEnabled && juce::RuntimePermissions::isRequired(juce::RuntimePermissions::recordAudio)
+        && ! juce::RuntimePermissions::isGranted(juce::RuntimePermissions::recordAudio))
+    {
+        juce::Component::SafePointer<MainComponent> safeThis(this);
+        juce::RuntimePermissions::request(juce::RuntimePermissions::recordAudio, [safeThis](bool granted)
+        {
+            if (safeThis != nullptr && granted && safeThis->vocoder.getNumBands() > 0)
+                safeThis->enableAudioInput(true);
+        });
+        return "Waiting for microphone permission...";
+    }
+
+    // One input channel while the vocoder is on; the device restarts and prepareToPlay runs again
+    auto setup = deviceManager.getAudioDeviceSetup();
+    if (setup.inputChannels.countNumberOfSetBits() == (shouldBeEnabled ? 1 : 0) && ! setup.useDefaultInputChannels)
+        return {};
+
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels.clear();
+    if (shouldBeEnabled)
+    {
+        setup.inputChannels.setBit(0);
+        if (setup.inputDeviceName.isEmpty())
+            if (auto* type = deviceManager.getCurrentDeviceTypeObject())
+                setup.inputDeviceName = type->getDeviceNames(true)[juce::jmax(0, type->getDefaultDeviceIndex(true))];
+    }
+
+    auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    if (error.isEmpty() && shouldBeEnabled && deviceManager.getCurrentAudioDevice() != nullptr
+        && deviceManager.getCurrentAudioDevice()->getActiveInputChannels().isZero())
+        error = "No audio input available - the vocoder will stay silent";
+
+    DBG("MainComponent: audio input " + juce::String(shouldBeEnabled ? "on" : "off") + (error.isNotEmpty() ? " - " + error : juce::String()));
+    return error;
+}
+
+bool MainComponent::loadGraph(const juce::File& file)
+{
+    // Compiled here on the message thread; the audio thread only swaps the result in
+    return processingGraph.loadPatch(file);
+}
+
+
 //==============================================================================
 // --- Private helper method ---
 //==============================================================================
@@ -222,36 +526,77 @@ void MainComponent::setTranspose(int semitones)
 // --- ADD This Private Helper Method ---
 void MainComponent::updateEnginePitch()
 {
-    // Recalculates final frequency based on the *currently held base MIDI note*
-    // and the latest tuning/transpose values, then tells the synth engine.
+    // Each voice knows its own MIDI note; transpose and fine tune are a shared offset on top,
+    // so held notes follow the sliders immediately.
+    int currentTranspose = transposeSemitones.load();
+    float currentFineTune = fineTuneSemitones.load();
 
-    if (currentlyPlayingNote != -1 && currentSampleRate > 0.0)
-    {
-        int baseMidiNote = currentlyPlayingNote; // Note from scale mapping
-        int currentTranspose = transposeSemitones.load();
-        float currentFineTune = fineTuneSemitones.load();
+    synthEngine.setPitchOffset((float)currentTranspose + currentFineTune);
+    renderAhead.invalidate();
 
-        // Apply transpose first
-        int transposedMidiNote = juce::jlimit(0, 127, baseMidiNote + currentTranspose);
+    DBG("MainComponent::updateEnginePitch - Pitch offset set: " + juce::String((float)currentTranspose + currentFineTune, 2)
+        + " semitones (Trans=" + juce::String(currentTranspose) + ", Fine=" + juce::String(currentFineTune, 2) + ")");
+}
 
-        // Calculate frequency after transpose
-        double baseFrequency = juce::MidiMessage::getMidiNoteInHertz(transposedMidiNote);
+void MainComponent::publishSequencerPattern()
+{
+    // Scale degrees -> MIDI notes from C3 + root, so the pattern follows root and scale changes
+    auto pattern = std::make_unique<StepSequencer::Pattern>();
+    pattern->mode = sequencerView.getMode();
+    pattern->bpm = sequencerView.getBpm();
+    pattern->stepsPerBeat = sequencerView.getStepsPerBeat();
+    pattern->gate = sequencerView.getGate();
+    auto renderAheadWanted = sequencerView.isRenderAheadOn() && pattern->mode != StepSequencer::off;
+    pattern->numSteps = StepSequencerComponent::numSteps;
+
+    const auto& intervals = scaleData[(size_t)juce::jlimit(1, (int)scaleData.size(), currentScaleType.load()) - 1].intervals;
+    auto numIntervals = (int)intervals.size();
+    for (int step = 0; step < pattern->numSteps; ++step)
+    {
+        auto degree = sequencerView.getStepDegree(step);
+        if (degree >= 0)
+            pattern->steps[(size_t)step].midiNote = 48 + rootNote.load() + 12 * (degree / numIntervals) + intervals[(size_t)(degree % numIntervals)];
+    }
 
-        // Apply fine tuning
-        double adjustedFrequency = baseFrequency * std::pow(2.0, currentFineTune / 12.0);
+    sequencer.setPattern(std::move(pattern));
 
-        // Tell the synth engine the new final frequency
-        synthEngine.setFrequency(adjustedFrequency);
+    // Only sequenced playback is known far enough ahead to be worth rendering early
+    renderAhead.setEnabled(renderAheadWanted);
+    renderAhead.invalidate(); // Steps already rendered ahead follow the old pattern
+}
+
+// --- Auto-play (--auto-play with the virtual audio device) ---
+void MainComponent::autoPlayStep()
+{
+    // Release the previous note, then usually start another one from the current scale
+    NoteEvent event;
+    event.timestampTicks = juce::Time::getHighResolutionTicks();
+    event.inputPath = LatencyMonitor::computerKeyboard;
 
-        DBG("MainComponent::updateEnginePitch - Final Freq set: " + juce::String(adjustedFrequency, 2)
-            + " (BaseMIDI=" + juce::String(baseMidiNote) + ", Trans=" + juce::String(currentTranspose) + ", Fine=" + juce::String(currentFineTune, 2) + ")");
+    if (autoPlayNote >= 0)
+    {
+        event.type = NoteEvent::noteOff;
+        event.midiNote = autoPlayNote;
+        keyboardEvents.push(event);
+        autoPlayNote = -1;
     }
-    else
+
+    if (autoPlayRandom.nextInt(4) != 0) // Leave some gaps so releases get rendered too
     {
-        // If no note is playing, set engine frequency to 0
-        synthEngine.setFrequency(0.0);
-        // DBG("MainComponent::updateEnginePitch - No note playing, engine frequency set to 0.");
+        const auto& intervals = scaleData[(size_t)juce::jlimit(1, (int)scaleData.size(), currentScaleType.load()) - 1].intervals;
+        autoPlayNote = 48 + rootNote.load() + 12 * autoPlayRandom.nextInt(3)
+                     + intervals[(size_t)autoPlayRandom.nextInt((int)intervals.size())];
+
+        event.type = NoteEvent::noteOn;
+        event.midiNote = autoPlayNote;
+        event.velocity = 0.5f + 0.5f * autoPlayRandom.nextFloat();
+        if (! keyboardEvents.push(event))
+            autoPlayNote = -1;
     }
+
+    // Slow filter sweep, so the coefficient updates get exercised as well
+    auto sweepPhase = (double)juce::Time::getMillisecondCounter() * 0.0005;
+    updateFilter((float)(200.0 + 7800.0 * (0.5 + 0.5 * std::sin(sweepPhase))), filterResonance.load());
 }
 
 
@@ -279,11 +624,20 @@ void MainComponent::resized() // No override definition
     auto scopeHeight = 120; // Height for the oscilloscope
     // Use reduced bounds directly for placing first element
     auto scopeBounds = bounds.reduced(margin).removeFromTop(scopeHeight); // Reduce by margin first
-    oscilloscope.setBounds(scopeBounds);
+    // Oscilloscope on the left half, spectrum on the right
+    auto displayRow = scopeBounds;
+    oscilloscope.setBounds(displayRow.removeFromLeft((displayRow.getWidth() - margin) / 2));
+    spectrumView.setBounds(displayRow.withTrimmedLeft(margin));
 
     // Adjust remaining bounds - remove scope height AND margin below it
     bounds.removeFromTop(scopeBounds.getBottom() + margin); // Use scope's bottom edge + margin
 
+    // Latency histogram strip along the bottom, the sequencer above it
+    auto histogramHeight = 90;
+    latencyHistogram.setBounds(bounds.removeFromBottom(histogramHeight + margin).reduced(margin, 0).withTrimmedBottom(margin));
+    auto sequencerHeight = 110;
+    sequencerView.setBounds(bounds.removeFromBottom(sequencerHeight + margin).reduced(margin, 0).withTrimmedBottom(margin));
+
     // Controls panel takes remaining space at the bottom
     // Check if controlsPanel unique_ptr is valid before accessing
     if (controlsPanel != nullptr)
@@ -295,154 +649,40 @@ void MainComponent::resized() // No override definition
         DBG("MainComponent::resized() - Controls Bounds: " + controlsPanel->getBounds().toString());
 }
 
-// --- REPLACE keyPressed function ---
+// --- Key handling is delegated to the InputHandler ---
 bool MainComponent::keyPressed(const juce::KeyPress& key, juce::Component* /*originatingComponent*/) // No override definition
 {
-    int keyCode = key.getKeyCode();
-    // Check if key is *already* logically down according to our map
-    if (keysDown.count(keyCode) && keysDown[keyCode]) {
-        // DBG("keyPressed: Key code " + juce::String(keyCode) + " ignored (already down).");
-        return false; // Prevent auto-repeat trigger
-    }
+    const TraceRecorder::ScopedEvent trace("MainComponent::keyPressed");
 
-    // --- Map KeyCode to an index based on defined layout ---
-    const juce::String keyOrder = "QWERTYUIOPASDFGHJKLZXCVBNM"; // 26 keys
-    int keyIndex = keyOrder.indexOfChar((juce::juce_wchar)keyCode);
-
-    if (keyIndex == -1) // Key not in our defined layout
+    // F9 starts a trace capture, and F9 again writes it out
+    if (key == juce::KeyPress(juce::KeyPress::F9Key))
     {
-        // DBG("keyPressed: Key code " + juce::String(keyCode) + " (" + key.getTextDescription() + ") - Not in keyOrder map.");
-        return false;
-    }
-
-    DBG("keyPressed: Key code " + juce::String(keyCode) + " (" + key.getTextDescription() + ")");
-
-    // --- Calculate MIDI Note based on Root, Scale, and Key Index ---
-    int rootNoteIndex = rootNote.load(); // 0-11 (C=0)
-    int scaleTypeId = currentScaleType.load(); // 1=Major, 2=Minor, ...
-    int scalePatternIndex = scaleTypeId - 1; // Adjust for 0-based vector index
-
-    // Ensure scale pattern exists and is valid (size 7)
-    if (scalePatternIndex < 0 || scalePatternIndex >= scaleData.size() || scaleData[scalePatternIndex].intervals.size() != 7) {
-        DBG("  Invalid scale type selected or scaleData incorrect! ScaleID=" + juce::String(scaleTypeId));
-        // Maybe flash UI or log more prominently? For now, just don't play.
-        return false; // Cannot proceed
+        if (TraceRecorder::isRecording())
+            TraceRecorder::stopAndWrite();
+        else
+            TraceRecorder::start();
+        return true;
     }
-    const auto& intervals = scaleData[scalePatternIndex].intervals; // Get intervals {0, 2, 4...}
-
-    // Calculate reference MIDI note for 'A' key (index 10) - Root Note's pitch in octave closest to Middle C (60)
-    int refMidiNote = 12 * (int)std::round((60.0 - rootNoteIndex) / 12.0) + rootNoteIndex;
-    int refKeyIndex = keyOrder.indexOfChar('A'); // Should be 10
-
-    int offset = keyIndex - refKeyIndex; // Offset in scale steps from 'A' key
-
-    // Calculate octave shift and degree index within the scale pattern
-    int octaveShift = floor((double)offset / 7.0); // How many full octaves up/down relative to 'A's octave
-    int degreeIndex = ((offset % 7) + 7) % 7; // Index within the 7 scale intervals (0-6)
-
-    // Get the interval (in semitones) from the root for this scale degree
-    int interval = intervals[degreeIndex];
-
-    // Calculate the final base MIDI note number (Root's Octave + Octave Shift + Interval)
-    int finalMidiNote = refMidiNote + (octaveShift * 12) + interval; // intervals[0] is 0
-
-    // Clamp to valid MIDI range
-    finalMidiNote = juce::jlimit(0, 127, finalMidiNote);
-
-    // --- Store state and trigger sound ---
-    keysDown[keyCode] = true; // Mark key down in our map NOW
-    currentlyPlayingNote = finalMidiNote; // Store the base MIDI note being played
-
-    updateEnginePitch(); // Calculate final freq (incl tune/transpose) and tell engine
-    synthEngine.setWaveform(currentWaveform.load()); // Ensure waveform is set
-    synthEngine.noteOn(); // Tell engine to start ADSR
 
-    DBG("  Key Mapped: Key='" + key.getTextDescription() + "', Offset=" + juce::String(offset)
-        + ", OctShift=" + juce::String(octaveShift) + ", DegIdx=" + juce::String(degreeIndex)
-        + ", Interval=" + juce::String(interval) + ", FinalMIDI=" + juce::String(finalMidiNote)
-        + ", ADSR Note ON");
-
-    return true; // Handled
+    return inputHandler->handleKeyPress(key);
 }
 
-
-// --- REPLACE keyStateChanged function ---
-// --- REPLACE keyStateChanged function ---
-bool MainComponent::keyStateChanged(bool /*isKeyDown*/, juce::Component* /*originatingComponent*/) // No override definition
+bool MainComponent::keyStateChanged(bool isKeyDown, juce::Component* /*originatingComponent*/) // No override definition
 {
-    // DBG("keyStateChanged called."); // Keep commented unless needed for detailed debug
-    bool shouldBePlaying = false;
-    int lastKeyDownCode = -1;
-    int highestKeyIndex = -1; // Track index of highest priority key still down
-
-    const juce::String keyOrder = "QWERTYUIOPASDFGHJKLZXCVBNM";
+    const TraceRecorder::ScopedEvent trace("MainComponent::keyStateChanged");
+    return inputHandler->handleKeyStateChange(isKeyDown);
+}
 
-    // Check which keys *we care about* are still physically down
-    for (auto it = keysDown.begin(); it != keysDown.end(); ) {
-        int currentKeyCode = it->first;
-        if (juce::KeyPress::isKeyCurrentlyDown(currentKeyCode)) {
-            shouldBePlaying = true;
-            it->second = true; // Update map state
-            int currentKeyIndex = keyOrder.indexOfChar((juce::juce_wchar)currentKeyCode);
-            if (currentKeyIndex > highestKeyIndex) { // Track the highest index found
-                highestKeyIndex = currentKeyIndex;
-                lastKeyDownCode = currentKeyCode; // Store the code of the highest key
-            }
-            ++it;
-        }
-        else {
-            // If key is UP, remove it from our map of tracked keys
-             // DBG("  Key Up detected in keyStateChanged: " + juce::String(currentKeyCode));
-            it = keysDown.erase(it); // Erase returns iterator to the next element
-        }
-    }
+// Key-ups never arrive once keyboard focus has left the window (another app, a dialog), so
+// anything still held is released then. Focus moving between our own children keeps notes held.
+void MainComponent::focusLost(FocusChangeType) // No override definition
+{
+    if (! hasKeyboardFocus(true))
+        inputHandler->releaseAllKeys();
+}
 
-    if (shouldBePlaying) {
-        // --- Handle potential note change if multiple keys were held ---
-        int rootNoteIndex = rootNote.load();
-        int scaleTypeId = currentScaleType.load();
-        int scalePatternIndex = juce::jlimit(0, (int)scaleData.size() - 1, scaleTypeId - 1);
-
-        // Safety check scale data
-        if (scaleData.empty() || scalePatternIndex >= scaleData.size() || scaleData[scalePatternIndex].intervals.size() != 7) {
-            DBG("  keyStateChanged: Invalid scale data! Forcing note off.");
-            if (currentlyPlayingNote != -1) {
-                synthEngine.noteOff();
-                currentlyPlayingNote = -1;
-                updateEnginePitch(); // Tell engine freq is 0
-            }
-            return true;
-        }
-        const auto& intervals = scaleData[scalePatternIndex].intervals;
-        int refMidiNote = 12 * (int)std::round((60.0 - rootNoteIndex) / 12.0) + rootNoteIndex;
-        int refKeyIndex = keyOrder.indexOfChar('A');
-        int offset = highestKeyIndex - refKeyIndex;
-        int octaveShift = floor((double)offset / 7.0);
-        int degreeIndex = ((offset % 7) + 7) % 7;
-        int interval = intervals[degreeIndex];
-        int newMidiNote = juce::jlimit(0, 127, refMidiNote + (octaveShift * 12) + interval);
-
-        // Check if the highest sounding note has changed
-        if (newMidiNote != currentlyPlayingNote) {
-            currentlyPlayingNote = newMidiNote; // Store the new note
-            updateEnginePitch(); // Recalculate final freq and tell engine
-            synthEngine.setWaveform(currentWaveform.load()); // Ensure waveform correct
-            // Optional: Retrigger ADSR? Let's keep legato feel for now.
-            // synthEngine.noteOn();
-            DBG("  Note Changed/Retriggered: New MIDI=" + juce::String(currentlyPlayingNote));
-        }
-        // If the same note is still held, do nothing - ADSR continues
-    }
-    else // --- All relevant keys are now released ---
-    {
-        if (currentlyPlayingNote != -1) // Only trigger noteOff if a note was actually playing
-        {
-            DBG("  All relevant keys released. Triggering ADSR Note OFF.");
-            synthEngine.noteOff(); // <<< Trigger ADSR Release >>>
-            currentlyPlayingNote = -1; // Mark no note as playing
-            // --- REMOVED resetting targetFrequency and angleDelta here ---
-            // updateEnginePitch(); // Call this to tell engine frequency is now 0
-        }
-    }
-    return true; // Handled state change
-}
\ No newline at end of file
+void MainComponent::focusOfChildComponentChanged(FocusChangeType) // No override definition
+{
+    if (! hasKeyboardFocus(true))
+        inputHandler->releaseAllKeys();
+}
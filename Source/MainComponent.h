@@ -5,7 +5,6 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_events/juce_events.h>
 #include <juce_dsp/juce_dsp.h>
-#include <map>
 #include <vector>           // <-- Added for std::vector
 #include <atomic>
 #include <JuceHeader.h>     // Keep this, includes many things
@@ -13,6 +12,27 @@
 #include "OscilloscopeComponent.h"
 #include "ControlsComponent.h"      // Need full definition because ControlsComponent is a direct member
 #include "SynthEngine.h"          // Need full definition because SynthEngine is a direct member
+#include "LatencyMonitor.h"
+#include "LatencyHistogramComponent.h"
+#include "NoteEventQueue.h"
+#include "AudioRecorder.h"
+#include "SampleStreamer.h"
+#include "WavetableBank.h"
+#include "ConvolutionReverb.h"
+#include "ProcessingGraph.h"
+#include "Vocoder.h"
+#include "SpectrumAnalyzer.h"
+#include "SpectrumAnalyzerComponent.h"
+#include "VirtualAudioDevice.h"
+#include "QualityGovernor.h"
+#include "StepSequencer.h"
+#include "StepSequencerComponent.h"
+#include "MpeInput.h"
+#include "RenderAhead.h"
+#include "StatsPublisher.h"
+#include <optional>
+
+class InputHandler; // Includes MainComponent.h itself, so held via unique_ptr
 
 //==============================================================================
 class MainComponent : public juce::AudioAppComponent,
@@ -40,7 +60,8 @@ public:
     // --- End Scale Information ---
 
     //==============================================================================
-    MainComponent();
+    // With virtualAudio set, plays through a VirtualAudioIODevice instead of the system device
+    explicit MainComponent(std::optional<VirtualAudioIODeviceType::Options> virtualAudio = std::nullopt);
     ~MainComponent() override;
 
     // --- Public methods for ControlsComponent callbacks ---
@@ -51,6 +72,26 @@ public:
     void updateFilter(float cutoff, float resonance);
     void setRootNote(int rootNoteIndex); // 0-11 for C to B <-- NEW
     void setScaleType(int scaleId);      // Use ScaleType enum values <-- NEW
+    bool startRecording(int formatId);   // AudioRecorder::Format; writes to the default recordings folder
+    void stopRecording();
+    bool isRecording() const { return recorder.isRecording(); }
+    void setVoiceType(int voiceTypeId);  // SynthEngine::VoiceType
+    void setFmPatch(int patchIndex);     // 0 to FmSynth::numAlgorithms - 1
+    void setAdditivePreset(int presetIndex); // 0 to AdditiveSynth::numPresets - 1
+    void setGranularPreset(int presetIndex); // 0 to GranularSynth::numPresets - 1
+    void loadSampleLibrary(const juce::File& folder); // Loads in the background, see getSampleStatusText
+    juce::String getSampleStatusText() const { return sampleStreamer.getStatusText(); }
+    bool isSampleLibraryLoading() const { return sampleStreamer.isLoading(); }
+    void loadWavetable(const juce::File& file);       // Becomes a new waveform ID once built, see getWavetableBank
+    void setWavetablePosition(float position);        // 0-1 frame morph
+    const WavetableBank& getWavetableBank() const { return wavetableBank; }
+    void setReverbMix(float wetLevel);                // 0 = off
+    void loadImpulseResponse(const juce::File& file);
+    juce::String getReverbStatusText() const { return reverb.getStatusText(); }
+    bool isImpulseResponseLoading() const { return reverb.isLoading(); }
+    bool loadGraph(const juce::File& file);           // Master bus patch, crossfaded in; false on a patch error
+    juce::String getGraphStatusText() const { return processingGraph.getStatusText(); }
+    juce::String setVocoderBands(int numBands);       // 0 = off; opens the audio input when on. Returns an error, if any
 
     // --- Getters for ControlsComponent initialization ---
     int getRootNote() const { return rootNote.load(); }         // <-- NEW Getter
@@ -73,6 +114,8 @@ public:
     // Component overrides (Keep override in declaration)
     void paint(juce::Graphics& g) override;
     void resized() override;
+    void focusLost(FocusChangeType cause) override;
+    void focusOfChildComponentChanged(FocusChangeType cause) override;
 
     //==============================================================================
     // KeyListener overrides (NO override in declaration for now)
@@ -99,19 +142,72 @@ private:
     std::atomic<int>   rootNote{ 0 }; // 0-11 (Default C=0) <-- NEW State
     std::atomic<int>   currentScaleType{ ScaleType::Major }; // Default Major=1 <-- NEW State
 
-    // Keyboard State Tracking
-    std::map<int, bool> keysDown;
-    int                 currentlyPlayingNote = -1; // Base MIDI note (0-127) determined by key+scale+root
+    // Keyboard input: InputHandler owns the key state and pushes into this queue, the audio thread drains it
+    NoteEventQueue keyboardEvents;
+    std::unique_ptr<InputHandler> inputHandler;
+
+    // MIDI/MPE controllers: note events via its own queue, per-note expression via atomics (outlives the engine)
+    MpeInput mpeInput;
+
+    // Sample-accurate sequencer/arpeggiator, run from the audio callback
+    StepSequencer sequencer;
+    StepSequencer::EventList sequencerEvents; // Audio thread scratch
+
+    // Disk-streamed sample playback (outlives the engine, which holds a pointer to it)
+    SampleStreamer sampleStreamer;
+
+    // User wavetables, listed after the fixed waveforms (also outlives the engine)
+    WavetableBank wavetableBank;
 
     // Core Synthesis
     SynthEngine synthEngine; // Direct member based on your uploaded code
 
+    // Master bus effects: the vocoder, the patched graph, then the reverb
+    Vocoder vocoder;
+    ProcessingGraph processingGraph;
+    ConvolutionReverb reverb;
+
+    // Key-to-sound latency instrumentation
+    LatencyMonitor latencyMonitor;
+
+    // Steps the engine down to cheaper kernels when the callback nears its deadline
+    QualityGovernor qualityGovernor;
+
+    // Renders the sequencer + engine ahead on a worker while sequenced playback is on (see the toggle)
+    RenderAhead renderAhead{ synthEngine, sequencer,
+                             [this](juce::AudioBuffer<float>& buffer, int start, int num) { renderEngine(buffer, start, num, 0); } };
+
+    // Live statistics in shared memory, for external monitoring (see --print-stats)
+    StatsPublisher statsPublisher;
+
+    // Master output capture
+    AudioRecorder recorder;
+
+    // Master output spectrum (analysis runs on its own thread)
+    SpectrumAnalyzer spectrumAnalyzer;
+
     // Child Components
     OscilloscopeComponent oscilloscope; // Direct member
+    SpectrumAnalyzerComponent spectrumView{ spectrumAnalyzer };
     std::unique_ptr<ControlsComponent> controlsPanel; // Use unique_ptr
+    LatencyHistogramComponent latencyHistogram{ latencyMonitor };
+    StepSequencerComponent sequencerView{ sequencer };
+
+    // --auto-play: plays notes and sweeps the filter so unattended runs exercise the engine
+    std::unique_ptr<juce::TimedCallback> autoPlayDriver;
+    std::unique_ptr<juce::TimedCallback> startupReportPoller;
+    juce::Random autoPlayRandom;
+    int autoPlayNote = -1;
 
-    // Private methods (updateEnginePitch is needed by setters/key handlers)
+    // Private methods (updateEnginePitch is needed by the tune/transpose setters)
     void updateEnginePitch();
+    void publishSequencerPattern(); // Editor state + root/scale -> StepSequencer
+    void autoPlayStep();
+    void applyInputEvent(const NoteEvent& event); // Arpeggiator first, then the engine
+    // Sequencer + engine for one stretch of the buffer; callbackTicks = 0 when rendering ahead
+    void renderEngine(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, juce::int64 callbackTicks);
+    void openAudioDevice(std::optional<VirtualAudioIODeviceType::Options> virtualAudio); // Deferred from the constructor
+    juce::String enableAudioInput(bool shouldBeEnabled);  // The vocoder's modulator; output-only otherwise
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
@@ -0,0 +1,156 @@
+#include "MpeInput.h"
+#include "LatencyMonitor.h"
+
+//==============================================================================
+MpeInput::MpeInput()
+{
+    slotNoteIds.fill(freeSlot);
+    slotMidiNotes.fill(-1);
+
+    // Standard MPE lower zone: master channel 1, members 2-16. Controllers that send an MPE
+    // Configuration Message re-set this themselves; plain MIDI keyboards on channel 1 play as usual.
+    juce::MPEZoneLayout layout;
+    layout.setLowerZone(15);
+    instrument.setZoneLayout(layout);
+    instrument.addListener(this);
+}
+
+MpeInput::~MpeInput()
+{
+    instrument.removeListener(this);
+}
+
+void MpeInput::attachTo(juce::AudioDeviceManager& deviceManager)
+{
+    for (const auto& device : juce::MidiInput::getAvailableDevices())
+    {
+        deviceManager.setMidiInputDeviceEnabled(device.identifier, true);
+        DBG("MpeInput: Listening to " + device.name);
+    }
+
+    deviceManager.addMidiInputDeviceCallback({}, this); // {} = every enabled input
+}
+
+void MpeInput::detachFrom(juce::AudioDeviceManager& deviceManager)
+{
+    deviceManager.removeMidiInputDeviceCallback({}, this);
+}
+
+//==============================================================================
+void MpeInput::handleIncomingMidiMessage(juce::MidiInput* /*source*/, const juce::MidiMessage& message)
+{
+    // The instrument calls back into the listener methods below, on this thread
+    instrument.processNextMidiEvent(message);
+}
+
+int MpeInput::findSlot(juce::uint16 noteID) const noexcept
+{
+    for (int slot = 0; slot < numExpressionSlots; ++slot)
+        if (slotNoteIds[(size_t)slot] == (int)noteID)
+            return slot;
+    return -1;
+}
+
+void MpeInput::storeExpression(int slot, const juce::MPENote& note) noexcept
+{
+    auto& expression = expressionSlots[(size_t)slot];
+    expression.pitchBendSemitones.store((float)note.totalPitchbendInSemitones, std::memory_order_relaxed);
+    expression.pressure.store(note.pressure.asUnsignedFloat(), std::memory_order_relaxed);
+    expression.timbre.store(note.timbre.asUnsignedFloat(), std::memory_order_relaxed);
+}
+
+int MpeInput::allocateSlot() noexcept
+{
+    // Round-robin from the last allocation. First choice is a slot whose note is released and silent.
+    for (int i = 0; i < numExpressionSlots; ++i)
+    {
+        auto candidate = (nextSlot + i) % numExpressionSlots;
+        if (slotNoteIds[(size_t)candidate] == freeSlot && ! slotSounding[(size_t)candidate].load())
+            return candidate;
+    }
+
+    // Every slot is held or still in its release: take over the oldest release tail
+    for (int i = 0; i < numExpressionSlots; ++i)
+    {
+        auto candidate = (nextSlot + i) % numExpressionSlots;
+        if (slotNoteIds[(size_t)candidate] == freeSlot)
+            return candidate;
+    }
+
+    // All held: the oldest position is stolen. Its note is released now, since its own
+    // note-off won't find the slot any more and would otherwise leave the voice stuck.
+    auto slot = nextSlot;
+    NoteEvent event;
+    event.type = NoteEvent::noteOff;
+    event.midiNote = slotMidiNotes[(size_t)slot];
+    event.timestampTicks = juce::Time::getHighResolutionTicks();
+    event.inputPath = LatencyMonitor::midiInput;
+    event.expressionSlot = slot;
+    if (! events.push(event))
+        DBG("MpeInput::allocateSlot - Event queue full, stolen note's note-off dropped");
+    return slot;
+}
+
+void MpeInput::noteAdded(juce::MPENote newNote)
+{
+    auto slot = allocateSlot();
+    nextSlot = (slot + 1) % numExpressionSlots;
+    slotNoteIds[(size_t)slot] = (int)newNote.noteID;
+    slotMidiNotes[(size_t)slot] = newNote.initialNote;
+    slotSounding[(size_t)slot].store(true); // Before the note-on, so the audio thread can only clear it after
+
+    // Initial expression goes in before the note-on, so the voice starts from the right values
+    storeExpression(slot, newNote);
+
+    NoteEvent event;
+    event.type = NoteEvent::noteOn;
+    event.midiNote = newNote.initialNote;
+    event.velocity = juce::jmax(0.01f, newNote.noteOnVelocity.asUnsignedFloat());
+    event.timestampTicks = juce::Time::getHighResolutionTicks();
+    event.inputPath = LatencyMonitor::midiInput;
+    event.expressionSlot = slot;
+
+    if (! events.push(event))
+        DBG("MpeInput::noteAdded - Event queue full, note dropped");
+}
+
+void MpeInput::notePressureChanged(juce::MPENote changedNote)
+{
+    if (auto slot = findSlot(changedNote.noteID); slot >= 0)
+        expressionSlots[(size_t)slot].pressure.store(changedNote.pressure.asUnsignedFloat(), std::memory_order_relaxed);
+}
+
+void MpeInput::notePitchbendChanged(juce::MPENote changedNote)
+{
+    if (auto slot = findSlot(changedNote.noteID); slot >= 0)
+        expressionSlots[(size_t)slot].pitchBendSemitones.store((float)changedNote.totalPitchbendInSemitones, std::memory_order_relaxed);
+}
+
+void MpeInput::noteTimbreChanged(juce::MPENote changedNote)
+{
+    if (auto slot = findSlot(changedNote.noteID); slot >= 0)
+        expressionSlots[(size_t)slot].timbre.store(changedNote.timbre.asUnsignedFloat(), std::memory_order_relaxed);
+}
+
+void MpeInput::noteReleased(juce::MPENote finishedNote)
+{
+    // No slot: it was stolen, and the note released with it. A note-off without a slot would
+    // release every voice on this pitch, including other channels' notes.
+    auto slot = findSlot(finishedNote.noteID);
+    if (slot < 0)
+        return;
+
+    NoteEvent event;
+    event.type = NoteEvent::noteOff;
+    event.midiNote = finishedNote.initialNote;
+    event.timestampTicks = juce::Time::getHighResolutionTicks();
+    event.inputPath = LatencyMonitor::midiInput;
+    event.expressionSlot = slot;
+
+    if (! events.push(event))
+        DBG("MpeInput::noteReleased - Event queue full, note-off dropped");
+
+    // The slot keeps its last values for the voice's release tail. It is handed out again
+    // once the engine reports that voice silent (markSlotIdle).
+    slotNoteIds[(size_t)slot] = freeSlot;
+}
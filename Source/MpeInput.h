@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "NoteEventQueue.h"
+
+//==============================================================================
+/*
+    MIDI / MPE input layer.
+
+    Incoming MIDI (on the MIDI device thread) is fed through a juce::MPEInstrument,
+    which handles the zone layout, per-channel and master pitch bend ranges and
+    note tracking. Its note callbacks turn into NoteEvents on a lock-free queue
+    for the audio thread, just like the computer keyboard's.
+
+    Per-note expression (pitch bend, pressure, timbre/CC74) does not go through
+    the queue. Each sounding MPE note owns an expression slot of atomics that
+    the MIDI thread simply overwrites; voices read their slot once per block.
+    A dense controller stream therefore costs the audio thread nothing extra -
+    only the latest value per note is ever looked at.
+
+    A slot stays with its note until the note has been released and the engine
+    reports that the voice playing it has gone silent (markSlotIdle), so a new
+    note never takes over the bend or timbre of a release tail.
+*/
+class MpeInput : public juce::MidiInputCallback,
+    private juce::MPEInstrument::Listener
+{
+public:
+    static constexpr int numExpressionSlots = 32; // Sounding MPE notes tracked at once
+
+    struct NoteExpression
+    {
+        std::atomic<float> pitchBendSemitones{ 0.0f }; // Per-note plus master bend, in the zone's range
+        std::atomic<float> pressure{ 0.0f };           // 0-1
+        std::atomic<float> timbre{ 0.5f };             // 0-1, CC74 (0.5 = neutral)
+    };
+
+    MpeInput();
+    ~MpeInput() override;
+
+    // Enables every MIDI input the device manager knows about and starts listening to them
+    void attachTo(juce::AudioDeviceManager& deviceManager);
+    void detachFrom(juce::AudioDeviceManager& deviceManager);
+
+    // --- Audio thread ---
+    NoteEventQueue& getEventQueue() noexcept { return events; }
+    const NoteExpression& getExpression(int slot) const noexcept { return expressionSlots[(size_t)slot]; }
+    // The slot's note-off has been handled and no voice plays it any more: it can be handed out again
+    void markSlotIdle(int slot) noexcept { slotSounding[(size_t)slot].store(false); }
+
+    // MidiInputCallback (MIDI device thread)
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+
+private:
+    // MPEInstrument::Listener (called from handleIncomingMidiMessage)
+    void noteAdded(juce::MPENote newNote) override;
+    void notePressureChanged(juce::MPENote changedNote) override;
+    void notePitchbendChanged(juce::MPENote changedNote) override;
+    void noteTimbreChanged(juce::MPENote changedNote) override;
+    void noteReleased(juce::MPENote finishedNote) override;
+
+    int  findSlot(juce::uint16 noteID) const noexcept;
+    int  allocateSlot() noexcept;
+    void storeExpression(int slot, const juce::MPENote& note) noexcept;
+
+    juce::MPEInstrument instrument;
+    NoteEventQueue events;
+    std::array<NoteExpression, numExpressionSlots> expressionSlots;
+    std::array<std::atomic<bool>, numExpressionSlots> slotSounding{}; // Set at note-on, cleared by the audio thread
+
+    // MIDI thread only: which held MPE note owns each slot (and its pitch), and where to look for a free one next
+    static constexpr int freeSlot = -1;                 // No held note; may still be sounding its release
+    std::array<int, numExpressionSlots> slotNoteIds;
+    std::array<int, numExpressionSlots> slotMidiNotes;
+    int nextSlot = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MpeInput)
+};
@@ -0,0 +1,30 @@
+#include "NoteEventQueue.h"
+
+//==============================================================================
+bool NoteEventQueue::push(const NoteEvent& event) noexcept
+{
+    const auto scope = fifo.write(1);
+    if (scope.blockSize1 > 0)
+    {
+        events[(size_t)scope.startIndex1] = event;
+        return true;
+    }
+    return false;
+}
+
+bool NoteEventQueue::pop(NoteEvent& event) noexcept
+{
+    const auto scope = fifo.read(1);
+    if (scope.blockSize1 > 0)
+    {
+        event = events[(size_t)scope.startIndex1];
+        return true;
+    }
+    return false;
+}
+
+void NoteEventQueue::clear() noexcept
+{
+    NoteEvent discarded;
+    while (pop(discarded)) {}
+}
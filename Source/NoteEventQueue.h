@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/*
+    A note event travelling from an input source to the audio thread.
+*/
+struct NoteEvent
+{
+    enum Type
+    {
+        noteOn = 0,
+        noteOff,
+        allNotesOff
+    };
+
+    Type        type = noteOn;
+    int         midiNote = 60;
+    float       velocity = 1.0f;
+    juce::int64 timestampTicks = 0; // juce::Time::getHighResolutionTicks() when the input arrived
+    int         inputPath = 0;      // LatencyMonitor::InputPath of the source
+    int         expressionSlot = -1; // MpeInput expression slot of an MPE note (-1 = no per-note expression)
+};
+
+//==============================================================================
+/*
+    Fixed-capacity, lock-free single-producer/single-consumer queue of NoteEvents.
+    One thread pushes (e.g. the message thread handling key presses), the audio
+    thread pops at the start of each block. Never allocates after construction.
+*/
+class NoteEventQueue
+{
+public:
+    static constexpr int capacity = 256;
+
+    NoteEventQueue() = default;
+
+    // Producer side. Returns false (and drops the event) if the queue is full.
+    bool push(const NoteEvent& event) noexcept;
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(NoteEvent& event) noexcept;
+
+    // Consumer side. Throws away anything queued, e.g. after a device restart.
+    void clear() noexcept;
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo{ capacity };
+    std::array<NoteEvent, capacity> events;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteEventQueue)
+};
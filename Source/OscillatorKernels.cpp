@@ -0,0 +1,19 @@
+#include "OscillatorKernels.h"
+
+namespace OscillatorKernels
+{
+    namespace
+    {
+        // [precision][shape], in enum order
+        constexpr Kernel kernels[numPrecisions][numShapes] =
+        {
+            { render<sine, double>, render<square, double>, render<saw, double>, render<triangle, double> },
+            { render<sine, float>,  render<square, float>,  render<saw, float>,  render<triangle, float>  },
+        };
+    }
+
+    Kernel getKernel(Shape shape, Precision precision) noexcept
+    {
+        return kernels[(size_t)precision][(size_t)shape];
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <type_traits>
+
+//==============================================================================
+/*
+    The fixed-shape oscillator kernels (sine, square, saw, triangle) used by
+    SynthEngine's oscillator voices.
+
+    Phase is a 32-bit unsigned accumulator: one cycle is 2^32, and wrapping
+    is integer overflow, so nothing is reduced with fmod and a note held
+    for hours stays exactly on pitch. Sample i of a block reads
+    phase + i * increment, which doesn't depend on the sample before it.
+    Each shape is a few multiplies, an abs and a select, with no branches,
+    so the compiler vectorises the loops.
+
+    Kernels are templated on the shape and on the precision the waveform is
+    computed in:
+    - double: full quality, with a sine polynomial accurate to ~1e-11
+    - float: the cheaper quality tiers, accurate to ~1e-7
+    SynthEngine picks one from the table once per voice per block.
+*/
+namespace OscillatorKernels
+{
+    enum Shape { sine, square, saw, triangle, numShapes };
+    enum Precision { doublePrecision, floatPrecision, numPrecisions };
+
+    // Writes numSamples of the shape and advances phase
+    using Kernel = void (*)(float* output, int numSamples, juce::uint32& phase, juce::uint32 increment) noexcept;
+
+    Kernel getKernel(Shape shape, Precision precision) noexcept;
+
+    // Accumulator step for a frequency (full cycle = 2^32; resolution ~1e-5 Hz at 48 kHz)
+    inline juce::uint32 getIncrement(double frequency, double sampleRate) noexcept
+    {
+        auto cycles = frequency / sampleRate;
+        return (juce::uint32)(juce::int64)((cycles - std::floor(cycles)) * 4294967296.0);
+    }
+
+    //==============================================================================
+    // sin(2 pi x) for x in [-0.5, 0.5): fold into [-0.25, 0.25], then an odd Taylor polynomial
+    template <typename SampleType>
+    inline SampleType sinCycles(SampleType x) noexcept
+    {
+        constexpr auto quarter = (SampleType)0.25;
+        auto folded = quarter - std::abs(quarter - std::abs(x)); // sin(pi - t) = sin(t)
+        auto t = juce::MathConstants<SampleType>::twoPi * (x < 0 ? -folded : folded);
+        auto u = -t * t;
+
+        // Horner, sin t = t (1 - t^2/3! + t^4/5! - ...): double runs to t^15, float to t^11 (past that float can't tell)
+        auto sum = (SampleType)(1.0 / 39916800.0);
+        if constexpr (std::is_same_v<SampleType, double>)
+            sum = ((SampleType)(1.0 / 1307674368000.0) * u + (SampleType)(1.0 / 6227020800.0)) * u + sum;
+        sum = sum * u + (SampleType)(1.0 / 362880.0);
+        sum = sum * u + (SampleType)(1.0 / 5040.0);
+        sum = sum * u + (SampleType)(1.0 / 120.0);
+        sum = sum * u + (SampleType)(1.0 / 6.0);
+        sum = sum * u + (SampleType)1;
+        return t * sum;
+    }
+
+    template <int ShapeValue, typename SampleType>
+    void render(float* output, int numSamples, juce::uint32& phase, juce::uint32 increment) noexcept
+    {
+        constexpr auto scale = (SampleType)(1.0 / 2147483648.0); // 2^-31
+        const auto start = phase;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto p = start + increment * (juce::uint32)i;        // Wraps for free
+            auto bipolar = (SampleType)(juce::int32)(p ^ 0x80000000u) * scale; // 2 * phase - 1, in [-1, 1)
+
+            SampleType value;
+            if constexpr (ShapeValue == square)
+                value = (SampleType)1 - (SampleType)2 * (SampleType)(juce::int32)(p >> 31);
+            else if constexpr (ShapeValue == saw)
+                value = bipolar;
+            else if constexpr (ShapeValue == triangle)
+                value = (SampleType)1 - (SampleType)2 * std::abs(bipolar);
+            else
+                value = sinCycles((SampleType)(juce::int32)p * (scale * (SampleType)0.5)); // Signed phase, [-0.5, 0.5)
+
+            output[i] = (float)value;
+        }
+
+        phase = start + increment * (juce::uint32)numSamples;
+    }
+}
@@ -1,4 +1,6 @@
 #include "OscilloscopeComponent.h"
+#include "RealtimeSafetyChecker.h"
+#include "TraceRecorder.h"
 #include <juce_core/system/juce_TargetPlatform.h> // For DBG
 
 //==============================================================================
@@ -17,6 +19,8 @@ OscilloscopeComponent::~OscilloscopeComponent() // No override needed on definit
 // --- UPDATE paint function ---
 void OscilloscopeComponent::paint(juce::Graphics& g) // No override needed on definition
 {
+    const TraceRecorder::ScopedEvent trace("OscilloscopeComponent::paint");
+
     // 1. Fill background
     g.fillAll(juce::Colours::black);
 
@@ -91,12 +95,14 @@ void OscilloscopeComponent::copySamples(const float* sourceSamples, int numSourc
     {
         // Clear display buffer if no real data came in? Or just let old data persist?
         // Let's clear it for now if no samples are valid.
+        RealtimeSafetyChecker::noteLockAcquisition("OscilloscopeComponent::bufferLock (juce::SpinLock)");
         const juce::SpinLock::ScopedLockType lock(bufferLock);
         displayBuffer.clear();
         return;
     }
 
     // Safely write sample data to the displayBuffer
+    RealtimeSafetyChecker::noteLockAcquisition("OscilloscopeComponent::bufferLock (juce::SpinLock)");
     const juce::SpinLock::ScopedLockType lock(bufferLock);
 
     int samplesToCopy = juce::jmin(numSourceSamples, bufferSize);
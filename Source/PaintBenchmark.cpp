@@ -0,0 +1,85 @@
+#include "PaintBenchmark.h"
+#include "MainComponent.h" // For the Waveform and ScaleType enums
+#include "OscilloscopeComponent.h"
+#include "ControlsComponent.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr int warmUpFrames = 10;
+    constexpr int measuredFrames = 200;
+
+    // Paints component (and its children) into a same-sized software image; beforeFrame runs outside the timing
+    template <typename BeforeFrame>
+    void measure(juce::Component& component, const char* name, int width, int height, BeforeFrame&& beforeFrame)
+    {
+        component.setBounds(0, 0, width, height);
+        juce::Image image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+        std::vector<double> frameMs;
+        frameMs.reserve((size_t)measuredFrames);
+
+        for (int frame = 0; frame < warmUpFrames + measuredFrames; ++frame)
+        {
+            beforeFrame(frame);
+            image.clear(image.getBounds());
+
+            auto startMs = juce::Time::getMillisecondCounterHiRes();
+            {
+                juce::Graphics g(image);
+                component.paintEntireComponent(g, true);
+            }
+            if (frame >= warmUpFrames)
+                frameMs.push_back(juce::Time::getMillisecondCounterHiRes() - startMs);
+        }
+
+        std::sort(frameMs.begin(), frameMs.end());
+        auto meanMs = 0.0;
+        for (auto ms : frameMs)
+            meanMs += ms;
+        meanMs /= (double)frameMs.size();
+
+        juce::Logger::writeToLog("  " + juce::String(name).paddedRight(' ', 14)
+                                 + (juce::String(width) + "x" + juce::String(height)).paddedRight(' ', 11)
+                                 + "mean " + juce::String(meanMs, 3) + " ms, median " + juce::String(frameMs[frameMs.size() / 2], 3)
+                                 + " ms, p95 " + juce::String(frameMs[frameMs.size() * 95 / 100], 3) + " ms");
+    }
+}
+
+//==============================================================================
+void PaintBenchmark::run()
+{
+    juce::Logger::writeToLog("Paint benchmark: " + juce::String(measuredFrames) + " frames per size, software renderer");
+
+    // --- Oscilloscope: a new waveform every frame, sized like the default window and 2x / 4x of it ---
+    {
+        OscilloscopeComponent scope;
+        std::vector<float> samples(512);
+        auto feedScope = [&](int frame)
+        {
+            // Three harmonics with a moving phase, so every frame builds a different path
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                auto phase = juce::MathConstants<float>::twoPi * ((float)i / 128.0f + (float)frame * 0.01f);
+                samples[i] = 0.6f * std::sin(phase) + 0.2f * std::sin(2.0f * phase) + 0.1f * std::sin(3.0f * phase);
+            }
+            scope.copySamples(samples.data(), (int)samples.size(), 440.0f);
+        };
+
+        for (auto scale : { 1, 2, 4 })
+            measure(scope, "Oscilloscope", 385 * scale, 120 * scale, feedScope);
+    }
+
+    // --- Controls: every slider, selector and label, at the default layout and 2x / 4x of it. ---
+    // --- No MainComponent behind them: its loader and worker threads would run during the timing. ---
+    {
+        std::atomic<int> waveform{ MainComponent::sine }, transpose{ 0 }, rootNote{ 0 }, scaleType{ MainComponent::Major };
+        std::atomic<float> fineTune{ 0.0f }, cutoff{ 10000.0f }, resonance{ 0.707f };
+        juce::SmoothedValue<float> level(0.75f);
+
+        ControlsComponent controls(nullptr, waveform, level, fineTune, transpose, cutoff, resonance, rootNote, scaleType);
+        for (auto scale : { 1, 2, 4 })
+            measure(controls, "Controls", 780 * scale, 400 * scale, [](int) {});
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    GUI cost, measured apart from the audio: --benchmark-paint.
+
+    Builds an OscilloscopeComponent and a ControlsComponent offscreen and
+    paints each one, with its children, into a software juce::Image,
+    repeatedly and at several sizes. The scope gets fresh synthetic
+    waveform data before every frame, as it would while a note plays.
+    Reports mean, median and 95th-percentile milliseconds per frame to the
+    Logger, so changes to path building or control layout can be compared
+    against a saved run.
+
+    Runs inside initialise(), before the message loop, so no audio device
+    is opened and no timers fire while it measures. The controls are built
+    without a MainComponent, so none of its loader or worker threads run
+    alongside the paints either.
+*/
+class PaintBenchmark
+{
+public:
+    static void run();
+
+private:
+    PaintBenchmark() = delete;
+};
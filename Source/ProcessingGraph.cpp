@@ -0,0 +1,616 @@
+#include "ProcessingGraph.h"
+#include "OscillatorKernels.h"
+#include <juce_dsp/juce_dsp.h> // For StateVariableTPTFilter
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    using Node = ProcessingGraph::Node;
+
+    //==============================================================================
+    class OscillatorNode : public Node
+    {
+    public:
+        OscillatorNode(OscillatorKernels::Shape s, double frequencyHz, float levelToUse)
+            : shape(s), frequency(frequencyHz), level(levelToUse) {}
+
+        void prepare(double sampleRate) override
+        {
+            kernel = OscillatorKernels::getKernel(shape, OscillatorKernels::doublePrecision);
+            increment = OscillatorKernels::getIncrement(frequency, sampleRate);
+            phase = 0;
+        }
+
+        void process(const float* const*, int, float* output, int numSamples) noexcept override
+        {
+            kernel(output, numSamples, phase, increment);
+            juce::FloatVectorOperations::multiply(output, level, numSamples);
+        }
+
+    private:
+        OscillatorKernels::Shape shape;
+        double frequency;
+        float level;
+        OscillatorKernels::Kernel kernel = nullptr;
+        juce::uint32 phase = 0, increment = 0;
+    };
+
+    class FilterNode : public Node
+    {
+    public:
+        FilterNode(juce::dsp::StateVariableTPTFilterType t, float cutoffHz, float resonanceToUse)
+            : type(t), cutoff(cutoffHz), resonance(resonanceToUse) {}
+
+        void prepare(double sampleRate) override
+        {
+            filter.prepare({ sampleRate, 512, 1 }); // Block size is unused; processSample only
+            filter.setType(type);
+            filter.setCutoffFrequency(juce::jmin(cutoff, (float)sampleRate * 0.45f)); // Below Nyquist at any rate
+            filter.setResonance(resonance);
+            filter.reset();
+        }
+
+        void process(const float* const* inputs, int, float* output, int numSamples) noexcept override
+        {
+            const auto* input = inputs[0];
+            for (int i = 0; i < numSamples; ++i)
+                output[i] = filter.processSample(0, input[i]);
+        }
+
+    private:
+        juce::dsp::StateVariableTPTFilterType type;
+        float cutoff, resonance;
+        juce::dsp::StateVariableTPTFilter<float> filter;
+    };
+
+    class DelayNode : public Node
+    {
+    public:
+        DelayNode(double timeSeconds, float feedbackToUse, float mixToUse)
+            : time(timeSeconds), feedback(feedbackToUse), mix(mixToUse) {}
+
+        void prepare(double sampleRate) override
+        {
+            line.assign((size_t)juce::jmax(1, juce::roundToInt(time * sampleRate)), 0.0f);
+            position = 0;
+        }
+
+        void process(const float* const* inputs, int, float* output, int numSamples) noexcept override
+        {
+            const auto* input = inputs[0];
+            const auto length = (int)line.size();
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto dry = input[i];
+                auto delayed = line[(size_t)position]; // Written exactly `length` samples ago
+                line[(size_t)position] = dry + delayed * feedback;
+                position = position + 1 < length ? position + 1 : 0;
+                output[i] = dry + (delayed - dry) * mix;
+            }
+        }
+
+    private:
+        double time;
+        float feedback, mix;
+        std::vector<float> line;
+        int position = 0;
+    };
+
+    class GainNode : public Node
+    {
+    public:
+        explicit GainNode(float levelToUse) : level(levelToUse) {}
+
+        void prepare(double) override {}
+
+        void process(const float* const* inputs, int, float* output, int numSamples) noexcept override
+        {
+            juce::FloatVectorOperations::multiply(output, inputs[0], level, numSamples);
+        }
+
+    private:
+        float level;
+    };
+
+    class MixerNode : public Node
+    {
+    public:
+        explicit MixerNode(float levelToUse) : level(levelToUse) {}
+
+        void prepare(double) override {}
+
+        void process(const float* const* inputs, int numInputs, float* output, int numSamples) noexcept override
+        {
+            // Sample by sample across the inputs, since output may be any one of them
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto sum = 0.0f;
+                for (int input = 0; input < numInputs; ++input)
+                    sum += inputs[input][i];
+                output[i] = sum * level;
+            }
+        }
+
+    private:
+        float level;
+    };
+
+    //==============================================================================
+    // A "node" line, before compiling
+    struct NodeSpec
+    {
+        juce::String name, type;
+        juce::StringPairArray parameters;
+        juce::Array<int> sources;   // Spec indices, in connection order
+        int lineNumber = 0;
+    };
+
+    // Checks a node's parameters against the ones its type has, then builds it
+    std::unique_ptr<Node> createNode(const NodeSpec& spec, juce::String& error)
+    {
+        auto accept = [&](std::initializer_list<const char*> known)
+        {
+            for (const auto& key : spec.parameters.getAllKeys())
+                if (std::none_of(known.begin(), known.end(), [&](const char* name) { return key == name; }))
+                {
+                    error = "line " + juce::String(spec.lineNumber) + ": " + spec.type + " has no parameter '" + key + "'";
+                    return false;
+                }
+            return true;
+        };
+
+        auto number = [&](const char* key, double defaultValue, double minimum, double maximum)
+        {
+            auto text = spec.parameters.getValue(key, {});
+            return text.isEmpty() ? defaultValue : juce::jlimit(minimum, maximum, text.getDoubleValue());
+        };
+
+        auto choice = [&](const char* key, const juce::StringArray& options, int& index)
+        {
+            auto text = spec.parameters.getValue(key, options[0]);
+            index = options.indexOf(text, true);
+            if (index < 0)
+                error = "line " + juce::String(spec.lineNumber) + ": " + key + " must be one of " + options.joinIntoString(", ");
+            return index >= 0;
+        };
+
+        auto numSources = spec.sources.size();
+        auto needsSources = [&](int minimum, int maximum)
+        {
+            if (numSources >= minimum && numSources <= maximum)
+                return true;
+            error = "line " + juce::String(spec.lineNumber) + ": " + spec.type + " '" + spec.name + "' takes "
+                  + (minimum == maximum ? juce::String(minimum) : juce::String(minimum) + " to " + juce::String(maximum))
+                  + " inputs, not " + juce::String(numSources);
+            return false;
+        };
+
+        int index = 0;
+        if (spec.type == "oscillator")
+        {
+            if (! accept({ "shape", "frequency", "level" }) || ! needsSources(0, 0)
+                || ! choice("shape", { "sine", "square", "saw", "triangle" }, index))
+                return nullptr;
+            return std::make_unique<OscillatorNode>((OscillatorKernels::Shape)index, number("frequency", 110.0, 0.01, 20000.0),
+                                                    (float)number("level", 0.5, 0.0, 4.0));
+        }
+
+        if (spec.type == "filter")
+        {
+            if (! accept({ "mode", "cutoff", "resonance" }) || ! needsSources(1, 1)
+                || ! choice("mode", { "lowpass", "highpass", "bandpass" }, index))
+                return nullptr;
+            const juce::dsp::StateVariableTPTFilterType types[] = { juce::dsp::StateVariableTPTFilterType::lowpass,
+                                                                    juce::dsp::StateVariableTPTFilterType::highpass,
+                                                                    juce::dsp::StateVariableTPTFilterType::bandpass };
+            return std::make_unique<FilterNode>(types[index], (float)number("cutoff", 1000.0, 20.0, 20000.0),
+                                                (float)number("resonance", 1.0 / juce::MathConstants<double>::sqrt2, 0.1, 10.0));
+        }
+
+        if (spec.type == "delay")
+        {
+            if (! accept({ "time", "feedback", "mix" }) || ! needsSources(1, 1))
+                return nullptr;
+            return std::make_unique<DelayNode>(number("time", 0.25, 0.001, 4.0), (float)number("feedback", 0.3, 0.0, 0.98),
+                                               (float)number("mix", 0.3, 0.0, 1.0));
+        }
+
+        if (spec.type == "gain")
+        {
+            if (! accept({ "level" }) || ! needsSources(1, 1))
+                return nullptr;
+            return std::make_unique<GainNode>((float)number("level", 1.0, 0.0, 4.0));
+        }
+
+        if (spec.type == "mixer")
+        {
+            if (! accept({ "level" }) || ! needsSources(1, ProcessingGraph::maxInputs))
+                return nullptr;
+            return std::make_unique<MixerNode>((float)number("level", 1.0, 0.0, 4.0));
+        }
+
+        error = "line " + juce::String(spec.lineNumber) + ": unknown node type '" + spec.type + "'";
+        return nullptr;
+    }
+}
+
+//==============================================================================
+ProcessingGraph::~ProcessingGraph()
+{
+    stopTimer();
+    deleteAllGraphs();
+}
+
+void ProcessingGraph::deleteAllGraphs()
+{
+    delete activeGraph;
+    delete fadingGraph;
+    delete pendingGraph.exchange(nullptr);
+    delete retiredGraph.exchange(nullptr);
+    activeGraph = fadingGraph = nullptr;
+    fadeSamplesRemaining = 0;
+}
+
+void ProcessingGraph::prepare(double sampleRate, int maximumBlockSize)
+{
+    const juce::ScopedLock lock(patchLock);
+    deleteAllGraphs();
+
+    currentSampleRate = sampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    fadeBlock.assign((size_t)maxBlockSize, 0.0f);
+    fadeLength = juce::jmax(1, juce::roundToInt(crossfadeSeconds * sampleRate));
+
+    // The patch compiled before, so only the rate-dependent parts (delay lines, increments) change
+    if (currentPatch.isNotEmpty())
+    {
+        juce::String error;
+        activeGraph = compile(currentPatch, currentSampleRate, maxBlockSize, error).release();
+        statusText = activeGraph != nullptr ? currentName + ": " + activeGraph->summary : currentName + ": " + error;
+    }
+}
+
+//==============================================================================
+bool ProcessingGraph::loadPatch(const juce::File& file)
+{
+    if (! file.existsAsFile())
+    {
+        const juce::ScopedLock lock(patchLock);
+        statusText = "Graph " + file.getFullPathName() + " not found";
+        return false;
+    }
+
+    return setPatch(file.loadFileAsString(), file.getFileNameWithoutExtension());
+}
+
+bool ProcessingGraph::setPatch(const juce::String& patchText, const juce::String& name)
+{
+    const juce::ScopedLock lock(patchLock);
+
+    juce::String error;
+    auto graph = compile(patchText, currentSampleRate, maxBlockSize, error);
+    if (graph == nullptr)
+    {
+        statusText = name + ": " + error; // The running graph stays as it is
+        DBG("ProcessingGraph: " + statusText);
+        return false;
+    }
+
+    currentPatch = patchText;
+    currentName = name;
+    statusText = graph->summary.isEmpty() ? juce::String("No graph") : name + ": " + graph->summary;
+    DBG("ProcessingGraph: " + statusText);
+
+    // A graph the audio thread hasn't picked up yet is simply replaced
+    delete retiredGraph.exchange(nullptr);
+    delete pendingGraph.exchange(graph.release());
+
+    idleTimerTicks = 0;
+    startTimerHz(10);
+    return true;
+}
+
+juce::String ProcessingGraph::getStatusText() const
+{
+    const juce::ScopedLock lock(patchLock);
+    return statusText;
+}
+
+void ProcessingGraph::timerCallback()
+{
+    delete retiredGraph.exchange(nullptr);
+
+    // Keep going until the audio thread has taken the graph and (well after) finished the fade
+    if (pendingGraph.load() != nullptr)
+        idleTimerTicks = 0;
+    else if (++idleTimerTicks >= 5)
+        stopTimer();
+}
+
+//==============================================================================
+std::unique_ptr<ProcessingGraph::CompiledGraph> ProcessingGraph::compile(const juce::String& patchText, double sampleRate,
+                                                                         int maximumBlockSize, juce::String& error)
+{
+    // --- Parse ---
+    std::vector<NodeSpec> specs;
+    int outputSpec = -1, inputSpec = -1;
+
+    auto findSpec = [&](const juce::String& name)
+    {
+        for (size_t i = 0; i < specs.size(); ++i)
+            if (specs[i].name == name)
+                return (int)i;
+        return -1;
+    };
+
+    auto lines = juce::StringArray::fromLines(patchText);
+    for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens(lines[lineIndex].upToFirstOccurrenceOf("#", false, false), " \t", "");
+        tokens.removeEmptyStrings();
+        if (tokens.isEmpty())
+            continue;
+
+        auto lineNumber = lineIndex + 1;
+        auto fail = [&](const juce::String& message)
+        {
+            error = "line " + juce::String(lineNumber) + ": " + message;
+            return nullptr;
+        };
+
+        auto keyword = tokens[0].toLowerCase();
+        if (keyword == "node")
+        {
+            if (tokens.size() < 3)
+                return fail("expected node <name> <type> [parameter=value ...]");
+            if (findSpec(tokens[1]) >= 0)
+                return fail("there is already a node called '" + tokens[1] + "'");
+
+            NodeSpec spec;
+            spec.name = tokens[1];
+            spec.type = tokens[2].toLowerCase();
+            spec.lineNumber = lineNumber;
+            for (int i = 3; i < tokens.size(); ++i)
+            {
+                if (! tokens[i].containsChar('='))
+                    return fail("expected parameter=value, not '" + tokens[i] + "'");
+                spec.parameters.set(tokens[i].upToFirstOccurrenceOf("=", false, false).toLowerCase(),
+                                    tokens[i].fromFirstOccurrenceOf("=", false, false).toLowerCase());
+            }
+
+            if (spec.type == "input")
+            {
+                if (inputSpec >= 0)
+                    return fail("only one input node per graph");
+                if (spec.parameters.size() > 0)
+                    return fail("input has no parameters");
+                inputSpec = (int)specs.size();
+            }
+            specs.push_back(spec);
+        }
+        else if (keyword == "connect")
+        {
+            if (tokens.size() != 4 || tokens[2] != "->")
+                return fail("expected connect <from> -> <to>");
+            auto from = findSpec(tokens[1]), to = findSpec(tokens[3]);
+            if (from < 0 || to < 0)
+                return fail("no node called '" + tokens[from < 0 ? 1 : 3] + "' (nodes must be declared first)");
+            if (to == inputSpec)
+                return fail("the input node takes no inputs");
+            if (specs[(size_t)to].sources.contains(from))
+                return fail(tokens[1] + " is already connected to " + tokens[3]);
+            specs[(size_t)to].sources.add(from);
+        }
+        else if (keyword == "output")
+        {
+            if (tokens.size() != 2 || findSpec(tokens[1]) < 0)
+                return fail("expected output <declared node>");
+            if (outputSpec >= 0)
+                return fail("the graph already has an output");
+            outputSpec = findSpec(tokens[1]);
+        }
+        else
+        {
+            return fail("unknown statement '" + tokens[0] + "' (node, connect or output)");
+        }
+    }
+
+    auto graph = std::make_unique<CompiledGraph>();
+    if (specs.empty())
+    {
+        graph->bufferPointers.resize(1);
+        return graph; // Empty patch: pass-through, with an empty summary
+    }
+
+    if (outputSpec < 0)
+    {
+        error = "no output line";
+        return nullptr;
+    }
+
+    // --- Schedule: depth-first post-order from the output, which also drops unreachable nodes ---
+    std::vector<int> order, state(specs.size(), 0); // 0 unvisited, 1 on the current path, 2 scheduled
+    juce::String cycleNode;
+    std::function<bool(int)> visit = [&](int index)
+    {
+        if (state[(size_t)index] == 2)
+            return true;
+        if (state[(size_t)index] == 1)
+        {
+            cycleNode = specs[(size_t)index].name;
+            return false;
+        }
+
+        state[(size_t)index] = 1;
+        for (auto source : specs[(size_t)index].sources)
+            if (! visit(source))
+                return false;
+        state[(size_t)index] = 2;
+        order.push_back(index);
+        return true;
+    };
+
+    if (! visit(outputSpec))
+    {
+        error = "the graph has a cycle through '" + cycleNode + "' (use a delay's feedback for feedback)";
+        return nullptr;
+    }
+
+    // --- Nodes, in schedule order (the input has no step: its result is the block itself) ---
+    std::vector<int> stepOfSpec(specs.size(), -1);
+    std::vector<int> scheduledSpecs;
+    for (auto index : order)
+    {
+        if (index == inputSpec)
+            continue;
+
+        auto node = createNode(specs[(size_t)index], error);
+        if (node == nullptr)
+            return nullptr;
+        node->prepare(sampleRate);
+
+        stepOfSpec[(size_t)index] = (int)graph->steps.size();
+        graph->steps.push_back({ node.get() });
+        graph->nodes.push_back(std::move(node));
+        scheduledSpecs.push_back(index);
+    }
+
+    // --- Liveness: each result lives until the last step that reads it (the output's, to the end) ---
+    const auto numSteps = (int)graph->steps.size();
+    std::vector<int> lastUse(specs.size(), -1);
+    for (int step = 0; step < numSteps; ++step)
+        for (auto source : specs[(size_t)scheduledSpecs[(size_t)step]].sources)
+            lastUse[(size_t)source] = step;
+    lastUse[(size_t)outputSpec] = numSteps;
+
+    // --- Buffers: reuse one as soon as its result is dead. Buffer 0, the block itself, is preferred,
+    //     so a chain of effects runs in place and the result usually needs no final copy. ---
+    std::vector<int> bufferOfSpec(specs.size(), -1);
+    std::vector<int> freeBuffers;
+    int numBuffers = 1;
+    if (inputSpec >= 0 && state[(size_t)inputSpec] == 2)
+        bufferOfSpec[(size_t)inputSpec] = 0;
+    else
+        freeBuffers.push_back(0); // The engine's output isn't used: its block is free from the start
+
+    for (int step = 0; step < numSteps; ++step)
+    {
+        const auto& spec = specs[(size_t)scheduledSpecs[(size_t)step]];
+        auto& scheduled = graph->steps[(size_t)step];
+
+        for (auto source : spec.sources)
+        {
+            scheduled.inputs[(size_t)scheduled.numInputs++] = bufferOfSpec[(size_t)source];
+            if (lastUse[(size_t)source] == step)
+                freeBuffers.push_back(bufferOfSpec[(size_t)source]); // Dead after this step: the output may take it
+        }
+
+        int buffer;
+        if (freeBuffers.empty())
+        {
+            buffer = numBuffers++;
+        }
+        else
+        {
+            auto best = std::min_element(freeBuffers.begin(), freeBuffers.end()); // Lowest index, so 0 if it's free
+            buffer = *best;
+            freeBuffers.erase(best);
+        }
+
+        scheduled.output = buffer;
+        bufferOfSpec[(size_t)scheduledSpecs[(size_t)step]] = buffer;
+    }
+
+    graph->outputBuffer = bufferOfSpec[(size_t)outputSpec];
+    graph->scratch.setSize(juce::jmax(1, numBuffers - 1), juce::jmax(1, maximumBlockSize));
+    graph->scratch.clear();
+    graph->bufferPointers.resize((size_t)numBuffers);
+    for (int buffer = 1; buffer < numBuffers; ++buffer)
+        graph->bufferPointers[(size_t)buffer] = graph->scratch.getWritePointer(buffer - 1);
+
+    graph->summary = juce::String(numSteps) + (numSteps == 1 ? " node, " : " nodes, ")
+                   + juce::String(numBuffers - 1) + (numBuffers == 2 ? " scratch buffer" : " scratch buffers");
+    if ((int)order.size() < (int)specs.size())
+        graph->summary << " (" << (int)(specs.size() - order.size()) << " unconnected)";
+    return graph;
+}
+
+//==============================================================================
+void ProcessingGraph::CompiledGraph::process(float* block, int numSamples) noexcept
+{
+    bufferPointers[0] = block;
+
+    for (const auto& step : steps)
+    {
+        const float* inputs[maxInputs];
+        for (int i = 0; i < step.numInputs; ++i)
+            inputs[i] = bufferPointers[(size_t)step.inputs[(size_t)i]];
+        step.node->process(inputs, step.numInputs, bufferPointers[(size_t)step.output], numSamples);
+    }
+
+    if (outputBuffer != 0)
+        juce::FloatVectorOperations::copy(block, bufferPointers[(size_t)outputBuffer], numSamples);
+}
+
+void ProcessingGraph::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // No patch has ever been loaded: nothing to do
+    if (activeGraph == nullptr && fadeSamplesRemaining == 0 && pendingGraph.load() == nullptr)
+        return;
+
+    auto* block = buffer.getWritePointer(0, startSample);
+    for (int done = 0; done < numSamples;)
+    {
+        auto chunk = juce::jmin(maxBlockSize, numSamples - done);
+        processChunk(block + done, chunk);
+        done += chunk;
+    }
+
+    // The master is mono
+    for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+        buffer.copyFrom(channel, startSample, buffer, 0, startSample, numSamples);
+}
+
+void ProcessingGraph::processChunk(float* block, int numSamples) noexcept
+{
+    // A new graph starts fading in only once the last fade is over and its graph has been deleted
+    if (fadeSamplesRemaining == 0 && retiredGraph.load() == nullptr)
+    {
+        if (auto* next = pendingGraph.exchange(nullptr))
+        {
+            fadingGraph = activeGraph;
+            activeGraph = next;
+            fadeSamplesRemaining = fadeLength;
+        }
+    }
+
+    // During a fade the old graph runs on a copy of the same input
+    if (fadeSamplesRemaining > 0)
+    {
+        juce::FloatVectorOperations::copy(fadeBlock.data(), block, numSamples);
+        if (fadingGraph != nullptr)
+            fadingGraph->process(fadeBlock.data(), numSamples);
+    }
+
+    if (activeGraph != nullptr)
+        activeGraph->process(block, numSamples);
+
+    if (fadeSamplesRemaining > 0)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto oldWeight = (float)fadeSamplesRemaining / (float)fadeLength;
+            block[i] += (fadeBlock[(size_t)i] - block[i]) * oldWeight;
+            if (fadeSamplesRemaining > 0)
+                --fadeSamplesRemaining;
+        }
+
+        if (fadeSamplesRemaining == 0)
+        {
+            retiredGraph.store(fadingGraph); // Deleted by the timer (null when the old state was pass-through)
+            fadingGraph = nullptr;
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    A modular processing graph for the master bus. It sits between the
+    engine output and the reverb. With no graph loaded it does nothing.
+
+    A patch is a text file of nodes and connections:
+
+        # '#' starts a comment
+        node engine input                                  # the engine's output
+        node drone  oscillator shape=saw frequency=55 level=0.05
+        node tone   filter mode=lowpass cutoff=900 resonance=2
+        node sum    mixer
+        node echo   delay time=0.375 feedback=0.35 mix=0.25
+        connect engine -> sum
+        connect drone -> tone
+        connect tone -> sum
+        connect sum -> echo
+        output echo
+
+    Node types, with their parameters:
+      input       the engine's output (no parameters, one per graph)
+      oscillator  shape=sine|square|saw|triangle, frequency (Hz), level
+      filter      mode=lowpass|highpass|bandpass, cutoff (Hz), resonance
+      delay       time (s), feedback, mix
+      gain        level
+      mixer       level; sums up to maxInputs inputs
+
+    The patch is compiled on the message thread into a flat schedule.
+    Compiling drops nodes that don't reach the output, rejects cycles (a
+    delay node is the way to get feedback), and orders the rest
+    depth-first. Depth-first order keeps the fewest results alive at once.
+    Each step's output buffer is then assigned by liveness analysis. A
+    buffer is reused as soon as the last step reading it has run, so a
+    step may write over its own input. The engine's block counts as one of
+    the buffers, which makes a chain of effects run in place with no
+    scratch memory at all.
+
+    The audio thread only walks the schedule: no allocation, no lookups,
+    no virtual calls beyond one per node. A new patch is handed over
+    through an atomic pointer and crossfaded in over crossfadeSeconds,
+    with the old graph running alongside until the fade ends. The old
+    graph is then deleted on the message thread (pending -> active ->
+    fading -> retired, as SampleStreamer does with its libraries).
+
+    The master is mono (one channel copied to the others, as in the
+    reverb), so the graph processes channel 0 and copies it to the rest.
+*/
+class ProcessingGraph : private juce::Timer
+{
+public:
+    static constexpr int maxInputs = 8;
+    static constexpr double crossfadeSeconds = 0.03;
+
+    //==============================================================================
+    // One processor in the graph, created by the compiler from its patch line
+    class Node
+    {
+    public:
+        virtual ~Node() = default;
+
+        // Message thread, before the node is scheduled
+        virtual void prepare(double sampleRate) = 0;
+
+        // Audio thread. output may be the same buffer as any of the inputs, so read
+        // sample i of every input before writing sample i of the output.
+        virtual void process(const float* const* inputs, int numInputs, float* output, int numSamples) noexcept = 0;
+    };
+
+    //==============================================================================
+    ProcessingGraph() = default;
+    ~ProcessingGraph() override;
+
+    // Called from prepareToPlay, while the audio callback isn't running. Recompiles the
+    // current patch for the new rate and installs it without a fade.
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    // --- Message thread ---
+    // Parses and compiles a patch, then hands it to the audio thread, which fades it in.
+    // False (and the current graph keeps running) if the patch has errors; see getStatusText.
+    bool loadPatch(const juce::File& file);
+    bool setPatch(const juce::String& patchText, const juce::String& name);
+    void clear() { setPatch({}, {}); } // Back to a straight pass-through, faded like any other change
+    juce::String getStatusText() const;
+
+    // --- Audio thread ---
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    // A compiled patch: the nodes in schedule order, and the buffers their results live in.
+    // An empty patch compiles to no steps at all, which passes the block through.
+    struct CompiledGraph
+    {
+        struct Step
+        {
+            Node* node = nullptr;
+            std::array<int, maxInputs> inputs{}; // Buffer indices
+            int numInputs = 0;
+            int output = 0;                      // Buffer index; 0 is the block being processed
+        };
+
+        std::vector<std::unique_ptr<Node>> nodes;
+        std::vector<Step> steps;
+        int outputBuffer = 0;                    // Where the final result ends up
+        juce::AudioBuffer<float> scratch;        // Buffers 1..n, one channel each
+        std::vector<float*> bufferPointers;      // [0] is set per block, the rest point into scratch
+        juce::String summary;
+
+        void process(float* block, int numSamples) noexcept;
+    };
+
+    // Null with a message if the patch has errors
+    static std::unique_ptr<CompiledGraph> compile(const juce::String& patchText, double sampleRate, int maximumBlockSize,
+                                                  juce::String& error);
+    void processChunk(float* block, int numSamples) noexcept; // numSamples <= maxBlockSize
+    void deleteAllGraphs();
+    void timerCallback() override; // Deletes the retired graph once a fade has finished
+
+    // --- Audio thread state ---
+    CompiledGraph* activeGraph = nullptr;          // Null until the first patch: pass-through
+    CompiledGraph* fadingGraph = nullptr;          // The graph being faded out (null = pass-through)
+    int fadeSamplesRemaining = 0;
+    int fadeLength = 1;
+    std::vector<float> fadeBlock;                  // Copy of the block that the fading graph processes
+
+    // --- Hand-over: message thread -> pending -> (audio thread) active -> fading -> retired -> deleted by the timer ---
+    std::atomic<CompiledGraph*> pendingGraph{ nullptr };
+    std::atomic<CompiledGraph*> retiredGraph{ nullptr };
+    int idleTimerTicks = 0;
+
+    // --- Message thread / prepare ---
+    mutable juce::CriticalSection patchLock;       // Message thread and prepare callers
+    double currentSampleRate = 48000.0;
+    int maxBlockSize = 512;
+    juce::String currentPatch, currentName;        // Recompiled by prepare() when the rate changes
+    juce::String statusText{ "No graph" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProcessingGraph)
+};
@@ -0,0 +1,148 @@
+#include "QualityGovernor.h"
+#include <cmath>
+
+namespace
+{
+    // Ordered from most to least expensive; indices are QualityGovernor::Tier
+    const QualityGovernor::TierSettings tierSettings[QualityGovernor::numTiers] =
+    {
+        //  name        voices  fastOsc  onePole  envelopeInterval
+        { "full",       8,      false,   false,   1 },
+        { "reduced",    6,      true,    false,   4 },
+        { "economy",    4,      true,    true,    16 },
+        { "survival",   2,      true,    true,    32 },
+    };
+
+    constexpr double loadSmoothingSeconds = 0.1; // Time constant of the smoothed load
+}
+
+//==============================================================================
+QualityGovernor::QualityGovernor()
+{
+    logFile = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                  .getChildFile("CSYNTH")
+                  .getChildFile("quality_log.csv");
+    startTimer(500);
+}
+
+QualityGovernor::~QualityGovernor()
+{
+    stopTimer();
+    writePendingChanges();
+}
+
+const QualityGovernor::TierSettings& QualityGovernor::getTierSettings(int tier) noexcept
+{
+    return tierSettings[juce::jlimit(0, numTiers - 1, tier)];
+}
+
+void QualityGovernor::prepare(double sampleRate, int blockSize)
+{
+    currentSampleRate = sampleRate;
+    currentBlockSize = blockSize;
+    secondsSinceChange = 0.0;
+    secondsBelowStepUp = 0.0;
+    smoothedLoad.store(0.0f);
+
+    DBG("QualityGovernor::prepare - Rate=" + juce::String(sampleRate) + ", BlockSize=" + juce::String(blockSize)
+        + ", Tier=" + getTierSettings(getCurrentTier()).name);
+}
+
+//==============================================================================
+float QualityGovernor::endCallback(juce::int64 callbackStartTicks, int numSamples) noexcept
+{
+    if (currentSampleRate <= 0.0 || numSamples <= 0)
+        return 0.0f;
+
+    auto elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - callbackStartTicks);
+    auto deadlineSeconds = numSamples / currentSampleRate;
+    auto blockLoad = (float)(elapsedSeconds / deadlineSeconds);
+
+    // Exponential average over roughly loadSmoothingSeconds, whatever the block size
+    auto alpha = (float)(1.0 - std::exp(-deadlineSeconds / loadSmoothingSeconds));
+    auto load = smoothedLoad.load(std::memory_order_relaxed);
+    load += alpha * (blockLoad - load);
+    smoothedLoad.store(load, std::memory_order_relaxed);
+
+    secondsSinceChange += deadlineSeconds;
+    secondsBelowStepUp = load < stepUpLoad ? secondsBelowStepUp + deadlineSeconds : 0.0;
+
+    auto tier = getCurrentTier();
+    if (tier < numTiers - 1 && (load > stepDownLoad || blockLoad > overrunLoad) && secondsSinceChange >= stepDownHoldSeconds)
+        changeTier(tier + 1, blockLoad);
+    else if (tier > fullQuality && secondsBelowStepUp >= stepUpHoldSeconds)
+        changeTier(tier - 1, blockLoad);
+
+    return blockLoad;
+}
+
+void QualityGovernor::changeTier(int newTier, float blockLoad) noexcept
+{
+    TierChange change;
+    change.fromTier = getCurrentTier();
+    change.toTier = newTier;
+    change.smoothedLoad = smoothedLoad.load(std::memory_order_relaxed);
+    change.blockLoad = blockLoad;
+    change.blockSize = currentBlockSize;
+    change.sampleRate = currentSampleRate;
+
+    currentTier.store(newTier, std::memory_order_relaxed);
+    numTierChanges.fetch_add(1, std::memory_order_relaxed);
+    secondsSinceChange = 0.0;
+    secondsBelowStepUp = 0.0;
+
+    // If the message thread has stalled the entry is lost, the change itself still happens
+    const auto scope = pendingFifo.write(1);
+    if (scope.blockSize1 > 0)
+        pendingChanges[(size_t)scope.startIndex1] = change;
+}
+
+//==============================================================================
+void QualityGovernor::timerCallback()
+{
+    writePendingChanges();
+}
+
+void QualityGovernor::writePendingChanges()
+{
+    auto numReady = pendingFifo.getNumReady();
+    if (numReady == 0)
+        return;
+
+    if (logStream == nullptr)
+    {
+        logFile.getParentDirectory().createDirectory();
+        bool isNewFile = ! logFile.existsAsFile();
+        logStream = std::make_unique<juce::FileOutputStream>(logFile); // Appends to an existing file
+
+        if (logStream->failedToOpen())
+        {
+            DBG("QualityGovernor: Could not open " + logFile.getFullPathName());
+            logStream.reset();
+            pendingFifo.finishedRead(numReady); // Discard, otherwise the FIFO just fills up
+            return;
+        }
+
+        if (isNewFile)
+            *logStream << "time,from_tier,to_tier,smoothed_load_percent,block_load_percent,block_size,sample_rate\n";
+    }
+
+    auto now = juce::Time::getCurrentTime().toISO8601(true);
+    const auto scope = pendingFifo.read(numReady);
+    scope.forEach([&](int index)
+    {
+        const auto& change = pendingChanges[(size_t)index];
+        *logStream << now << ","
+                   << getTierSettings(change.fromTier).name << ","
+                   << getTierSettings(change.toTier).name << ","
+                   << juce::String(change.smoothedLoad * 100.0f, 1) << ","
+                   << juce::String(change.blockLoad * 100.0f, 1) << ","
+                   << change.blockSize << ","
+                   << juce::String(change.sampleRate, 0) << "\n";
+
+        DBG("QualityGovernor: " + juce::String(getTierSettings(change.fromTier).name) + " -> "
+            + getTierSettings(change.toTier).name + " at " + juce::String(change.smoothedLoad * 100.0f, 1) + "% load");
+    });
+
+    logStream->flush();
+}
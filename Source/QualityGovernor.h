@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/*
+    Trades sound quality for headroom when the audio callback gets close to its
+    deadline.
+
+    The audio thread reports how long each callback took; the governor smooths
+    that against the block's deadline (numSamples / sampleRate) and steps through
+    the quality tiers below:
+      - down one tier as soon as the smoothed load passes stepDownLoad, or a
+        single block overruns outright (then waits a moment for the new tier to
+        show up in the measurement before stepping again)
+      - back up one tier only after the load has stayed under stepUpLoad for
+        stepUpHoldSeconds, so a tier that only just fits doesn't oscillate
+
+    Every change is queued to the message thread, which appends it to
+    quality_log.csv next to the latency log for reviewing afterwards.
+*/
+class QualityGovernor : private juce::Timer
+{
+public:
+    enum Tier
+    {
+        fullQuality = 0,
+        reducedQuality,
+        economyQuality,
+        survivalQuality,
+        numTiers
+    };
+
+    // What the engine is allowed to spend at a tier
+    struct TierSettings
+    {
+        const char* name;
+        int  maxPolyphony;       // Voices beyond this are released, oldest first
+        bool fastOscillators;    // Float-precision oscillator kernels, nearest wavetable frame
+        bool onePoleFilter;      // 6 dB/oct lowpass (no resonance) instead of the state-variable filter
+        int  envelopeInterval;   // Envelope evaluated every N samples and ramped in between
+    };
+
+    static constexpr float stepDownLoad = 0.75f;      // Fraction of the block deadline
+    static constexpr float overrunLoad = 1.0f;
+    static constexpr float stepUpLoad = 0.45f;
+    static constexpr double stepUpHoldSeconds = 3.0;
+    static constexpr double stepDownHoldSeconds = 0.25;
+
+    QualityGovernor();
+    ~QualityGovernor() override;
+
+    static const TierSettings& getTierSettings(int tier) noexcept;
+
+    // Called from prepareToPlay (audio stopped). Keeps the current tier - the machine is no less busy.
+    void prepare(double sampleRate, int blockSize);
+
+    // --- Audio thread ---
+    // callbackStartTicks: juce::Time::getHighResolutionTicks() at the top of the callback. Call last thing.
+    // Returns this block's load (fraction of its deadline).
+    float endCallback(juce::int64 callbackStartTicks, int numSamples) noexcept;
+    int  getCurrentTier() const noexcept { return currentTier.load(std::memory_order_relaxed); }
+
+    // --- Any thread ---
+    float getSmoothedLoad() const noexcept { return smoothedLoad.load(std::memory_order_relaxed); }
+    int   getNumTierChanges() const noexcept { return numTierChanges.load(std::memory_order_relaxed); }
+    juce::File getLogFile() const { return logFile; }
+
+private:
+    struct TierChange
+    {
+        int fromTier = 0;
+        int toTier = 0;
+        float smoothedLoad = 0.0f;
+        float blockLoad = 0.0f;
+        int blockSize = 0;
+        double sampleRate = 0.0;
+    };
+
+    void changeTier(int newTier, float blockLoad) noexcept;
+    void timerCallback() override; // Drains the change FIFO into the log file
+    void writePendingChanges();
+
+    std::atomic<int>   currentTier{ fullQuality };
+    std::atomic<float> smoothedLoad{ 0.0f };
+    std::atomic<int>   numTierChanges{ 0 };
+
+    // Audio thread state
+    double currentSampleRate = 0.0;
+    int    currentBlockSize = 0;
+    double secondsSinceChange = 0.0; // Since the last tier change
+    double secondsBelowStepUp = 0.0; // Continuous time under stepUpLoad
+
+    // Changes waiting to be written to disk
+    static constexpr int fifoSize = 64;
+    juce::AbstractFifo pendingFifo{ fifoSize };
+    std::array<TierChange, fifoSize> pendingChanges;
+
+    juce::File logFile;
+    std::unique_ptr<juce::FileOutputStream> logStream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QualityGovernor)
+};
@@ -0,0 +1,201 @@
+#include "RealtimeSafetyChecker.h"
+
+#if CSYNTH_RT_SAFETY_CHECKS
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h> // _aligned_malloc
+#endif
+
+namespace
+{
+    thread_local int audioCallbackDepth = 0; // > 0 while inside ScopedAudioCallback
+    thread_local int suspendDepth = 0;       // > 0 while suspended or while we are reporting
+
+    std::array<std::atomic<int>, (size_t)RealtimeSafetyChecker::ViolationType::numTypes> violationCounts{};
+    std::atomic<bool> breakOnViolation{ false };
+
+    // Only the first few of each kind get a full report, otherwise the log floods every block
+    constexpr int maxReportsPerType = 32;
+
+    const char* getTypeName(RealtimeSafetyChecker::ViolationType type) noexcept
+    {
+        switch (type)
+        {
+        case RealtimeSafetyChecker::ViolationType::allocation:   return "allocation";
+        case RealtimeSafetyChecker::ViolationType::deallocation: return "deallocation";
+        case RealtimeSafetyChecker::ViolationType::lock:         return "lock";
+        case RealtimeSafetyChecker::ViolationType::systemCall:   return "blocking system call";
+        default:                                                 return "unknown";
+        }
+    }
+}
+
+//==============================================================================
+RealtimeSafetyChecker::ScopedAudioCallback::ScopedAudioCallback() noexcept  { ++audioCallbackDepth; }
+RealtimeSafetyChecker::ScopedAudioCallback::~ScopedAudioCallback() noexcept { --audioCallbackDepth; }
+
+RealtimeSafetyChecker::ScopedSuspend::ScopedSuspend() noexcept  { ++suspendDepth; }
+RealtimeSafetyChecker::ScopedSuspend::~ScopedSuspend() noexcept { --suspendDepth; }
+
+bool RealtimeSafetyChecker::isCheckingThisThread() noexcept
+{
+    return audioCallbackDepth > 0 && suspendDepth == 0;
+}
+
+void RealtimeSafetyChecker::reportViolation(ViolationType type, const char* description) noexcept
+{
+    if (! isCheckingThisThread())
+        return;
+
+    const ScopedSuspend suspend; // Building the report allocates - don't report ourselves
+
+    auto count = ++violationCounts[(size_t)type];
+    if (count > maxReportsPerType)
+        return;
+
+    juce::String message;
+    message << "RT-SAFETY: " << getTypeName(type) << " on the audio thread (" << description << ")";
+    if (count == maxReportsPerType)
+        message << " - further " << getTypeName(type) << " reports suppressed";
+    message << juce::newLine << juce::SystemStats::getStackBacktrace();
+
+    juce::Logger::outputDebugString(message);
+
+    if (breakOnViolation.load())
+        jassertfalse;
+}
+
+void RealtimeSafetyChecker::noteLockAcquisition(const char* lockName) noexcept
+{
+    reportViolation(ViolationType::lock, lockName);
+}
+
+int RealtimeSafetyChecker::getViolationCount(ViolationType type) noexcept
+{
+    return violationCounts[(size_t)type].load();
+}
+
+void RealtimeSafetyChecker::setBreakOnViolation(bool shouldBreak) noexcept
+{
+    breakOnViolation.store(shouldBreak);
+}
+
+//==============================================================================
+// Entry points for the Linux interposers and the Windows import hooks, which live in their
+// own translation units so they don't clash with the declarations pulled in by JuceHeader.h
+extern "C" int csynthRealtimeSafetyShouldReport()
+{
+    return RealtimeSafetyChecker::isCheckingThisThread() ? 1 : 0;
+}
+
+extern "C" void csynthRealtimeSafetyReport(int type, const char* description)
+{
+    RealtimeSafetyChecker::reportViolation((RealtimeSafetyChecker::ViolationType)type, description);
+}
+
+//==============================================================================
+#if ! JUCE_LINUX
+// No malloc interposition outside Linux, so catch C++ heap traffic at operator new/delete instead.
+// Every replaceable form is covered: the aligned ones serve over-aligned types such as
+// SIMDRegister state, and the nothrow ones are used by some library code.
+namespace
+{
+    void* allocate(std::size_t size, const char* description) noexcept
+    {
+        RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::ViolationType::allocation, description);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment, const char* description) noexcept
+    {
+        RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::ViolationType::allocation, description);
+        const auto bytes = size == 0 ? 1 : size;
+       #if JUCE_WINDOWS
+        return _aligned_malloc(bytes, (std::size_t)alignment);
+       #else
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, juce::jmax((std::size_t)alignment, sizeof(void*)), bytes) == 0 ? ptr : nullptr;
+       #endif
+    }
+
+    void release(void* ptr, const char* description) noexcept
+    {
+        if (ptr != nullptr)
+            RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::ViolationType::deallocation, description);
+        std::free(ptr);
+    }
+
+    void releaseAligned(void* ptr, const char* description) noexcept
+    {
+        if (ptr != nullptr)
+            RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::ViolationType::deallocation, description);
+       #if JUCE_WINDOWS
+        _aligned_free(ptr); // Memory from _aligned_malloc can't go to free()
+       #else
+        std::free(ptr);
+       #endif
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto* ptr = allocate(size, "operator new"))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (auto* ptr = allocate(size, "operator new[]"))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, "aligned operator new"))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, "aligned operator new[]"))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept   { return allocate(size, "nothrow operator new"); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, "nothrow operator new[]"); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment, "aligned nothrow operator new");
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment, "aligned nothrow operator new[]");
+}
+
+void operator delete(void* ptr) noexcept                               { release(ptr, "operator delete"); }
+void operator delete[](void* ptr) noexcept                             { release(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::size_t) noexcept                  { release(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::size_t) noexcept                { release(ptr, "operator delete[]"); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept        { release(ptr, "nothrow operator delete"); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept      { release(ptr, "nothrow operator delete[]"); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept                          { releaseAligned(ptr, "aligned operator delete"); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                        { releaseAligned(ptr, "aligned operator delete[]"); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept             { releaseAligned(ptr, "aligned operator delete"); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept           { releaseAligned(ptr, "aligned operator delete[]"); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept   { releaseAligned(ptr, "aligned nothrow operator delete"); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(ptr, "aligned nothrow operator delete[]"); }
+#endif
+
+#endif // CSYNTH_RT_SAFETY_CHECKS
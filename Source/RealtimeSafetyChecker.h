@@ -0,0 +1,88 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Opt-in: add CSYNTH_RT_SAFETY_CHECKS=1 to the Projucer "Preprocessor Definitions"
+// of a Debug configuration. With the default of 0 everything here compiles away.
+#ifndef CSYNTH_RT_SAFETY_CHECKS
+ #define CSYNTH_RT_SAFETY_CHECKS 0
+#endif
+
+//==============================================================================
+/*
+    Debug helper that catches real-time hazards on the audio thread.
+
+    The audio callback is wrapped in a ScopedAudioCallback, which sets a thread-local
+    flag for as long as the callback runs. While the flag is set, heap allocations,
+    frees, mutex acquisitions and blocking system calls made from that thread are
+    reported to the debug log together with a stack trace.
+
+    On Linux malloc/free, pthread mutexes and a set of blocking syscalls are
+    interposed (see RealtimeSafetyInterposers.cpp). Elsewhere every form of the
+    global operator new/delete (sized, aligned, nothrow) is replaced. On Windows
+    the executable's and the C++ runtime's imports of the critical section, SRW
+    lock, wait, sleep and file functions are hooked as well (see
+    RealtimeSafetyWindowsHooks.cpp). That catches CriticalSection, std::mutex and
+    WaitableEvent, but not C malloc/free or calls made inside other DLLs.
+
+    An uncontended juce::SpinLock is plain atomics and can't be intercepted on
+    any platform, so code that takes one on the audio thread calls
+    noteLockAcquisition() itself. A contended one is caught when it yields.
+*/
+class RealtimeSafetyChecker
+{
+public:
+    enum class ViolationType
+    {
+        allocation = 0,
+        deallocation,
+        lock,
+        systemCall,
+        numTypes
+    };
+
+    // Marks the current thread as running the audio callback for the object's lifetime
+    class ScopedAudioCallback
+    {
+    public:
+       #if CSYNTH_RT_SAFETY_CHECKS
+        ScopedAudioCallback() noexcept;
+        ~ScopedAudioCallback() noexcept;
+       #else
+        ScopedAudioCallback() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioCallback)
+    };
+
+    // Suspends checking on this thread, for work inside the callback that is known and accepted
+    class ScopedSuspend
+    {
+    public:
+       #if CSYNTH_RT_SAFETY_CHECKS
+        ScopedSuspend() noexcept;
+        ~ScopedSuspend() noexcept;
+       #else
+        ScopedSuspend() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedSuspend)
+    };
+
+   #if CSYNTH_RT_SAFETY_CHECKS
+    static bool isCheckingThisThread() noexcept;
+    static void reportViolation(ViolationType type, const char* description) noexcept;
+    static void noteLockAcquisition(const char* lockName) noexcept;
+    static int  getViolationCount(ViolationType type) noexcept;
+    static void setBreakOnViolation(bool shouldBreak) noexcept;
+   #else
+    static bool isCheckingThisThread() noexcept                         { return false; }
+    static void reportViolation(ViolationType, const char*) noexcept    {}
+    static void noteLockAcquisition(const char*) noexcept               {}
+    static int  getViolationCount(ViolationType) noexcept               { return 0; }
+    static void setBreakOnViolation(bool) noexcept                      {}
+   #endif
+
+private:
+    RealtimeSafetyChecker() = delete;
+};
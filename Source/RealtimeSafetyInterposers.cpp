@@ -0,0 +1,171 @@
+/*
+    Linux/glibc interposers for the RealtimeSafetyChecker.
+
+    Defining these symbols in the executable makes every call to them - from our code,
+    JUCE or any shared library - land here first. Each one asks the checker whether the
+    calling thread is inside the audio callback, reports if so, and forwards to the
+    real libc implementation.
+
+    Deliberately does NOT include JuceHeader.h or the libc headers that declare these
+    functions, so our definitions can't clash with fortified/inline versions of them.
+*/
+
+#ifndef CSYNTH_RT_SAFETY_CHECKS
+ #define CSYNTH_RT_SAFETY_CHECKS 0
+#endif
+
+#if CSYNTH_RT_SAFETY_CHECKS && defined (__linux__) && defined (__GLIBC__)
+
+#include <cstddef>
+#include <sys/types.h>
+
+extern "C"
+{
+    // Implemented in RealtimeSafetyChecker.cpp
+    int  csynthRealtimeSafetyShouldReport();
+    void csynthRealtimeSafetyReport(int type, const char* description);
+
+    // glibc's internal allocator entry points, so we can forward without recursion
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void  __libc_free(void*);
+
+    void* dlsym(void* handle, const char* symbol);
+}
+
+namespace
+{
+    // Must match RealtimeSafetyChecker::ViolationType
+    enum { allocation = 0, deallocation = 1, lock = 2, systemCall = 3 };
+
+    void* const nextHandle = (void*)-1l; // RTLD_NEXT
+
+    inline void check(int type, const char* description)
+    {
+        if (csynthRealtimeSafetyShouldReport() != 0)
+            csynthRealtimeSafetyReport(type, description);
+    }
+
+    template <typename FunctionType>
+    FunctionType resolveNext(const char* name)
+    {
+        return reinterpret_cast<FunctionType>(dlsym(nextHandle, name));
+    }
+
+    struct timespecFwd;      // struct timespec, kept opaque
+    struct pthreadMutexFwd;  // pthread_mutex_t
+    struct pthreadCondFwd;   // pthread_cond_t
+
+    using ReadFn = ssize_t (*)(int, void*, size_t);
+    using WriteFn = ssize_t (*)(int, const void*, size_t);
+    using FsyncFn = int (*)(int);
+    using NanosleepFn = int (*)(const timespecFwd*, timespecFwd*);
+    using UsleepFn = int (*)(unsigned int);
+    using SchedYieldFn = int (*)();
+    using MutexLockFn = int (*)(pthreadMutexFwd*);
+    using CondWaitFn = int (*)(pthreadCondFwd*, pthreadMutexFwd*);
+
+    // Resolved once at static-init time so the first lookup never happens inside the callback
+    struct NextFunctions
+    {
+        ReadFn       read       = resolveNext<ReadFn>("read");
+        WriteFn      write      = resolveNext<WriteFn>("write");
+        FsyncFn      fsync      = resolveNext<FsyncFn>("fsync");
+        NanosleepFn  nanosleep  = resolveNext<NanosleepFn>("nanosleep");
+        UsleepFn     usleep     = resolveNext<UsleepFn>("usleep");
+        SchedYieldFn schedYield = resolveNext<SchedYieldFn>("sched_yield");
+        MutexLockFn  mutexLock  = resolveNext<MutexLockFn>("pthread_mutex_lock");
+        CondWaitFn   condWait   = resolveNext<CondWaitFn>("pthread_cond_wait");
+    };
+
+    NextFunctions& next()
+    {
+        static NextFunctions functions;
+        return functions;
+    }
+
+    const NextFunctions& eagerlyResolved = next();
+}
+
+extern "C"
+{
+    //==============================================================================
+    void* malloc(size_t size)
+    {
+        check(allocation, "malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        check(allocation, "calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        check(allocation, "realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void* ptr)
+    {
+        if (ptr != nullptr)
+            check(deallocation, "free");
+        __libc_free(ptr);
+    }
+
+    //==============================================================================
+    int pthread_mutex_lock(pthreadMutexFwd* mutex)
+    {
+        check(lock, "pthread_mutex_lock");
+        return next().mutexLock(mutex);
+    }
+
+    int pthread_cond_wait(pthreadCondFwd* cond, pthreadMutexFwd* mutex)
+    {
+        check(lock, "pthread_cond_wait");
+        return next().condWait(cond, mutex);
+    }
+
+    //==============================================================================
+    ssize_t read(int fd, void* buffer, size_t count)
+    {
+        check(systemCall, "read");
+        return next().read(fd, buffer, count);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t count)
+    {
+        check(systemCall, "write");
+        return next().write(fd, buffer, count);
+    }
+
+    int fsync(int fd)
+    {
+        check(systemCall, "fsync");
+        return next().fsync(fd);
+    }
+
+    int nanosleep(const timespecFwd* requested, timespecFwd* remaining)
+    {
+        check(systemCall, "nanosleep");
+        return next().nanosleep(requested, remaining);
+    }
+
+    int usleep(unsigned int microseconds)
+    {
+        check(systemCall, "usleep");
+        return next().usleep(microseconds);
+    }
+
+    int sched_yield()
+    {
+        // juce::SpinLock yields when contended, so this also catches spinning on a busy lock
+        check(systemCall, "sched_yield");
+        return next().schedYield();
+    }
+}
+
+#endif
@@ -0,0 +1,257 @@
+/*
+    Windows hooks for the RealtimeSafetyChecker.
+
+    Windows has no symbol interposition, so at start-up the import address tables of
+    the executable and of the C++ runtime DLL are patched instead. Calls they make to
+    the kernel32 lock, wait, sleep and file functions then land here first. Each hook
+    asks the checker whether the calling thread is inside the audio callback, reports
+    if so, and forwards to the real function.
+
+    That covers juce::CriticalSection (EnterCriticalSection), std::mutex and
+    std::condition_variable (SRW locks, inside msvcp140), juce::WaitableEvent and
+    Thread::wait (which use those), a contended juce::SpinLock (it yields through
+    Sleep(0)) and blocking file I/O. Calls made from inside other DLLs, e.g. an audio
+    driver, aren't seen, and neither are C malloc/free; operator new/delete are caught
+    in RealtimeSafetyChecker.cpp.
+
+    Like the Linux interposers, this doesn't include JuceHeader.h.
+*/
+
+#ifndef CSYNTH_RT_SAFETY_CHECKS
+ #define CSYNTH_RT_SAFETY_CHECKS 0
+#endif
+
+#if CSYNTH_RT_SAFETY_CHECKS && defined (_WIN32)
+
+#ifndef WIN32_LEAN_AND_MEAN
+ #define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+ #define NOMINMAX
+#endif
+#include <windows.h>
+#include <cstring>
+
+extern "C"
+{
+    // Implemented in RealtimeSafetyChecker.cpp
+    int  csynthRealtimeSafetyShouldReport();
+    void csynthRealtimeSafetyReport(int type, const char* description);
+}
+
+namespace
+{
+    // Must match RealtimeSafetyChecker::ViolationType
+    enum { allocation = 0, deallocation = 1, lock = 2, systemCall = 3 };
+
+    inline void check(int type, const char* description)
+    {
+        if (csynthRealtimeSafetyShouldReport() != 0)
+            csynthRealtimeSafetyReport(type, description);
+    }
+
+    template <typename FunctionType>
+    FunctionType resolveReal(FunctionType, const char* name)
+    {
+        // kernel32 forwards some of these to kernelbase or ntdll; GetProcAddress follows the forward
+        return reinterpret_cast<FunctionType>(reinterpret_cast<void*>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), name)));
+    }
+
+    // Looked up before any table is patched, so they always point at the real functions
+    struct RealFunctions
+    {
+        decltype(&EnterCriticalSection)      enterCriticalSection      = resolveReal(&EnterCriticalSection, "EnterCriticalSection");
+        decltype(&AcquireSRWLockExclusive)   acquireSRWLockExclusive   = resolveReal(&AcquireSRWLockExclusive, "AcquireSRWLockExclusive");
+        decltype(&AcquireSRWLockShared)      acquireSRWLockShared      = resolveReal(&AcquireSRWLockShared, "AcquireSRWLockShared");
+        decltype(&SleepConditionVariableSRW) sleepConditionVariableSRW = resolveReal(&SleepConditionVariableSRW, "SleepConditionVariableSRW");
+        decltype(&SleepConditionVariableCS)  sleepConditionVariableCS  = resolveReal(&SleepConditionVariableCS, "SleepConditionVariableCS");
+        decltype(&WaitForSingleObject)       waitForSingleObject       = resolveReal(&WaitForSingleObject, "WaitForSingleObject");
+        decltype(&WaitForSingleObjectEx)     waitForSingleObjectEx     = resolveReal(&WaitForSingleObjectEx, "WaitForSingleObjectEx");
+        decltype(&WaitForMultipleObjects)    waitForMultipleObjects    = resolveReal(&WaitForMultipleObjects, "WaitForMultipleObjects");
+        decltype(&Sleep)                     sleep                     = resolveReal(&Sleep, "Sleep");
+        decltype(&SleepEx)                   sleepEx                   = resolveReal(&SleepEx, "SleepEx");
+        decltype(&SwitchToThread)            switchToThread            = resolveReal(&SwitchToThread, "SwitchToThread");
+        decltype(&ReadFile)                  readFile                  = resolveReal(&ReadFile, "ReadFile");
+        decltype(&WriteFile)                 writeFile                 = resolveReal(&WriteFile, "WriteFile");
+        decltype(&FlushFileBuffers)          flushFileBuffers          = resolveReal(&FlushFileBuffers, "FlushFileBuffers");
+    };
+
+    const RealFunctions& real()
+    {
+        static const RealFunctions functions;
+        return functions;
+    }
+
+    //==============================================================================
+    void WINAPI hookEnterCriticalSection(LPCRITICAL_SECTION section)
+    {
+        check(lock, "EnterCriticalSection");
+        real().enterCriticalSection(section);
+    }
+
+    void WINAPI hookAcquireSRWLockExclusive(PSRWLOCK srwLock)
+    {
+        check(lock, "AcquireSRWLockExclusive");
+        real().acquireSRWLockExclusive(srwLock);
+    }
+
+    void WINAPI hookAcquireSRWLockShared(PSRWLOCK srwLock)
+    {
+        check(lock, "AcquireSRWLockShared");
+        real().acquireSRWLockShared(srwLock);
+    }
+
+    BOOL WINAPI hookSleepConditionVariableSRW(PCONDITION_VARIABLE condition, PSRWLOCK srwLock, DWORD milliseconds, ULONG flags)
+    {
+        check(lock, "SleepConditionVariableSRW");
+        return real().sleepConditionVariableSRW(condition, srwLock, milliseconds, flags);
+    }
+
+    BOOL WINAPI hookSleepConditionVariableCS(PCONDITION_VARIABLE condition, PCRITICAL_SECTION section, DWORD milliseconds)
+    {
+        check(lock, "SleepConditionVariableCS");
+        return real().sleepConditionVariableCS(condition, section, milliseconds);
+    }
+
+    //==============================================================================
+    DWORD WINAPI hookWaitForSingleObject(HANDLE handle, DWORD milliseconds)
+    {
+        check(systemCall, "WaitForSingleObject");
+        return real().waitForSingleObject(handle, milliseconds);
+    }
+
+    DWORD WINAPI hookWaitForSingleObjectEx(HANDLE handle, DWORD milliseconds, BOOL alertable)
+    {
+        check(systemCall, "WaitForSingleObjectEx");
+        return real().waitForSingleObjectEx(handle, milliseconds, alertable);
+    }
+
+    DWORD WINAPI hookWaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds)
+    {
+        check(systemCall, "WaitForMultipleObjects");
+        return real().waitForMultipleObjects(count, handles, waitAll, milliseconds);
+    }
+
+    void WINAPI hookSleep(DWORD milliseconds)
+    {
+        // juce::SpinLock yields with Sleep(0) when contended, so this also catches spinning on a busy lock
+        check(systemCall, "Sleep");
+        real().sleep(milliseconds);
+    }
+
+    DWORD WINAPI hookSleepEx(DWORD milliseconds, BOOL alertable)
+    {
+        check(systemCall, "SleepEx");
+        return real().sleepEx(milliseconds, alertable);
+    }
+
+    BOOL WINAPI hookSwitchToThread()
+    {
+        check(systemCall, "SwitchToThread");
+        return real().switchToThread();
+    }
+
+    BOOL WINAPI hookReadFile(HANDLE file, LPVOID buffer, DWORD numBytes, LPDWORD numRead, LPOVERLAPPED overlapped)
+    {
+        check(systemCall, "ReadFile");
+        return real().readFile(file, buffer, numBytes, numRead, overlapped);
+    }
+
+    BOOL WINAPI hookWriteFile(HANDLE file, LPCVOID buffer, DWORD numBytes, LPDWORD numWritten, LPOVERLAPPED overlapped)
+    {
+        check(systemCall, "WriteFile");
+        return real().writeFile(file, buffer, numBytes, numWritten, overlapped);
+    }
+
+    BOOL WINAPI hookFlushFileBuffers(HANDLE file)
+    {
+        check(systemCall, "FlushFileBuffers");
+        return real().flushFileBuffers(file);
+    }
+
+    //==============================================================================
+    struct Hook
+    {
+        const char* name;
+        void* replacement;
+    };
+
+    const Hook hooks[] =
+    {
+        { "EnterCriticalSection",      reinterpret_cast<void*>(&hookEnterCriticalSection) },
+        { "AcquireSRWLockExclusive",   reinterpret_cast<void*>(&hookAcquireSRWLockExclusive) },
+        { "AcquireSRWLockShared",      reinterpret_cast<void*>(&hookAcquireSRWLockShared) },
+        { "SleepConditionVariableSRW", reinterpret_cast<void*>(&hookSleepConditionVariableSRW) },
+        { "SleepConditionVariableCS",  reinterpret_cast<void*>(&hookSleepConditionVariableCS) },
+        { "WaitForSingleObject",       reinterpret_cast<void*>(&hookWaitForSingleObject) },
+        { "WaitForSingleObjectEx",     reinterpret_cast<void*>(&hookWaitForSingleObjectEx) },
+        { "WaitForMultipleObjects",    reinterpret_cast<void*>(&hookWaitForMultipleObjects) },
+        { "Sleep",                     reinterpret_cast<void*>(&hookSleep) },
+        { "SleepEx",                   reinterpret_cast<void*>(&hookSleepEx) },
+        { "SwitchToThread",            reinterpret_cast<void*>(&hookSwitchToThread) },
+        { "ReadFile",                  reinterpret_cast<void*>(&hookReadFile) },
+        { "WriteFile",                 reinterpret_cast<void*>(&hookWriteFile) },
+        { "FlushFileBuffers",          reinterpret_cast<void*>(&hookFlushFileBuffers) },
+    };
+
+    // Points every by-name import of a hooked function in this module at the hook,
+    // whichever DLL it's imported from (kernel32 or an api-ms-win-core-* set)
+    void patchImports(HMODULE module)
+    {
+        if (module == nullptr)
+            return;
+
+        auto* base = reinterpret_cast<BYTE*>(module);
+        const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+        const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dosHeader->e_lfanew);
+        const auto& importDirectory = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+        if (importDirectory.VirtualAddress == 0)
+            return;
+
+        for (auto* descriptor = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR*>(base + importDirectory.VirtualAddress);
+             descriptor->Name != 0; ++descriptor)
+        {
+            if (descriptor->OriginalFirstThunk == 0) // No name table to match against
+                continue;
+
+            auto* names = reinterpret_cast<const IMAGE_THUNK_DATA*>(base + descriptor->OriginalFirstThunk);
+            auto* addresses = reinterpret_cast<IMAGE_THUNK_DATA*>(base + descriptor->FirstThunk);
+
+            for (; names->u1.AddressOfData != 0; ++names, ++addresses)
+            {
+                if (IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal))
+                    continue;
+
+                const auto* import = reinterpret_cast<const IMAGE_IMPORT_BY_NAME*>(base + names->u1.AddressOfData);
+                for (const auto& hook : hooks)
+                {
+                    if (std::strcmp(reinterpret_cast<const char*>(import->Name), hook.name) != 0)
+                        continue;
+
+                    auto* entry = &addresses->u1.Function;
+                    DWORD oldProtection = 0;
+                    if (VirtualProtect(entry, sizeof(*entry), PAGE_READWRITE, &oldProtection))
+                    {
+                        *entry = reinterpret_cast<decltype(addresses->u1.Function)>(hook.replacement);
+                        VirtualProtect(entry, sizeof(*entry), oldProtection, &oldProtection);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Runs during static initialisation, before the audio device is opened
+    bool installHooks()
+    {
+        real();
+        patchImports(GetModuleHandleW(nullptr));     // Our code and JUCE, which are linked into the executable
+        patchImports(GetModuleHandleW(L"msvcp140.dll"));
+        patchImports(GetModuleHandleW(L"msvcp140d.dll"));
+        return true;
+    }
+
+    const bool hooksInstalled = installHooks();
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "RenderAhead.h"
+#include "TraceRecorder.h"
+
+//==============================================================================
+RenderAhead::RenderAhead(SynthEngine& engineToRender, StepSequencer& sequencerToRun, RenderFunction function)
+    : juce::Thread("CSYNTH Render Ahead"),
+      engine(engineToRender),
+      sequencer(sequencerToRun),
+      renderFunction(std::move(function))
+{
+    ring.assign((size_t)ringSize, 0.0f);
+    snapshots.resize((size_t)numSnapshots);
+}
+
+RenderAhead::~RenderAhead()
+{
+    stopThread(2000);
+}
+
+//==============================================================================
+void RenderAhead::suspend()
+{
+    // The engine is about to be re-prepared: the worker must be off it, and it starts out stopped again
+    stopThread(2000);
+    phase.store(stopped);
+    liveEvents.clear();
+    invalidated.store(false);
+}
+
+void RenderAhead::prepare(double /*sampleRate*/, int deviceBlockSize)
+{
+    jassert(! isThreadRunning()); // suspend() first
+
+    largestBlock = deviceBlockSize;
+    setDepthForBlockSize(deviceBlockSize);
+
+    chunkBuffer.setSize(2, snapshotInterval);
+    readPosition.store(0);
+    readEnd.store(0);
+    writePosition.store(0);
+
+    // Sizes the voices' filter state vectors in every snapshot; after this, saves don't allocate
+    for (auto& snapshot : snapshots)
+    {
+        engine.prepareState(snapshot.engine);
+        sequencer.saveState(snapshot.sequencer);
+        snapshot.position = -1;
+    }
+
+    startThread(juce::Thread::Priority::highest); // It is the audio now, just early
+}
+
+//==============================================================================
+int RenderAhead::readBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // Devices may deliver more than the block size they announced: the ring has to stay ahead of it
+    if (numSamples > largestBlock)
+    {
+        largestBlock = numSamples;
+        setDepthForBlockSize(numSamples);
+    }
+
+    auto current = phase.load();
+
+    if (current == stopped)
+    {
+        if (! enabled.load() || ! supported.load())
+            return 0;
+
+        // Take over while we still own the engine: render this block and one more right here,
+        // so the worker starts with something in hand and the switch has no gap
+        readPosition.store(0);
+        readEnd.store(0);
+        writePosition.store(0);
+        for (auto& snapshot : snapshots)
+            snapshot.position = -1;
+        while (writePosition.load() < 2 * numSamples)
+            renderChunk();
+
+        phase.store(running);
+        current = running;
+    }
+    else if (current == running && (! enabled.load() || ! supported.load()))
+    {
+        // The worker finishes its chunk and hands over; meanwhile the ring plays on
+        auto expected = (int)running;
+        phase.compare_exchange_strong(expected, (int)stopping);
+    }
+
+    // Copy what's there (the ring is mono, the engine's output is the same on every channel)
+    // The block's end is published before writePosition is read (both sequentially consistent, as is
+    // the worker's read of readEnd and its rewind of writePosition). Either the worker sees this block
+    // and rolls back past it, or this read sees the rewound writePosition and stops short of the rewrite.
+    auto read = readPosition.load();
+    readEnd.store(read + numSamples);
+    auto available = (int)juce::jmin((juce::int64)numSamples, writePosition.load() - read);
+    auto ringIndex = (int)(read & (ringSize - 1));
+    auto firstPart = juce::jmin(available, ringSize - ringIndex);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        buffer.copyFrom(channel, startSample, ring.data() + ringIndex, firstPart);
+        if (available > firstPart)
+            buffer.copyFrom(channel, startSample + firstPart, ring.data(), available - firstPart);
+    }
+    readPosition.store(read + available, std::memory_order_release);
+
+    if (available == numSamples)
+        return numSamples;
+
+    if (current == draining)
+    {
+        // Played out: the engine is back with the caller, at exactly the point the ring ended
+        phase.store(stopped);
+        return available;
+    }
+
+    // The worker fell behind - a dropout, but never a read of stale audio
+    buffer.clear(startSample + available, numSamples - available);
+    ++underruns;
+    return numSamples;
+}
+
+void RenderAhead::pushLiveEvent(const NoteEvent& event) noexcept
+{
+    liveEvents.push(event); // Full (256 pending) only if the worker has stalled - the event is dropped
+}
+
+//==============================================================================
+void RenderAhead::run()
+{
+    while (! threadShouldExit())
+    {
+        auto current = phase.load();
+        if (current == stopping)
+        {
+            phase.store(draining); // Hands the engine back; nothing below runs until the next start
+            continue;
+        }
+        if (current != running)
+        {
+            wait(2);
+            continue;
+        }
+
+        // Whatever is rendered past the earliest unplayed point is out of date
+        if (liveEvents.getNumReady() > 0 || invalidated.exchange(false))
+        {
+            rollBack();
+            applyLiveEvents();
+        }
+
+        // Polled rather than signalled: the audio thread never wakes us (notify() takes a lock)
+        if (writePosition.load() - readPosition.load() < aheadSamples)
+            renderChunk();
+        else
+            wait(1);
+    }
+}
+
+void RenderAhead::renderChunk() noexcept
+{
+    const TraceRecorder::ScopedEvent trace("RenderAhead::renderChunk");
+    auto position = writePosition.load();
+
+    // Rollback point for this chunk, taken before anything changes
+    auto& snapshot = snapshots[(size_t)((position / snapshotInterval) % numSnapshots)];
+    engine.saveState(snapshot.engine);
+    sequencer.saveState(snapshot.sequencer);
+    snapshot.position = position;
+
+    renderFunction(chunkBuffer, 0, snapshotInterval);
+
+    // snapshotInterval divides ringSize, so a chunk never wraps
+    auto ringIndex = (int)(position & (ringSize - 1));
+    std::copy(chunkBuffer.getReadPointer(0), chunkBuffer.getReadPointer(0) + snapshotInterval, ring.begin() + ringIndex);
+    writePosition.store(position + snapshotInterval, std::memory_order_release);
+}
+
+void RenderAhead::rollBack() noexcept
+{
+    const TraceRecorder::ScopedEvent trace("RenderAhead::rollBack");
+
+    // First chunk boundary past the block the device is copying (see readBlock for the ordering)
+    auto earliest = readEnd.load();
+    auto target = (earliest + snapshotInterval - 1) / snapshotInterval * snapshotInterval;
+    if (target >= writePosition.load())
+        return; // Nothing rendered past it yet - the change lands at the write position anyway
+
+    const auto& snapshot = snapshots[(size_t)((target / snapshotInterval) % numSnapshots)];
+    if (snapshot.position != target || ! engine.restoreState(snapshot.engine))
+        return; // A sample library swap since then - the change lands at the write position instead
+
+    sequencer.restoreState(snapshot.sequencer);
+    writePosition.store(target); // Before rewriting: the reader never sees the old tail again
+    ++rollbacks;
+}
+
+void RenderAhead::setDepthForBlockSize(int blockSize) noexcept
+{
+    // The ring has to hold the block being copied plus a chunk being rendered.
+    // With huge device blocks there is no room left to render ahead - nor any need for this.
+    auto needed = blockSize + snapshotInterval;
+    auto ahead = juce::jmin(maxAheadSamples - snapshotInterval, needed + 2048) / snapshotInterval * snapshotInterval;
+
+    aheadSamples.store(ahead);
+    supported.store(needed < ahead);
+}
+
+void RenderAhead::applyLiveEvents() noexcept
+{
+    NoteEvent event;
+    while (liveEvents.pop(event))
+        if (! sequencer.handleInputEvent(event)) // The arpeggiator takes held keys for itself
+            engine.handleNoteEvent(event);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "NoteEventQueue.h"
+#include "SynthEngine.h"
+#include "StepSequencer.h"
+
+//==============================================================================
+/*
+    Renders the sequencer + SynthEngine ahead of the play position on a worker
+    thread, so the device callback only copies from a lock-free ring.
+
+    While it runs, the worker owns the engine and the sequencer outright.
+    The audio thread touches neither. It reads the ring and forwards live
+    note events through a queue. Ownership changes hands only through the
+    phase atomic:
+        stopped --(audio: primes the ring)--> running --(audio)--> stopping
+        stopping --(worker: stops rendering)--> draining
+        draining --(audio: ring empty)--> stopped
+    While draining, the audio thread plays out what is left. Then it takes
+    the engine back exactly where the ring ends, so the switch is seamless.
+
+    Live changes (note events, parameter tweaks via invalidate()) mean the
+    audio already in the ring is out of date. Before rendering each
+    snapshotInterval chunk, the worker saves the engine and sequencer state.
+    On a change it rewinds to the first snapshot past the end of the block
+    the device is copying (readEnd, published before the copy starts),
+    applies the change there and renders again. A live note therefore lands
+    about one device block late, whatever the render-ahead depth. The depth
+    is sized from the largest block seen so far: a device that delivers a
+    bigger block than prepare() was told about deepens it, or hands the
+    engine back if the ring can't stay more than a block ahead.
+    Effects after the engine (reverb, level, scope, recorder) still run in
+    the callback, so they never need re-rendering.
+*/
+class RenderAhead : private juce::Thread
+{
+public:
+    static constexpr int ringSize = 1 << 14;          // Mono samples, power of two
+    static constexpr int snapshotInterval = 128;      // Rollback granularity, and the render chunk size
+    static constexpr int maxAheadSamples = 4096;
+    static constexpr int numSnapshots = maxAheadSamples / snapshotInterval + 2;
+
+    // Renders the sequencer + engine into channel 0 (and copies) of buffer; called by whichever thread owns them
+    using RenderFunction = std::function<void(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)>;
+
+    RenderAhead(SynthEngine& engine, StepSequencer& sequencer, RenderFunction renderFunction);
+    ~RenderAhead() override;
+
+    // --- Message thread (audio stopped: from prepareToPlay) ---
+    void suspend();                                      // Before the engine and sequencer are prepared
+    void prepare(double sampleRate, int deviceBlockSize); // After, restarts the worker
+    void setEnabled(bool shouldRenderAhead) noexcept { enabled.store(shouldRenderAhead); }
+    bool isEnabled() const noexcept { return enabled.load(); }
+    // A parameter the engine reads changed: render again from the earliest unplayed point
+    void invalidate() noexcept { invalidated.store(true); }
+    int getNumUnderruns() const noexcept { return underruns.load(); }
+    int getNumRollbacks() const noexcept { return rollbacks.load(); }
+
+    // --- Audio thread ---
+    // Copies engine output for the block from the ring. Returns how many samples it supplied;
+    // the caller renders the rest itself (all of them while stopped). An underrun while the
+    // worker owns the engine is filled with silence and counts as supplied.
+    int readBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    // True while live input has to go through pushLiveEvent (the engine isn't the caller's)
+    bool isWorkerRendering() const noexcept { return phase.load() != stopped; }
+    void pushLiveEvent(const NoteEvent& event) noexcept;
+    // Once stopped: events forwarded while the worker was winding down, for the caller to apply
+    bool popLiveEvent(NoteEvent& event) noexcept { return liveEvents.pop(event); }
+
+private:
+    enum Phase { stopped, running, stopping, draining };
+
+    struct Snapshot
+    {
+        juce::int64 position = -1; // Ring position the state belongs to (-1 = none)
+        SynthEngine::State engine;
+        StepSequencer::State sequencer;
+    };
+
+    void run() override;
+    void renderChunk() noexcept;   // One snapshotInterval at writePosition, by the current owner
+    void rollBack() noexcept;
+    void applyLiveEvents() noexcept;
+    void setDepthForBlockSize(int blockSize) noexcept;
+
+    SynthEngine& engine;
+    StepSequencer& sequencer;
+    RenderFunction renderFunction;
+
+    std::atomic<int> phase{ stopped };
+    std::atomic<bool> enabled{ false }, invalidated{ false };
+    std::atomic<juce::int64> writePosition{ 0 }, readPosition{ 0 }; // Absolute, in samples
+    std::atomic<juce::int64> readEnd{ 0 };   // End of the block the callback is copying, or last copied
+    std::atomic<int> underruns{ 0 }, rollbacks{ 0 };
+
+    std::vector<float> ring;
+    juce::AudioBuffer<float> chunkBuffer;
+    std::vector<Snapshot> snapshots;
+    NoteEventQueue liveEvents;
+    // Set by prepare(), grown by the audio thread; read by the worker
+    std::atomic<int> aheadSamples{ 2048 };
+    std::atomic<bool> supported{ true };    // False for device blocks too big for the ring to stay ahead of
+    int largestBlock = 0;                   // Audio thread (and prepare)
+};
@@ -0,0 +1,191 @@
+#include "SampleLibrary.h"
+#include <algorithm>
+
+//==============================================================================
+juce::String SampleLibrary::loadFromFolder(const juce::File& folder, int headLengthSamples)
+{
+    zones.clear();
+    keyVelocityMap.fill(nullptr);
+    name = folder.getFileName();
+
+    if (! folder.isDirectory())
+        return "Not a folder: " + folder.getFullPathName();
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto files = folder.findChildFiles(juce::File::findFiles, false, formatManager.getWildcardForAllFormats());
+    files.sort();
+
+    for (const auto& file : files)
+    {
+        // --- Work out root note and velocity layer from the file name ---
+        int rootNote = -1;
+        int topVelocity = 127;
+        auto tokens = juce::StringArray::fromTokens(file.getFileNameWithoutExtension(), "_- ", "");
+        for (const auto& token : tokens)
+        {
+            auto lower = token.toLowerCase();
+            auto velocityDigits = lower.startsWith("vel") ? lower.substring(3)
+                                : lower.startsWith("v") ? lower.substring(1) : juce::String();
+            if (velocityDigits.isNotEmpty() && velocityDigits.containsOnly("0123456789"))
+            {
+                topVelocity = juce::jlimit(1, 127, velocityDigits.getIntValue());
+                continue;
+            }
+
+            auto note = parseNoteToken(token);
+            if (note >= 0)
+                rootNote = note; // Last note-like token wins, e.g. "Kit2_C4" -> C4 rather than 2
+        }
+
+        if (rootNote < 0)
+        {
+            DBG("SampleLibrary: No root note in file name, skipping " + file.getFileName());
+            continue;
+        }
+
+        // --- Open a reader: memory-mapped when the format supports it ---
+        auto zone = std::make_unique<Zone>();
+        zone->file = file;
+        zone->rootNote = rootNote;
+        zone->highVelocity = topVelocity;
+
+        if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(file));
+            if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            {
+                zone->reader = std::move(mappedReader);
+                zone->isMemoryMapped = true;
+            }
+        }
+
+        if (zone->reader == nullptr)
+            zone->reader.reset(formatManager.createReaderFor(file));
+
+        if (zone->reader == nullptr || zone->reader->lengthInSamples <= 0)
+        {
+            DBG("SampleLibrary: Can't read " + file.getFileName());
+            continue;
+        }
+
+        auto& reader = *zone->reader;
+        zone->sampleRate = reader.sampleRate;
+        zone->lengthInSamples = reader.lengthInSamples;
+        zone->headLength = (int)juce::jmin((juce::int64)headLengthSamples, reader.lengthInSamples);
+
+        // --- Preload the head as a mono mixdown ---
+        auto numSourceChannels = juce::jlimit(1, 2, (int)reader.numChannels);
+        juce::AudioBuffer<float> headSource(numSourceChannels, zone->headLength);
+        reader.read(&headSource, 0, zone->headLength, 0, true, numSourceChannels > 1);
+
+        zone->head.setSize(1, zone->headLength);
+        zone->head.copyFrom(0, 0, headSource, 0, 0, zone->headLength);
+        if (numSourceChannels > 1)
+        {
+            zone->head.addFrom(0, 0, headSource, 1, 0, zone->headLength);
+            zone->head.applyGain(0.5f);
+        }
+
+        zones.push_back(std::move(zone));
+    }
+
+    if (zones.empty())
+        return "No usable samples in " + folder.getFullPathName();
+
+    assignKeyRanges();
+
+    DBG("SampleLibrary: Loaded '" + name + "' - " + juce::String(getNumZones()) + " zones, "
+        + juce::String((double)getResidentBytes() / (1024.0 * 1024.0), 1) + " MB resident");
+    return {};
+}
+
+void SampleLibrary::assignKeyRanges()
+{
+    // Distinct roots, ascending
+    std::vector<int> roots;
+    for (const auto& zone : zones)
+        roots.push_back(zone->rootNote);
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+        auto lowKey = i == 0 ? 0 : (roots[i - 1] + roots[i]) / 2 + 1;
+        auto highKey = i + 1 == roots.size() ? 127 : (roots[i] + roots[i + 1]) / 2;
+
+        // Velocity layers for this root, ordered by their top velocity
+        std::vector<Zone*> layers;
+        for (auto& zone : zones)
+            if (zone->rootNote == roots[i])
+                layers.push_back(zone.get());
+        std::sort(layers.begin(), layers.end(), [](const Zone* a, const Zone* b) { return a->highVelocity < b->highVelocity; });
+
+        int nextLowVelocity = 1;
+        for (size_t layer = 0; layer < layers.size(); ++layer)
+        {
+            auto* zone = layers[layer];
+            zone->lowKey = lowKey;
+            zone->highKey = highKey;
+            zone->lowVelocity = nextLowVelocity;
+            if (layer + 1 == layers.size())
+                zone->highVelocity = 127; // Top layer always reaches full velocity
+            nextLowVelocity = zone->highVelocity + 1;
+        }
+    }
+
+    // Flatten into a key x velocity table so the audio thread's lookup is a single index
+    for (const auto& zone : zones)
+        for (int key = zone->lowKey; key <= zone->highKey; ++key)
+            for (int velocity = zone->lowVelocity; velocity <= zone->highVelocity; ++velocity)
+                keyVelocityMap[(size_t)(key * 128 + velocity)] = zone.get();
+}
+
+//==============================================================================
+const SampleLibrary::Zone* SampleLibrary::findZone(int midiNote, int velocity) const noexcept
+{
+    if (midiNote < 0 || midiNote > 127)
+        return nullptr;
+
+    return keyVelocityMap[(size_t)(midiNote * 128 + juce::jlimit(1, 127, velocity))];
+}
+
+size_t SampleLibrary::getResidentBytes() const noexcept
+{
+    size_t total = 0;
+    for (const auto& zone : zones)
+        total += (size_t)zone->headLength * sizeof(float);
+    return total;
+}
+
+int SampleLibrary::parseNoteToken(const juce::String& token)
+{
+    if (token.isEmpty())
+        return -1;
+
+    // Plain MIDI note number
+    if (token.containsOnly("0123456789"))
+    {
+        auto number = token.getIntValue();
+        return (token.length() <= 3 && number <= 127) ? number : -1;
+    }
+
+    // Note name: letter, optional accidental, octave (C4 = 60)
+    static const int semitones[] = { 9, 11, 0, 2, 4, 5, 7 }; // A B C D E F G
+    auto letter = juce::CharacterFunctions::toUpperCase(token[0]);
+    if (letter < 'A' || letter > 'G')
+        return -1;
+
+    int note = semitones[letter - 'A'];
+    int index = 1;
+    if (token[index] == '#')      { ++note; ++index; }
+    else if (token[index] == 'b') { --note; ++index; }
+
+    auto octaveText = token.substring(index);
+    if (octaveText.isEmpty() || ! octaveText.containsOnly("0123456789"))
+        return -1;
+
+    auto midiNote = (octaveText.getIntValue() + 1) * 12 + note;
+    return (midiNote >= 0 && midiNote <= 127) ? midiNote : -1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    A multisample instrument: a set of key/velocity zones, each backed by one
+    audio file.
+
+    Only the attack portion ("head") of every sample is loaded into memory. The
+    rest stays on disk behind a reader - memory-mapped where the format allows it
+    (WAV/AIFF), a normal streaming reader otherwise - and is fetched ahead of the
+    play heads by the SampleStreamer. RAM use is therefore
+    (number of zones * head length) no matter how large the library is.
+
+    Zones are built from a folder of files whose names carry the root note and,
+    optionally, the top velocity of the layer, e.g.
+        Piano_C4_v64.wav, Piano_C4_v127.wav, Piano_F#4_v64.wav ...
+    (middle C = C4 = 60; a bare number 0-127 is taken as a MIDI note).
+    Each root covers the keys halfway to its neighbours.
+
+    Immutable once loaded, so the audio and streaming threads can read it freely.
+*/
+class SampleLibrary
+{
+public:
+    struct Zone
+    {
+        juce::File file;
+        int rootNote = 60;
+        int lowKey = 0, highKey = 127;
+        int lowVelocity = 1, highVelocity = 127;
+
+        double      sampleRate = 44100.0;
+        juce::int64 lengthInSamples = 0;
+        int         headLength = 0;       // Samples held in memory, from the start of the file
+        juce::AudioBuffer<float> head;    // Mono mixdown of the first headLength samples
+        std::unique_ptr<juce::AudioFormatReader> reader; // For the streamer only
+        bool isMemoryMapped = false;
+    };
+
+    static constexpr int defaultHeadLength = 16384; // ~0.37s at 44.1kHz
+
+    SampleLibrary() = default;
+
+    // Slow: opens every file and preloads its head. Call from a background thread.
+    // Returns an error message, or an empty string on success.
+    juce::String loadFromFolder(const juce::File& folder, int headLengthSamples = defaultHeadLength);
+
+    // Audio thread: the zone to play for this note and velocity (1-127), or nullptr
+    const Zone* findZone(int midiNote, int velocity) const noexcept;
+
+    int getNumZones() const noexcept { return (int)zones.size(); }
+    size_t getResidentBytes() const noexcept;
+    juce::String getName() const { return name; }
+
+    // Parses "C4", "F#3", "Db2", "60"... Returns -1 if the token isn't a note
+    static int parseNoteToken(const juce::String& token);
+
+private:
+    void assignKeyRanges();
+
+    std::vector<std::unique_ptr<Zone>> zones;
+    std::array<const Zone*, 128 * 128> keyVelocityMap{}; // [note * 128 + velocity]
+    juce::String name;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleLibrary)
+};
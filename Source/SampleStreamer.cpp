@@ -0,0 +1,176 @@
+#include "SampleStreamer.h"
+
+//==============================================================================
+SampleStreamer::SampleStreamer()
+    : juce::Thread("CSYNTH Sample Streamer")
+{
+    // All ring memory is allocated up front - nothing here grows once playback starts
+    for (auto& slot : slots)
+        slot.ring.assign((size_t)ringSize, 0.0f);
+    readBuffer.setSize(2, readChunkSize);
+
+    startThread(juce::Thread::Priority::high); // Disk reads must stay ahead of the audio thread
+}
+
+SampleStreamer::~SampleStreamer()
+{
+    loaderPool.removeAllJobs(true, 10000);
+    stopThread(2000);
+
+    // No other thread is running now, so whatever is left can be deleted directly
+    delete pendingLibrary.exchange(nullptr);
+    delete retiredLibrary.exchange(nullptr);
+    delete activeLibrary;
+}
+
+//==============================================================================
+void SampleStreamer::loadLibraryAsync(const juce::File& folder)
+{
+    if (loadInProgress.exchange(true))
+    {
+        DBG("SampleStreamer::loadLibraryAsync - Already loading, ignoring " + folder.getFullPathName());
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl(statusLock);
+        statusText = "Loading " + folder.getFileName() + "...";
+    }
+
+    loaderPool.addJob([this, folder]
+    {
+        auto library = std::make_unique<SampleLibrary>();
+        auto error = library->loadFromFolder(folder);
+
+        {
+            const juce::ScopedLock sl(statusLock);
+            if (error.isNotEmpty())
+                statusText = error;
+            else
+                statusText = library->getName() + ": " + juce::String(library->getNumZones()) + " zones, "
+                           + juce::String((double)library->getResidentBytes() / (1024.0 * 1024.0), 1) + " MB in RAM";
+        }
+
+        if (error.isEmpty())
+        {
+            // Replaces any library the audio thread hasn't picked up yet
+            delete pendingLibrary.exchange(library.release());
+        }
+
+        loadInProgress.store(false);
+    });
+}
+
+juce::String SampleStreamer::getStatusText() const
+{
+    const juce::ScopedLock sl(statusLock);
+    return statusText;
+}
+
+//==============================================================================
+bool SampleStreamer::beginBlock() noexcept
+{
+    // The previous library must have been deleted before another can be retired
+    if (pendingLibrary.load() == nullptr || retiredLibrary.load() != nullptr)
+        return false;
+
+    auto* newLibrary = pendingLibrary.exchange(nullptr);
+
+    // Release every stream first, so that by the time the prefetcher sees the retired
+    // library it has also seen the new generations and dropped its old zone pointers
+    for (int i = 0; i < numSlots; ++i)
+        requestStream(i, nullptr);
+
+    retiredLibrary.store(activeLibrary);
+    activeLibrary = newLibrary;
+    return true;
+}
+
+juce::uint32 SampleStreamer::requestStream(int slotIndex, const SampleLibrary::Zone* zone) noexcept
+{
+    auto& slot = slots[(size_t)slotIndex];
+    slot.requestedZone.store(zone);
+    slot.playPosition.store(0);
+    auto generation = slot.requestGeneration.load() + 1;
+    slot.requestGeneration.store(generation); // Published last: the prefetcher reads the zone after seeing it
+
+    // No notify() here: signalling the thread's event takes a mutex. The prefetcher polls
+    // every couple of milliseconds, well inside the time the resident head lasts.
+    return generation;
+}
+
+void SampleStreamer::setPlayPosition(int slotIndex, juce::int64 position) noexcept
+{
+    slots[(size_t)slotIndex].playPosition.store(position);
+}
+
+bool SampleStreamer::getStreamView(int slotIndex, juce::uint32 generation, StreamView& view) const noexcept
+{
+    const auto& slot = slots[(size_t)slotIndex];
+    if (slot.servedGeneration.load() != generation)
+        return false;
+
+    view.ring = slot.ring.data();
+    view.availableEnd = slot.availableEnd.load();
+    return true;
+}
+
+//==============================================================================
+void SampleStreamer::run()
+{
+    while (! threadShouldExit())
+    {
+        // Read before servicing, so every slot has moved past the swap when it gets deleted
+        auto* retired = retiredLibrary.load();
+
+        bool didWork = false;
+        for (auto& slot : slots)
+            didWork = serviceSlot(slot) || didWork;
+
+        if (retired != nullptr)
+        {
+            delete retired;
+            retiredLibrary.store(nullptr);
+        }
+
+        // Keep going while there's work, otherwise poll often enough to follow fast play heads
+        if (! didWork)
+            wait(2);
+    }
+}
+
+bool SampleStreamer::serviceSlot(Slot& slot)
+{
+    // --- New request? Start over from the end of the resident head ---
+    auto generation = slot.requestGeneration.load();
+    if (generation != slot.servedGeneration.load())
+    {
+        slot.zone = slot.requestedZone.load();
+        slot.writePosition = slot.zone != nullptr ? slot.zone->headLength : 0;
+        slot.availableEnd.store(slot.writePosition);
+        slot.servedGeneration.store(generation);
+    }
+
+    auto* zone = slot.zone;
+    if (zone == nullptr || slot.writePosition >= zone->lengthInSamples)
+        return false;
+
+    // --- Fill ahead, without overwriting anything the voice hasn't played yet, or has played within the margin ---
+    auto playPosition = juce::jmax((juce::int64)zone->headLength, slot.playPosition.load());
+    if (slot.writePosition - playPosition > ringSize - readChunkSize - rewindMargin)
+        return false;
+
+    auto numToRead = (int)juce::jmin((juce::int64)readChunkSize, zone->lengthInSamples - slot.writePosition);
+    auto numSourceChannels = juce::jlimit(1, 2, (int)zone->reader->numChannels);
+    zone->reader->read(&readBuffer, 0, numToRead, slot.writePosition, true, numSourceChannels > 1);
+
+    // Mono mixdown straight into the ring, wrapping at the end (a mono file is averaged with itself)
+    const auto* left = readBuffer.getReadPointer(0);
+    const auto* right = readBuffer.getReadPointer(numSourceChannels > 1 ? 1 : 0);
+    for (int i = 0; i < numToRead; ++i)
+        slot.ring[(size_t)((slot.writePosition + i) & (ringSize - 1))] = (left[i] + right[i]) * 0.5f;
+
+    slot.writePosition += numToRead;
+    slot.availableEnd.store(slot.writePosition); // Released after the samples are in the ring
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "SampleLibrary.h"
+
+//==============================================================================
+/*
+    Background prefetch thread for disk-streamed sample playback.
+
+    There is one stream slot per synth voice. When a sampler voice starts, it plays
+    the zone's in-memory head and asks this thread, through atomics only, to stream
+    the rest of the file into the slot's ring buffer. The voice reports how far it
+    has played after every block and the prefetcher keeps the ring topped up ahead
+    of it. If the disk falls behind, the voice outputs silence for the missing
+    samples and an underrun is counted - it never waits.
+
+    Also owns the active SampleLibrary. New libraries are loaded on a worker thread
+    and swapped in by the audio thread at a block boundary; the old one is deleted
+    here, once no stream can still be reading from it.
+*/
+class SampleStreamer : private juce::Thread
+{
+public:
+    static constexpr int numSlots = 8;          // One per SynthEngine voice
+    static constexpr int ringSize = 1 << 16;    // Samples per slot (~1.4s at 48kHz), power of two
+    static constexpr int readChunkSize = 4096;  // Samples fetched from disk at a time
+    static constexpr int rewindMargin = 1 << 14; // Played samples kept in the ring, so a render-ahead rollback can replay them
+
+    SampleStreamer();
+    ~SampleStreamer() override;
+
+    // --- Message thread ---
+    // Loads the folder on a worker thread; the audio thread picks the result up in beginBlock
+    void loadLibraryAsync(const juce::File& folder);
+    bool isLoading() const noexcept { return loadInProgress.load(); }
+    juce::String getStatusText() const;
+    int getNumUnderruns() const noexcept { return underruns.load(); }
+
+    // --- Audio thread ---
+    // Call at the start of each block. Returns true if a new library was swapped in,
+    // in which case every zone pointer from the previous library is now invalid.
+    bool beginBlock() noexcept;
+    const SampleLibrary* getLibrary() const noexcept { return activeLibrary; }
+
+    // Starts streaming a zone into a slot (nullptr releases it). Returns the generation
+    // the voice must pass to getStreamView.
+    juce::uint32 requestStream(int slot, const SampleLibrary::Zone* zone) noexcept;
+
+    // Everything more than rewindMargin before this position has been played and may be overwritten
+    void setPlayPosition(int slot, juce::int64 position) noexcept;
+
+    struct StreamView
+    {
+        const float* ring = nullptr;
+        juce::int64 availableEnd = 0; // Samples [headLength, availableEnd) are in the ring, at index & (ringSize - 1)
+    };
+    // Returns false if the prefetcher hasn't started on this generation yet
+    bool getStreamView(int slot, juce::uint32 generation, StreamView& view) const noexcept;
+
+    void reportUnderrun() noexcept { ++underruns; }
+
+private:
+    struct Slot
+    {
+        // Written by the audio thread
+        std::atomic<const SampleLibrary::Zone*> requestedZone{ nullptr };
+        std::atomic<juce::uint32> requestGeneration{ 0 };
+        std::atomic<juce::int64>  playPosition{ 0 };
+
+        // Written by the prefetch thread
+        std::atomic<juce::uint32> servedGeneration{ 0 };
+        std::atomic<juce::int64>  availableEnd{ 0 };
+        std::vector<float> ring;
+
+        // Prefetch thread only
+        const SampleLibrary::Zone* zone = nullptr;
+        juce::int64 writePosition = 0;
+    };
+
+    void run() override;
+    bool serviceSlot(Slot& slot); // Returns true if it read anything from disk
+
+    std::array<Slot, numSlots> slots;
+    juce::AudioBuffer<float> readBuffer; // Prefetch thread scratch
+
+    // Library hand-over: loader -> pendingLibrary -> (audio thread) activeLibrary -> retiredLibrary -> deleted by run()
+    SampleLibrary* activeLibrary = nullptr; // Audio thread only
+    std::atomic<SampleLibrary*> pendingLibrary{ nullptr };
+    std::atomic<SampleLibrary*> retiredLibrary{ nullptr };
+
+    juce::ThreadPool loaderPool{ 1 };
+    std::atomic<bool> loadInProgress{ false };
+    std::atomic<int> underruns{ 0 };
+
+    juce::CriticalSection statusLock; // Loader and message threads only
+    juce::String statusText{ "No samples loaded" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleStreamer)
+};
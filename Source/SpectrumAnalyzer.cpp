@@ -0,0 +1,147 @@
+#include "SpectrumAnalyzer.h"
+#include <cmath>
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : juce::Thread("CSYNTH Spectrum Analyzer")
+{
+    fifoBuffer.assign((size_t)fifoSize, 0.0f);
+    history.assign((size_t)historySize, 0.0f);
+    smoothedDecibels.fill(minDecibels);
+    for (auto& frame : frames)
+        frame.fill(minDecibels);
+
+    startThread(juce::Thread::Priority::low); // Purely cosmetic - must never compete with audio
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopThread(1000);
+}
+
+float SpectrumAnalyzer::getDisplayFrequency(int pointIndex) const noexcept
+{
+    // Log-spaced from minFrequency up to Nyquist (capped at 20kHz)
+    auto maxFrequency = juce::jmin(20000.0f, (float)sampleRate.load() * 0.5f);
+    auto proportion = (float)pointIndex / (float)(numDisplayPoints - 1);
+    return minFrequency * std::pow(maxFrequency / minFrequency, proportion);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::pushSamples(const float* samples, int numSamples) noexcept
+{
+    // If the analysis thread has fallen behind, the excess is simply dropped
+    const auto scope = fifo.write(numSamples);
+    if (scope.blockSize1 > 0)
+        std::copy_n(samples, scope.blockSize1, fifoBuffer.data() + scope.startIndex1);
+    if (scope.blockSize2 > 0)
+        std::copy_n(samples + scope.blockSize1, scope.blockSize2, fifoBuffer.data() + scope.startIndex2);
+}
+
+bool SpectrumAnalyzer::acquireLatestFrame() noexcept
+{
+    if ((middleState.load() & newFrameFlag) == 0)
+        return false;
+
+    // Hand our old front buffer over as the new middle, take the fresh one
+    frontIndex = middleState.exchange(frontIndex) & ~newFrameFlag;
+    return true;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::run()
+{
+    while (! threadShouldExit())
+    {
+        auto order = fftOrder.load();
+        auto rate = sampleRate.load();
+        if (order != configuredOrder || rate != configuredSampleRate)
+            configure(order, rate);
+
+        // Move everything the audio thread has queued into the history ring
+        {
+            const auto scope = fifo.read(fifo.getNumReady());
+            auto copyToHistory = [this](const float* source, int count)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    history[(size_t)historyWritePos] = source[i];
+                    historyWritePos = (historyWritePos + 1) & (historySize - 1);
+                }
+                newSamplesSinceFrame += count;
+            };
+            copyToHistory(fifoBuffer.data() + scope.startIndex1, scope.blockSize1);
+            copyToHistory(fifoBuffer.data() + scope.startIndex2, scope.blockSize2);
+        }
+
+        if (newSamplesSinceFrame > 0)
+        {
+            analyse();
+            publishFrame();
+            newSamplesSinceFrame = 0;
+        }
+
+        wait(juce::jmax(1, juce::roundToInt(1000.0f / analysisRateHz.load())));
+    }
+}
+
+void SpectrumAnalyzer::configure(int order, double rate)
+{
+    configuredOrder = order;
+    configuredSampleRate = rate;
+
+    const auto size = 1 << order;
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t)size, juce::dsp::WindowingFunction<float>::hann, false);
+    fftBuffer.assign((size_t)size * 2, 0.0f);
+
+    // Which FFT bins fall between neighbouring display points (at least one each)
+    const auto binWidth = rate / size;
+    for (int point = 0; point <= numDisplayPoints; ++point)
+    {
+        auto edgeFrequency = point == 0 ? 0.0 : std::sqrt((double)getDisplayFrequency(point - 1) * getDisplayFrequency(juce::jmin(point, numDisplayPoints - 1)));
+        pointBinEdges[(size_t)point] = juce::jlimit(0, size / 2, juce::roundToInt(edgeFrequency / binWidth));
+    }
+    for (int point = 0; point < numDisplayPoints; ++point)
+        pointBinEdges[(size_t)(point + 1)] = juce::jmax(pointBinEdges[(size_t)(point + 1)], pointBinEdges[(size_t)point] + 1);
+
+    DBG("SpectrumAnalyzer: FFT size " + juce::String(size) + " at " + juce::String(rate) + " Hz");
+}
+
+void SpectrumAnalyzer::analyse()
+{
+    const auto size = 1 << configuredOrder;
+
+    // Latest `size` samples, oldest first
+    auto readPos = (historyWritePos - size) & (historySize - 1);
+    for (int i = 0; i < size; ++i)
+        fftBuffer[(size_t)i] = history[(size_t)((readPos + i) & (historySize - 1))];
+    std::fill(fftBuffer.begin() + size, fftBuffer.end(), 0.0f);
+
+    window->multiplyWithWindowingTable(fftBuffer.data(), (size_t)size);
+    fft->performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+    // Peak hold with an exponential fall, so the display doesn't flicker at high analysis rates
+    auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    auto elapsed = juce::jlimit(0.0, 1.0, now - lastFrameTime);
+    lastFrameTime = now;
+    auto release = (float)(1.0 - std::exp(-elapsed / 0.3));
+
+    const auto amplitudeScale = 4.0f / (float)size; // Full-scale sine -> 0 dB with a Hann window
+    for (int point = 0; point < numDisplayPoints; ++point)
+    {
+        auto magnitude = 0.0f;
+        for (int bin = pointBinEdges[(size_t)point]; bin < pointBinEdges[(size_t)(point + 1)] && bin <= size / 2; ++bin)
+            magnitude = juce::jmax(magnitude, fftBuffer[(size_t)bin]);
+
+        auto decibels = juce::Decibels::gainToDecibels(magnitude * amplitudeScale, minDecibels);
+        auto& smoothed = smoothedDecibels[(size_t)point];
+        smoothed = decibels > smoothed ? decibels : smoothed + (decibels - smoothed) * release;
+    }
+}
+
+void SpectrumAnalyzer::publishFrame()
+{
+    frames[(size_t)backIndex] = smoothedDecibels;
+    backIndex = middleState.exchange(backIndex | newFrameFlag) & ~newFrameFlag;
+}
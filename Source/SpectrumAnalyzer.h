@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h> // For dsp::FFT and dsp::WindowingFunction
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    Turns the master output into a smoothed, log-frequency magnitude spectrum.
+
+    The audio thread only copies samples into a lock-free FIFO (pushSamples).
+    A background thread drains it, and at the chosen analysis rate windows the
+    latest fftSize samples, runs the FFT, converts to dB, applies peak-hold
+    smoothing and resamples onto numDisplayPoints log-spaced frequencies.
+
+    Finished frames are handed to the UI through a triple buffer: the analysis
+    thread and the message thread each own one buffer and swap through the
+    third with a single atomic exchange, so neither side ever waits and the
+    paint code only reads a precomputed array.
+
+    FFT size and analysis rate can be changed at any time (any thread); a smaller
+    FFT or a lower rate keeps monitoring cheap on slow machines.
+*/
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    static constexpr int numDisplayPoints = 256;
+    static constexpr int minFftOrder = 10, maxFftOrder = 13; // 1024 - 8192 points
+    static constexpr float minDecibels = -100.0f;
+    static constexpr float minFrequency = 20.0f;
+
+    using Frame = std::array<float, numDisplayPoints>; // dB, at getDisplayFrequency(i)
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    // --- Any thread ---
+    void setSampleRate(double newSampleRate) { sampleRate.store(newSampleRate); }
+    void setFftOrder(int order)              { fftOrder.store(juce::jlimit(minFftOrder, maxFftOrder, order)); }
+    void setAnalysisRate(float framesPerSecond) { analysisRateHz.store(juce::jlimit(1.0f, 60.0f, framesPerSecond)); }
+    int getFftOrder() const noexcept         { return fftOrder.load(); }
+    float getAnalysisRate() const noexcept   { return analysisRateHz.load(); }
+    float getDisplayFrequency(int pointIndex) const noexcept;
+
+    // --- Audio thread ---
+    void pushSamples(const float* samples, int numSamples) noexcept;
+
+    // --- Message thread ---
+    // Returns true if a new frame arrived since the last call; getLatestFrame() then returns it
+    bool acquireLatestFrame() noexcept;
+    const Frame& getLatestFrame() const noexcept { return frames[(size_t)frontIndex]; }
+
+private:
+    static constexpr int fifoSize = 1 << 15;
+    static constexpr int historySize = 1 << maxFftOrder;
+    static constexpr int newFrameFlag = 4; // Set in middleState when the middle buffer holds an unread frame
+
+    void run() override;
+    void configure(int order, double rate);
+    void analyse();
+    void publishFrame();
+
+    // Audio -> analysis thread
+    juce::AbstractFifo fifo{ fifoSize };
+    std::vector<float> fifoBuffer;
+
+    // Analysis thread
+    std::vector<float> history; // Ring of the most recent samples
+    int historyWritePos = 0;
+    int newSamplesSinceFrame = 0;
+    int configuredOrder = 0;
+    double configuredSampleRate = 0.0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::vector<float> fftBuffer;
+    std::array<int, numDisplayPoints + 1> pointBinEdges{}; // FFT bins [edge[i], edge[i+1]) feed point i
+    Frame smoothedDecibels{};
+    double lastFrameTime = 0.0;
+
+    // Triple buffer: frames[backIndex] is written by the analysis thread, frames[frontIndex] read
+    // by the message thread, and the third is exchanged between them via middleState
+    std::array<Frame, 3> frames{};
+    int backIndex = 0, frontIndex = 2;
+    std::atomic<int> middleState{ 1 };
+
+    // Settings
+    std::atomic<double> sampleRate{ 44100.0 };
+    std::atomic<int> fftOrder{ 11 };
+    std::atomic<float> analysisRateHz{ 30.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
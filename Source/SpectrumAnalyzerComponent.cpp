@@ -0,0 +1,102 @@
+#include "SpectrumAnalyzerComponent.h"
+#include <cmath>
+
+//==============================================================================
+SpectrumAnalyzerComponent::SpectrumAnalyzerComponent(SpectrumAnalyzer& analyzerToShow)
+    : analyzer(analyzerToShow)
+{
+    // FFT size: ComboBox ID is the FFT order
+    for (int order = SpectrumAnalyzer::minFftOrder; order <= SpectrumAnalyzer::maxFftOrder; ++order)
+        fftSizeSelector.addItem(juce::String(1 << order), order);
+    fftSizeSelector.setSelectedId(analyzer.getFftOrder(), juce::dontSendNotification);
+    fftSizeSelector.setTooltip("FFT size");
+    fftSizeSelector.addListener(this);
+    addAndMakeVisible(fftSizeSelector);
+
+    // Analysis rate: ComboBox ID is frames per second
+    for (auto rate : { 5, 10, 20, 30, 60 })
+        rateSelector.addItem(juce::String(rate) + " fps", rate);
+    rateSelector.setSelectedId(juce::roundToInt(analyzer.getAnalysisRate()), juce::dontSendNotification);
+    rateSelector.setTooltip("Analysis rate");
+    rateSelector.addListener(this);
+    addAndMakeVisible(rateSelector);
+
+    startTimerHz(30);
+}
+
+SpectrumAnalyzerComponent::~SpectrumAnalyzerComponent()
+{
+    stopTimer();
+    fftSizeSelector.removeListener(this);
+    rateSelector.removeListener(this);
+}
+
+//==============================================================================
+void SpectrumAnalyzerComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    // Grid: decades and every 20 dB
+    g.setColour(juce::Colours::darkgrey.withAlpha(0.6f));
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+        g.drawVerticalLine(juce::roundToInt(frequencyToX(frequency)), 0.0f, (float)getHeight());
+    for (auto decibels = -20.0f; decibels > SpectrumAnalyzer::minDecibels; decibels -= 20.0f)
+        g.drawHorizontalLine(juce::roundToInt(decibelsToY(decibels)), 0.0f, (float)getWidth());
+
+    g.setFont(juce::FontOptions(11.0f));
+    g.drawText("100", juce::roundToInt(frequencyToX(100.0f)) + 2, getHeight() - 14, 40, 12, juce::Justification::left);
+    g.drawText("1k", juce::roundToInt(frequencyToX(1000.0f)) + 2, getHeight() - 14, 40, 12, juce::Justification::left);
+    g.drawText("10k", juce::roundToInt(frequencyToX(10000.0f)) + 2, getHeight() - 14, 40, 12, juce::Justification::left);
+
+    // Spectrum
+    const auto& frame = analyzer.getLatestFrame();
+    juce::Path spectrumPath;
+    for (int point = 0; point < SpectrumAnalyzer::numDisplayPoints; ++point)
+    {
+        auto x = frequencyToX(analyzer.getDisplayFrequency(point));
+        auto y = decibelsToY(frame[(size_t)point]);
+        if (point == 0)
+            spectrumPath.startNewSubPath(x, y);
+        else
+            spectrumPath.lineTo(x, y);
+    }
+
+    g.setColour(juce::Colours::limegreen);
+    g.strokePath(spectrumPath, juce::PathStrokeType(1.0f));
+}
+
+void SpectrumAnalyzerComponent::resized()
+{
+    auto selectorArea = getLocalBounds().removeFromTop(20).reduced(2, 0);
+    rateSelector.setBounds(selectorArea.removeFromRight(70));
+    selectorArea.removeFromRight(4);
+    fftSizeSelector.setBounds(selectorArea.removeFromRight(70));
+}
+
+//==============================================================================
+void SpectrumAnalyzerComponent::timerCallback()
+{
+    // Only repaint when the analysis thread has produced something new
+    if (analyzer.acquireLatestFrame())
+        repaint();
+}
+
+void SpectrumAnalyzerComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
+{
+    if (comboBoxThatHasChanged == &fftSizeSelector)
+        analyzer.setFftOrder(fftSizeSelector.getSelectedId());
+    else if (comboBoxThatHasChanged == &rateSelector)
+        analyzer.setAnalysisRate((float)rateSelector.getSelectedId());
+}
+
+float SpectrumAnalyzerComponent::frequencyToX(float frequency) const
+{
+    auto lowest = analyzer.getDisplayFrequency(0);
+    auto highest = analyzer.getDisplayFrequency(SpectrumAnalyzer::numDisplayPoints - 1);
+    return (float)getWidth() * std::log(frequency / lowest) / std::log(highest / lowest);
+}
+
+float SpectrumAnalyzerComponent::decibelsToY(float decibels) const
+{
+    return juce::jmap(decibels, SpectrumAnalyzer::minDecibels, 0.0f, (float)getHeight(), 0.0f);
+}
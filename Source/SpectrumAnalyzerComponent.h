@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyzer.h"
+
+//==============================================================================
+/*
+    Draws the SpectrumAnalyzer's latest frame: magnitude in dB over a log
+    frequency axis. All the analysis happens on the analyzer's own thread -
+    this component only copies out finished frames and strokes a path.
+
+    The two small selectors in the corner set the FFT size and the analysis rate.
+*/
+class SpectrumAnalyzerComponent : public juce::Component,
+    private juce::Timer,
+    private juce::ComboBox::Listener
+{
+public:
+    explicit SpectrumAnalyzerComponent(SpectrumAnalyzer& analyzerToShow);
+    ~SpectrumAnalyzerComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
+
+    float frequencyToX(float frequency) const;
+    float decibelsToY(float decibels) const;
+
+    SpectrumAnalyzer& analyzer;
+    juce::ComboBox fftSizeSelector;
+    juce::ComboBox rateSelector;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzerComponent)
+};
@@ -0,0 +1,94 @@
+#include "StartupProfiler.h"
+
+namespace
+{
+    // Taken during static initialisation - as close to process start as portable code gets
+    const double processStartMs = juce::Time::getMillisecondCounterHiRes();
+
+    double millisecondsSinceStart() noexcept
+    {
+        return juce::Time::getMillisecondCounterHiRes() - processStartMs;
+    }
+
+    struct Phase
+    {
+        const char* name = nullptr;
+        double timeMs = 0.0;
+    };
+
+    // Message thread only
+    constexpr int maxPhases = 24;
+    std::array<Phase, maxPhases> phases;
+    int numPhases = 0;
+    bool phasesReported = false;
+    bool firstSoundReported = false;
+
+    // Written once by the audio thread (-1 = not yet)
+    std::atomic<double> firstCallbackMs{ -1.0 };
+    std::atomic<double> firstSoundMs{ -1.0 };
+
+    constexpr double giveUpOnFirstSoundMs = 120000.0; // Nobody played anything - stop waiting
+}
+
+//==============================================================================
+void StartupProfiler::mark(const char* phaseName)
+{
+    if (numPhases < maxPhases)
+        phases[(size_t)numPhases++] = { phaseName, millisecondsSinceStart() };
+}
+
+bool StartupProfiler::reportIfReady()
+{
+    auto callbackMs = firstCallbackMs.load(std::memory_order_relaxed);
+
+    if (! phasesReported && callbackMs >= 0.0)
+    {
+        phasesReported = true;
+
+        juce::String report("Startup timing (ms since launch):\n");
+        auto previousMs = 0.0;
+        auto addLine = [&](const juce::String& name, double timeMs)
+        {
+            report << "  " << name.paddedRight(' ', 28) << juce::String(timeMs, 1).paddedLeft(' ', 8)
+                   << "  (+" << juce::String(timeMs - previousMs, 1) << ")\n";
+            previousMs = timeMs;
+        };
+
+        for (int i = 0; i < numPhases; ++i)
+            addLine(phases[(size_t)i].name, phases[(size_t)i].timeMs);
+        addLine("first audio callback", callbackMs);
+
+        juce::Logger::writeToLog(report.trimEnd());
+    }
+
+    auto soundMs = firstSoundMs.load(std::memory_order_relaxed);
+    if (! firstSoundReported && soundMs >= 0.0)
+    {
+        firstSoundReported = true;
+        juce::Logger::writeToLog("Startup timing: first audible output at " + juce::String(soundMs, 1) + " ms");
+    }
+
+    return phasesReported && (firstSoundReported || millisecondsSinceStart() > giveUpOnFirstSoundMs);
+}
+
+//==============================================================================
+void StartupProfiler::markFirstCallback() noexcept
+{
+    if (firstCallbackMs.load(std::memory_order_relaxed) < 0.0)
+        firstCallbackMs.store(millisecondsSinceStart(), std::memory_order_relaxed);
+}
+
+void StartupProfiler::markOutput(const float* samples, int numSamples) noexcept
+{
+    if (firstSoundMs.load(std::memory_order_relaxed) >= 0.0)
+        return;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (samples[i] != 0.0f)
+        {
+            firstSoundMs.store(millisecondsSinceStart(), std::memory_order_relaxed);
+            return;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/*
+    Startup timing report.
+
+    Times are milliseconds since the executable was loaded (static
+    initialisation). The message thread marks named phases as it goes; the
+    audio thread marks its first callback and its first audible output, which
+    is what a restarting kiosk actually waits for. Once the first callback has
+    happened, reportIfReady() writes the phases and the delta between them
+    to the Logger; the first audible output follows as its own line whenever
+    something is played.
+*/
+class StartupProfiler
+{
+public:
+    // --- Message thread ---
+    static void mark(const char* phaseName);  // phaseName must be a string literal
+    // Writes whatever is ready to report. Returns true once there is nothing left to wait for.
+    static bool reportIfReady();
+
+    // --- Audio thread (one relaxed atomic load each once the mark is set) ---
+    static void markFirstCallback() noexcept;
+    static void markOutput(const float* samples, int numSamples) noexcept;
+
+private:
+    StartupProfiler() = delete;
+};
@@ -0,0 +1,321 @@
+#include "StatsPublisher.h"
+#include <iostream>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+ #define CSYNTH_SHARED_STATS 1
+#elif JUCE_WINDOWS
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #define CSYNTH_SHARED_STATS 1
+#else
+ #define CSYNTH_SHARED_STATS 0
+#endif
+
+//==============================================================================
+// The layout other processes see. Fields are lock-free atomics so the seqlock is well defined on both sides.
+struct StatsPublisher::SharedBlock
+{
+    juce::uint32 magic;
+    juce::uint32 layoutVersion;
+    std::atomic<juce::uint32> sequence;     // Odd while the audio thread is writing
+    juce::uint32 reserved;
+    juce::int64  processId;
+
+    std::atomic<double>       sampleRate;
+    std::atomic<int>          blockSize;
+    std::atomic<float>        callbackLoad;
+    std::atomic<float>        smoothedLoad;
+    std::atomic<int>          qualityTier;
+    std::atomic<juce::uint64> callbacks;
+    std::atomic<juce::uint64> xruns;
+    std::atomic<int>          activeVoices;
+    std::atomic<float>        peakLevel;
+};
+
+static_assert(std::atomic<double>::is_always_lock_free && std::atomic<juce::uint64>::is_always_lock_free,
+              "Shared stats need lock-free atomics: a lock can't live in memory another process maps");
+
+//==============================================================================
+#if CSYNTH_SHARED_STATS
+// Maps the named segment read-only. nullptr if there is none, or it is too small to be one.
+static const void* mapSegmentForReading(size_t size)
+{
+   #if JUCE_WINDOWS
+    auto mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, StatsPublisher::segmentName);
+    if (mapping == nullptr)
+        return nullptr;
+
+    auto* memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    CloseHandle(mapping); // The view keeps the mapping alive
+    return memory;
+   #else
+    auto fd = shm_open(StatsPublisher::segmentName, O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+
+    // A creator that died before sizing the segment leaves it empty, and reading that would fault
+    void* memory = MAP_FAILED;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= size)
+        memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return memory != MAP_FAILED ? memory : nullptr;
+   #endif
+}
+
+static void unmapSegment(const void* memory, size_t size)
+{
+   #if JUCE_WINDOWS
+    juce::ignoreUnused(size);
+    UnmapViewOfFile(memory);
+   #else
+    munmap(const_cast<void*>(memory), size);
+   #endif
+}
+
+static juce::int64 getThisProcessId()
+{
+   #if JUCE_WINDOWS
+    return (juce::int64)GetCurrentProcessId();
+   #else
+    return (juce::int64)getpid();
+   #endif
+}
+
+#if ! JUCE_WINDOWS
+static bool isProcessRunning(juce::int64 processId)
+{
+    return processId > 0 && (kill((pid_t)processId, 0) == 0 || errno == EPERM); // EPERM: alive, someone else's
+}
+#endif
+#endif
+
+//==============================================================================
+void StatsPublisher::open()
+{
+   #if CSYNTH_SHARED_STATS
+    if (block != nullptr)
+        return;
+
+   #if JUCE_WINDOWS
+    // Backed by the page file; the name lives exactly as long as some handle to the mapping does
+    auto mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(SharedBlock), segmentName);
+    if (mapping == nullptr)
+    {
+        DBG("StatsPublisher: CreateFileMapping failed - live statistics are off");
+        return;
+    }
+
+    // It can't be taken over: a running instance (or a reader of a finished one) still holds it
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(mapping);
+        DBG("StatsPublisher: " + juce::String(segmentName) + " is in use by another instance - live statistics are off");
+        return;
+    }
+
+    auto* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedBlock));
+    if (memory == nullptr)
+    {
+        DBG("StatsPublisher: could not map the segment - live statistics are off");
+        CloseHandle(mapping);
+        return;
+    }
+    mappingHandle = mapping;
+   #else
+    // A segment left by a crashed run is replaced - but only once its owner's pid has been read and that
+    // process is gone. One that is too short or has no header yet is still being set up by another
+    // instance, so it counts as in use. The header up to processId is the same in every layout version.
+    if (auto existingFd = shm_open(segmentName, O_RDONLY, 0); existingFd >= 0)
+    {
+        close(existingFd);
+
+        juce::int64 owner = 0;
+        if (auto* existing = static_cast<const SharedBlock*>(mapSegmentForReading(sizeof(SharedBlock))))
+        {
+            owner = existing->magic == magic ? existing->processId : 0;
+            unmapSegment(existing, sizeof(SharedBlock));
+        }
+
+        if (owner <= 0 || isProcessRunning(owner))
+        {
+            DBG("StatsPublisher: " + juce::String(segmentName) + " is in use"
+                + (owner > 0 ? " by process " + juce::String(owner) : juce::String()) + " - live statistics are off");
+            return;
+        }
+
+        shm_unlink(segmentName);
+    }
+
+    auto fd = shm_open(segmentName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        DBG("StatsPublisher: shm_open failed - live statistics are off");
+        return;
+    }
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, (off_t)sizeof(SharedBlock)) == 0)
+        memory = mmap(nullptr, sizeof(SharedBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        DBG("StatsPublisher: could not size or map the segment - live statistics are off");
+        shm_unlink(segmentName);
+        return;
+    }
+   #endif
+
+    block = new (memory) SharedBlock{};
+    block->magic = magic;
+    block->layoutVersion = layoutVersion;
+    block->processId = getThisProcessId();
+    DBG("StatsPublisher: publishing to shared memory " + juce::String(segmentName));
+   #endif
+}
+
+StatsPublisher::~StatsPublisher()
+{
+   #if CSYNTH_SHARED_STATS
+    if (block == nullptr)
+        return;
+
+   #if JUCE_WINDOWS
+    UnmapViewOfFile(block);
+    CloseHandle(mappingHandle); // The name goes with the last handle
+   #else
+    // Only remove the name if it is still ours
+    if (auto* current = static_cast<const SharedBlock*>(mapSegmentForReading(sizeof(SharedBlock))))
+    {
+        if (current->processId == block->processId)
+            shm_unlink(segmentName);
+        unmapSegment(current, sizeof(SharedBlock));
+    }
+
+    munmap(block, sizeof(SharedBlock));
+   #endif
+   #endif
+}
+
+//==============================================================================
+void StatsPublisher::publish(double sampleRate, int blockSize, float callbackLoad, float smoothedLoad,
+                             int qualityTier, int activeVoices, float peakLevel) noexcept
+{
+    ++numCallbacks;
+    if (callbackLoad > 1.0f)
+        ++numXruns;
+
+    if (block == nullptr)
+        return;
+
+    // Seqlock write: odd, fields, even. The fence keeps the field stores after the odd sequence.
+    auto sequence = block->sequence.load(std::memory_order_relaxed);
+    block->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block->sampleRate.store(sampleRate, std::memory_order_relaxed);
+    block->blockSize.store(blockSize, std::memory_order_relaxed);
+    block->callbackLoad.store(callbackLoad, std::memory_order_relaxed);
+    block->smoothedLoad.store(smoothedLoad, std::memory_order_relaxed);
+    block->qualityTier.store(qualityTier, std::memory_order_relaxed);
+    block->callbacks.store(numCallbacks, std::memory_order_relaxed);
+    block->xruns.store(numXruns, std::memory_order_relaxed);
+    block->activeVoices.store(activeVoices, std::memory_order_relaxed);
+    block->peakLevel.store(peakLevel, std::memory_order_relaxed);
+
+    block->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//==============================================================================
+bool StatsPublisher::readSnapshot(Snapshot& snapshot, juce::String& error)
+{
+   #if CSYNTH_SHARED_STATS
+    auto* memory = mapSegmentForReading(sizeof(SharedBlock));
+    if (memory == nullptr)
+    {
+        error = "no statistics segment " + juce::String(segmentName) + " (is the synth running?)";
+        return false;
+    }
+
+    const auto* shared = static_cast<const SharedBlock*>(memory);
+    auto ok = shared->magic == magic && shared->layoutVersion == layoutVersion;
+    if (! ok)
+        error = "unknown layout (version " + juce::String(shared->layoutVersion) + ", expected " + juce::String(layoutVersion) + ")";
+
+    // Seqlock read: retry while a write is in progress or one happened while we were copying
+    for (int attempt = 0; ok; ++attempt)
+    {
+        auto before = shared->sequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0)
+        {
+            snapshot.processId = shared->processId;
+            snapshot.sampleRate = shared->sampleRate.load(std::memory_order_relaxed);
+            snapshot.blockSize = shared->blockSize.load(std::memory_order_relaxed);
+            snapshot.callbackLoad = shared->callbackLoad.load(std::memory_order_relaxed);
+            snapshot.smoothedLoad = shared->smoothedLoad.load(std::memory_order_relaxed);
+            snapshot.qualityTier = shared->qualityTier.load(std::memory_order_relaxed);
+            snapshot.callbacks = shared->callbacks.load(std::memory_order_relaxed);
+            snapshot.xruns = shared->xruns.load(std::memory_order_relaxed);
+            snapshot.activeVoices = shared->activeVoices.load(std::memory_order_relaxed);
+            snapshot.peakLevel = shared->peakLevel.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shared->sequence.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        if (attempt >= 1000)
+        {
+            error = "the writer never settled (stuck mid-write?)";
+            ok = false;
+        }
+        else if (attempt >= 100)
+        {
+            juce::Thread::sleep(1); // The audio thread was probably preempted mid-write
+        }
+    }
+
+    unmapSegment(memory, sizeof(SharedBlock));
+    return ok;
+   #else
+    juce::ignoreUnused(snapshot);
+    error = "live statistics need shared memory, which this platform doesn't have";
+    return false;
+   #endif
+}
+
+int StatsPublisher::printStats()
+{
+    Snapshot snapshot;
+    juce::String error;
+    if (! readSnapshot(snapshot, error))
+    {
+        std::cerr << "csynth stats: " << error << std::endl;
+        return 1;
+    }
+
+    // key=value, one per line: easy to scrape from any monitoring agent
+    std::cout << "pid=" << snapshot.processId << "\n"
+              << "sample_rate=" << snapshot.sampleRate << "\n"
+              << "block_size=" << snapshot.blockSize << "\n"
+              << "callback_load=" << snapshot.callbackLoad << "\n"
+              << "smoothed_load=" << snapshot.smoothedLoad << "\n"
+              << "quality_tier=" << snapshot.qualityTier << "\n"
+              << "callbacks=" << snapshot.callbacks << "\n"
+              << "xruns=" << snapshot.xruns << "\n"
+              << "active_voices=" << snapshot.activeVoices << "\n"
+              << "peak_level=" << snapshot.peakLevel << std::endl;
+    return 0;
+}
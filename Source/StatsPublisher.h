@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/*
+    Live engine statistics for external monitoring, in a shared-memory segment
+    that any process on the box can map read-only: POSIX shared memory
+    (shm_open) or, on Windows, a named file mapping in the login session.
+    The app's --print-stats mode is the reference reader.
+
+    The block starts with a magic number and a layout version, so a reader
+    can refuse a layout it doesn't know. After that comes a seqlock: the
+    audio thread makes the sequence odd, stores the fields and makes it even
+    again. A reader retries until it sees the same even sequence before and
+    after copying. Publishing is a handful of relaxed stores per block - no
+    syscalls, no locks, and the writer never waits for a reader.
+
+    The first running instance owns the name; later ones don't publish. A
+    POSIX segment left behind by a crashed run (its process is gone) is
+    replaced, while a Windows mapping disappears with its last handle anyway.
+*/
+class StatsPublisher
+{
+public:
+   #if JUCE_WINDOWS
+    static constexpr const char* segmentName = "Local\\csynth-stats";
+   #else
+    static constexpr const char* segmentName = "/csynth-stats";
+   #endif
+    static constexpr juce::uint32 magic = 0x54535343; // "CSST" in memory on little-endian
+    static constexpr juce::uint32 layoutVersion = 1;  // Bump whenever SharedBlock changes
+
+    // One consistent set of values, as the reader gets them
+    struct Snapshot
+    {
+        juce::int64 processId = 0;
+        double sampleRate = 0.0;
+        int    blockSize = 0;        // Samples in the last callback
+        float  callbackLoad = 0.0f;  // Last callback's time / its deadline
+        float  smoothedLoad = 0.0f;  // QualityGovernor's running average
+        int    qualityTier = 0;      // QualityGovernor::Tier
+        juce::uint64 callbacks = 0;
+        juce::uint64 xruns = 0;      // Callbacks that overran their deadline
+        int    activeVoices = 0;
+        float  peakLevel = 0.0f;     // Linear peak of the last master block
+    };
+
+    StatsPublisher() = default;
+    ~StatsPublisher(); // Removes the segment, if open() created it
+
+    // Message thread, before audio starts: creates the segment. Publishing is a no-op until then.
+    void open();
+
+    bool isPublishing() const noexcept { return block != nullptr; }
+
+    // --- Audio thread (call last thing in the callback) ---
+    void publish(double sampleRate, int blockSize, float callbackLoad, float smoothedLoad,
+                 int qualityTier, int activeVoices, float peakLevel) noexcept;
+
+    // --- Reader side (another process) ---
+    // Maps the segment read-only and copies one consistent snapshot. False with a reason if it can't.
+    static bool readSnapshot(Snapshot& snapshot, juce::String& error);
+    // --print-stats: writes one snapshot to stdout as key=value lines. Returns the process exit code.
+    static int printStats();
+
+private:
+    struct SharedBlock;
+
+    SharedBlock* block = nullptr;
+    void* mappingHandle = nullptr; // Windows: the mapping's HANDLE, held while publishing
+
+    // Audio thread only - the shared copies are what readers see
+    juce::uint64 numCallbacks = 0, numXruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StatsPublisher)
+};
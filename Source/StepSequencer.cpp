@@ -0,0 +1,261 @@
+#include "StepSequencer.h"
+
+//==============================================================================
+StepSequencer::StepSequencer()
+    : defaultPattern(std::make_unique<Pattern>())
+{
+    activePattern = defaultPattern.get();
+    startTimer(100);
+}
+
+StepSequencer::~StepSequencer()
+{
+    stopTimer();
+
+    // Audio has stopped by now, so everything left is ours
+    delete pendingPattern.exchange(nullptr);
+    deleteRetiredPattern();
+    if (activePattern != defaultPattern.get())
+        delete activePattern;
+}
+
+//==============================================================================
+void StepSequencer::setPattern(std::unique_ptr<Pattern> newPattern)
+{
+    jassert(newPattern != nullptr);
+    deleteRetiredPattern();
+
+    // A pattern the audio thread never picked up is still ours to delete
+    delete pendingPattern.exchange(newPattern.release());
+}
+
+void StepSequencer::timerCallback()
+{
+    deleteRetiredPattern();
+}
+
+void StepSequencer::deleteRetiredPattern()
+{
+    delete retiredPattern.exchange(nullptr);
+}
+
+//==============================================================================
+void StepSequencer::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    running = false;
+    soundingNote = -1;
+    numHeldNotes = 0;
+    currentStepForDisplay.store(-1);
+}
+
+void StepSequencer::swapInPendingPattern() noexcept
+{
+    // Only while the retired slot is free - otherwise try again next block
+    if (retiredPattern.load() != nullptr)
+        return;
+
+    if (auto* newPattern = pendingPattern.exchange(nullptr))
+    {
+        auto* previous = activePattern;
+        activePattern = newPattern;
+        if (previous != defaultPattern.get())
+            retiredPattern.store(previous);
+    }
+}
+
+bool StepSequencer::handleInputEvent(const NoteEvent& event) noexcept
+{
+    bool arpeggiating = activePattern->mode >= arpUp;
+
+    switch (event.type)
+    {
+    case NoteEvent::noteOn:
+    {
+        if (! arpeggiating)
+            return false;
+
+        // Insert keeping the held notes in ascending order
+        int insertAt = 0;
+        while (insertAt < numHeldNotes && heldNotes[(size_t)insertAt] < event.midiNote)
+            ++insertAt;
+        if (numHeldNotes < maxHeldNotes && (insertAt == numHeldNotes || heldNotes[(size_t)insertAt] != event.midiNote))
+        {
+            for (int i = numHeldNotes; i > insertAt; --i)
+                heldNotes[(size_t)i] = heldNotes[(size_t)(i - 1)];
+            heldNotes[(size_t)insertAt] = event.midiNote;
+            ++numHeldNotes;
+        }
+        return true;
+    }
+
+    case NoteEvent::noteOff:
+        // A key the arpeggiator holds is consumed: passed on, it would cut the arpeggiator's own
+        // note of the same pitch. Any other key went down before the mode changed - the engine has it.
+        for (int i = 0; i < numHeldNotes; ++i)
+        {
+            if (heldNotes[(size_t)i] == event.midiNote)
+            {
+                for (int j = i; j < numHeldNotes - 1; ++j)
+                    heldNotes[(size_t)j] = heldNotes[(size_t)(j + 1)];
+                --numHeldNotes;
+                return true;
+            }
+        }
+        return false;
+
+    case NoteEvent::allNotesOff:
+        numHeldNotes = 0;
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+//==============================================================================
+int StepSequencer::processBlock(int numSamples, EventList& events) noexcept
+{
+    swapInPendingPattern();
+    const auto& pattern = *activePattern;
+    int numEvents = 0;
+
+    if (pattern.mode == off || pattern.numSteps <= 0)
+    {
+        if (running)
+        {
+            stopSoundingNote(events, numEvents, 0);
+            running = false;
+            numHeldNotes = 0;
+            currentStepForDisplay.store(-1, std::memory_order_relaxed);
+        }
+        return numEvents;
+    }
+
+    if (! running)
+    {
+        // Start on the first sample of this block
+        running = true;
+        stepIndex = 0;
+        arpPosition = 0;
+        nextStepTime = 0.0;
+    }
+
+    // Tempo changes take effect from the next step boundary
+    auto samplesPerStep = sampleRate * 60.0 / (juce::jmax(1.0, pattern.bpm) * juce::jmax(1, pattern.stepsPerBeat));
+    auto gate = juce::jlimit(0.05, 1.0, (double)pattern.gate);
+
+    // Keep one slot spare, so a step boundary can always emit its note-off and note-on together.
+    // If a block ever runs out, the remaining events slip to the start of the next block.
+    while (numEvents < maxEventsPerBlock - 1)
+    {
+        bool noteOffFirst = soundingNote >= 0 && noteOffTime <= nextStepTime;
+        auto eventTime = noteOffFirst ? noteOffTime : nextStepTime;
+        if (eventTime >= (double)numSamples)
+            break;
+
+        auto sampleOffset = juce::jlimit(0, numSamples - 1, (int)eventTime);
+        if (noteOffFirst)
+        {
+            stopSoundingNote(events, numEvents, sampleOffset);
+            continue;
+        }
+
+        // Step boundary
+        stopSoundingNote(events, numEvents, sampleOffset);
+        if (stepIndex >= pattern.numSteps)
+            stepIndex = 0;
+
+        float velocity = 0.8f;
+        auto midiNote = pickNote(pattern, velocity);
+        if (midiNote >= 0)
+        {
+            auto& timed = events[(size_t)numEvents++];
+            timed.event = {};
+            timed.event.type = NoteEvent::noteOn;
+            timed.event.midiNote = midiNote;
+            timed.event.velocity = velocity;
+            timed.sampleOffset = sampleOffset;
+
+            soundingNote = midiNote;
+            noteOffTime = nextStepTime + samplesPerStep * gate;
+        }
+
+        currentStepForDisplay.store(stepIndex, std::memory_order_relaxed);
+        stepIndex = (stepIndex + 1) % pattern.numSteps;
+        nextStepTime += samplesPerStep;
+    }
+
+    // Carry the fractional positions into the next block (no drift from rounding to samples)
+    nextStepTime -= numSamples;
+    noteOffTime -= numSamples;
+    return numEvents;
+}
+
+int StepSequencer::pickNote(const Pattern& pattern, float& velocity) noexcept
+{
+    const auto& step = pattern.steps[(size_t)stepIndex];
+    velocity = step.velocity;
+
+    if (pattern.mode == sequence)
+        return step.midiNote;
+
+    if (numHeldNotes == 0)
+        return -1;
+
+    int index = 0;
+    switch (pattern.mode)
+    {
+    case arpUp:   index = arpPosition % numHeldNotes; break;
+    case arpDown: index = numHeldNotes - 1 - arpPosition % numHeldNotes; break;
+    case arpUpDown:
+    {
+        // Ping-pong without repeating the top and bottom notes
+        auto period = juce::jmax(1, 2 * (numHeldNotes - 1));
+        auto position = arpPosition % period;
+        index = position < numHeldNotes ? position : period - position;
+        break;
+    }
+    default: break;
+    }
+
+    ++arpPosition;
+    return heldNotes[(size_t)index];
+}
+
+void StepSequencer::saveState(State& state) const noexcept
+{
+    state.running = running;
+    state.stepIndex = stepIndex;
+    state.nextStepTime = nextStepTime;
+    state.noteOffTime = noteOffTime;
+    state.soundingNote = soundingNote;
+    state.heldNotes = heldNotes;
+    state.numHeldNotes = numHeldNotes;
+    state.arpPosition = arpPosition;
+}
+
+void StepSequencer::restoreState(const State& state) noexcept
+{
+    running = state.running;
+    stepIndex = state.stepIndex;
+    nextStepTime = state.nextStepTime;
+    noteOffTime = state.noteOffTime;
+    soundingNote = state.soundingNote;
+    heldNotes = state.heldNotes;
+    numHeldNotes = state.numHeldNotes;
+    arpPosition = state.arpPosition;
+}
+
+void StepSequencer::stopSoundingNote(EventList& events, int& numEvents, int sampleOffset) noexcept
+{
+    if (soundingNote < 0 || numEvents >= maxEventsPerBlock)
+        return;
+
+    auto& timed = events[(size_t)numEvents++];
+    timed.event = {};
+    timed.event.type = NoteEvent::noteOff;
+    timed.event.midiNote = soundingNote;
+    timed.sampleOffset = sampleOffset;
+    soundingNote = -1;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include "NoteEventQueue.h"
+
+//==============================================================================
+/*
+    Tempo-based step sequencer / arpeggiator that runs inside the audio callback.
+
+    Each block, processBlock() advances a sample-position clock and returns the
+    note events that fall inside the block together with their exact sample
+    offsets; MainComponent splits the engine render at those offsets, so steps
+    land on the sample rather than on the block or a message-thread timer tick.
+
+    Patterns are built on the message thread and handed over with setPattern():
+    the audio thread exchanges the pointer at the start of a block and parks
+    the replaced pattern in a retired slot for the message thread to delete -
+    no locks and no frees on the audio thread.
+
+    In the arpeggiator modes, held keys are taken out of the normal note path
+    (handleInputEvent returns true for their note-ons and note-offs) and the
+    steps cycle through them instead.
+*/
+class StepSequencer : private juce::Timer
+{
+public:
+    enum Mode
+    {
+        off = 1, // Matches the ComboBox IDs in StepSequencerComponent
+        sequence,
+        arpUp,
+        arpDown,
+        arpUpDown
+    };
+
+    static constexpr int maxSteps = 32;
+    static constexpr int maxHeldNotes = 16;
+    static constexpr int maxEventsPerBlock = 64;
+
+    struct Pattern
+    {
+        struct Step
+        {
+            int   midiNote = -1; // -1 = rest (sequence mode)
+            float velocity = 0.8f;
+        };
+
+        int    mode = off;
+        double bpm = 120.0;
+        int    stepsPerBeat = 4;  // 4 = sixteenth notes
+        int    numSteps = 16;
+        float  gate = 0.5f;       // Note length as a fraction of a step
+        std::array<Step, maxSteps> steps{};
+    };
+
+    struct TimedEvent
+    {
+        NoteEvent event;
+        int sampleOffset = 0; // Within the block passed to processBlock
+    };
+
+    using EventList = std::array<TimedEvent, maxEventsPerBlock>;
+
+    // Transport and arpeggiator state, for RenderAhead's rollback. The pattern isn't part of
+    // it - rendering again after a rollback uses whatever pattern is current.
+    struct State
+    {
+        bool   running = false;
+        int    stepIndex = 0;
+        double nextStepTime = 0.0, noteOffTime = 0.0;
+        int    soundingNote = -1;
+        std::array<int, maxHeldNotes> heldNotes{};
+        int    numHeldNotes = 0, arpPosition = 0;
+    };
+
+    StepSequencer();
+    ~StepSequencer() override;
+
+    // --- Message thread ---
+    void setPattern(std::unique_ptr<Pattern> newPattern);
+    int  getCurrentStep() const noexcept { return currentStepForDisplay.load(std::memory_order_relaxed); } // -1 when stopped
+
+    // --- Audio thread ---
+    void prepare(double sampleRate); // Audio stopped
+    // Returns true if the event was consumed (arpeggiator modes take over held keys)
+    bool handleInputEvent(const NoteEvent& event) noexcept;
+    // Fills events (in time order) for the next numSamples; returns how many
+    int  processBlock(int numSamples, EventList& events) noexcept;
+    void saveState(State& state) const noexcept;
+    void restoreState(const State& state) noexcept;
+
+private:
+    void timerCallback() override; // Deletes retired patterns
+    void deleteRetiredPattern();
+
+    void swapInPendingPattern() noexcept;
+    int  pickNote(const Pattern& pattern, float& velocity) noexcept;
+    void stopSoundingNote(EventList& events, int& numEvents, int sampleOffset) noexcept;
+
+    // Pattern handoff: message thread -> pending -> active (audio thread) -> retired -> message thread
+    std::atomic<Pattern*> pendingPattern{ nullptr };
+    std::atomic<Pattern*> retiredPattern{ nullptr };
+    Pattern* activePattern = nullptr;
+    std::unique_ptr<Pattern> defaultPattern; // Active until the first setPattern (never retired)
+
+    // Transport (audio thread). Times are in samples relative to the start of the current block.
+    double sampleRate = 44100.0;
+    bool   running = false;
+    int    stepIndex = 0;
+    double nextStepTime = 0.0;
+    double noteOffTime = 0.0;
+    int    soundingNote = -1;
+
+    // Arpeggiator state (audio thread) - held keys in ascending order
+    std::array<int, maxHeldNotes> heldNotes{};
+    int numHeldNotes = 0;
+    int arpPosition = 0;
+
+    std::atomic<int> currentStepForDisplay{ -1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepSequencer)
+};
@@ -0,0 +1,167 @@
+#include "StepSequencerComponent.h"
+
+//==============================================================================
+StepSequencerComponent::StepSequencerComponent(const StepSequencer& sequencerToShow)
+    : sequencer(sequencerToShow),
+      stepDegrees{ 0, 2, 4, 2, 5, 4, 2, -1, 0, 4, 7, 4, 5, 4, 2, -1 } // Something to start from
+{
+    modeSelector.addItem("Seq Off", StepSequencer::off);
+    modeSelector.addItem("Sequence", StepSequencer::sequence);
+    modeSelector.addItem("Arp Up", StepSequencer::arpUp);
+    modeSelector.addItem("Arp Down", StepSequencer::arpDown);
+    modeSelector.addItem("Arp Up/Down", StepSequencer::arpUpDown);
+    modeSelector.setSelectedId(StepSequencer::off, juce::dontSendNotification);
+    modeSelector.addListener(this);
+    addAndMakeVisible(modeSelector);
+
+    tempoLabel.setText("BPM:", juce::dontSendNotification);
+    tempoLabel.attachToComponent(&tempoSlider, true);
+    tempoLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(tempoLabel);
+    tempoSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    tempoSlider.setRange(40.0, 240.0, 1.0);
+    tempoSlider.setValue(120.0, juce::dontSendNotification);
+    tempoSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 40, 20);
+    tempoSlider.addListener(this);
+    addAndMakeVisible(tempoSlider);
+
+    // ComboBox ID is steps per beat
+    rateSelector.addItem("1/8", 2);
+    rateSelector.addItem("1/16", 4);
+    rateSelector.addItem("1/32", 8);
+    rateSelector.setSelectedId(4, juce::dontSendNotification);
+    rateSelector.addListener(this);
+    addAndMakeVisible(rateSelector);
+
+    gateLabel.setText("Gate:", juce::dontSendNotification);
+    gateLabel.attachToComponent(&gateSlider, true);
+    gateLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(gateLabel);
+    gateSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    gateSlider.setRange(0.05, 1.0, 0.01);
+    gateSlider.setValue(0.5, juce::dontSendNotification);
+    gateSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 40, 20);
+    gateSlider.addListener(this);
+    addAndMakeVisible(gateSlider);
+
+    // Only takes effect while the sequencer or arpeggiator runs - that's when the future is known
+    renderAheadToggle.addListener(this);
+    addAndMakeVisible(renderAheadToggle);
+
+    startTimerHz(30);
+}
+
+StepSequencerComponent::~StepSequencerComponent()
+{
+    stopTimer();
+    modeSelector.removeListener(this);
+    rateSelector.removeListener(this);
+    tempoSlider.removeListener(this);
+    gateSlider.removeListener(this);
+    renderAheadToggle.removeListener(this);
+}
+
+//==============================================================================
+void StepSequencerComponent::paint(juce::Graphics& g)
+{
+    auto grid = getGridArea();
+    g.setColour(juce::Colours::black);
+    g.fillRect(grid);
+
+    auto cellWidth = (float)grid.getWidth() / numSteps;
+    auto cellHeight = (float)grid.getHeight() / numDegrees;
+    auto playingStep = sequencer.getCurrentStep();
+    bool arpeggiating = getMode() >= StepSequencer::arpUp;
+
+    for (int step = 0; step < numSteps; ++step)
+    {
+        auto x = (float)grid.getX() + step * cellWidth;
+
+        // Playhead column, and a darker band on every beat so the grid is readable
+        if (step == playingStep)
+            g.setColour(juce::Colours::darkgrey);
+        else
+            g.setColour(step % 4 == 0 ? juce::Colour(0xff202020) : juce::Colour(0xff141414));
+        g.fillRect(x + 1.0f, (float)grid.getY(), cellWidth - 2.0f, (float)grid.getHeight());
+
+        // Rows are ignored by the arpeggiator, so the notes are drawn dimmed
+        auto degree = stepDegrees[(size_t)step];
+        if (degree >= 0)
+        {
+            auto y = (float)grid.getBottom() - (degree + 1) * cellHeight;
+            g.setColour(juce::Colours::limegreen.withAlpha(arpeggiating ? 0.3f : 1.0f));
+            g.fillRect(x + 2.0f, y + 1.0f, cellWidth - 4.0f, cellHeight - 2.0f);
+        }
+    }
+
+    g.setColour(juce::Colours::grey);
+    g.drawRect(grid, 1);
+}
+
+void StepSequencerComponent::resized()
+{
+    auto topRow = getLocalBounds().removeFromTop(24);
+    modeSelector.setBounds(topRow.removeFromLeft(110));
+    topRow.removeFromLeft(45); // Label
+    tempoSlider.setBounds(topRow.removeFromLeft(180));
+    topRow.removeFromLeft(8);
+    rateSelector.setBounds(topRow.removeFromLeft(70));
+    topRow.removeFromLeft(45); // Label
+    gateSlider.setBounds(topRow.removeFromLeft(160));
+    topRow.removeFromLeft(8);
+    renderAheadToggle.setBounds(topRow.removeFromLeft(120));
+}
+
+juce::Rectangle<int> StepSequencerComponent::getGridArea() const
+{
+    return getLocalBounds().withTrimmedTop(28);
+}
+
+void StepSequencerComponent::mouseDown(const juce::MouseEvent& event)
+{
+    auto grid = getGridArea();
+    if (! grid.contains(event.getPosition()))
+        return;
+
+    auto step = juce::jlimit(0, numSteps - 1, (event.x - grid.getX()) * numSteps / grid.getWidth());
+    auto degree = juce::jlimit(0, numDegrees - 1, (grid.getBottom() - 1 - event.y) * numDegrees / grid.getHeight());
+
+    auto& stepDegree = stepDegrees[(size_t)step];
+    stepDegree = stepDegree == degree ? -1 : degree;
+    repaint();
+    patternChanged();
+}
+
+//==============================================================================
+void StepSequencerComponent::timerCallback()
+{
+    // Follow the playhead
+    auto playingStep = sequencer.getCurrentStep();
+    if (playingStep != lastDrawnStep)
+    {
+        lastDrawnStep = playingStep;
+        repaint(getGridArea());
+    }
+}
+
+void StepSequencerComponent::comboBoxChanged(juce::ComboBox* /*comboBoxThatHasChanged*/)
+{
+    repaint(getGridArea()); // Notes dim in the arpeggiator modes
+    patternChanged();
+}
+
+void StepSequencerComponent::sliderValueChanged(juce::Slider* /*sliderThatHasChanged*/)
+{
+    patternChanged();
+}
+
+void StepSequencerComponent::buttonClicked(juce::Button* /*buttonThatWasClicked*/)
+{
+    patternChanged();
+}
+
+void StepSequencerComponent::patternChanged()
+{
+    if (onPatternChanged != nullptr)
+        onPatternChanged();
+}
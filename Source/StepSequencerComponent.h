@@ -0,0 +1,66 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <functional>
+#include "StepSequencer.h"
+
+//==============================================================================
+/*
+    Pattern editor for the StepSequencer: mode, tempo, step rate and gate along
+    the top (plus the render-ahead switch), and a 16-step grid below with one row per scale degree (bottom row
+    = root, top row = the octave). Clicking a cell puts that degree on the step,
+    clicking it again makes the step a rest. The column being played is
+    highlighted.
+
+    The component only holds the editor state; whenever it changes,
+    onPatternChanged is called and the owner builds a StepSequencer::Pattern
+    from it (it knows the current root and scale).
+*/
+class StepSequencerComponent : public juce::Component,
+    private juce::Timer,
+    private juce::ComboBox::Listener,
+    private juce::Slider::Listener,
+    private juce::Button::Listener
+{
+public:
+    static constexpr int numSteps = 16;
+    static constexpr int numDegrees = 8; // One octave of a seven-note scale, plus the octave
+
+    explicit StepSequencerComponent(const StepSequencer& sequencerToShow);
+    ~StepSequencerComponent() override;
+
+    std::function<void()> onPatternChanged;
+
+    int   getMode() const { return modeSelector.getSelectedId(); }      // StepSequencer::Mode
+    double getBpm() const { return tempoSlider.getValue(); }
+    int   getStepsPerBeat() const { return rateSelector.getSelectedId(); }
+    float getGate() const { return (float)gateSlider.getValue(); }
+    int   getStepDegree(int step) const { return stepDegrees[(size_t)step]; } // -1 = rest
+    bool  isRenderAheadOn() const { return renderAheadToggle.getToggleState(); } // See RenderAhead
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+    void timerCallback() override;
+    void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
+    void sliderValueChanged(juce::Slider* sliderThatHasChanged) override;
+    void buttonClicked(juce::Button* buttonThatWasClicked) override;
+    void patternChanged();
+    juce::Rectangle<int> getGridArea() const;
+
+    const StepSequencer& sequencer;
+    std::array<int, numSteps> stepDegrees;
+    int lastDrawnStep = -1;
+
+    juce::ComboBox modeSelector;
+    juce::Slider   tempoSlider;
+    juce::ComboBox rateSelector;
+    juce::Slider   gateSlider;
+    juce::Label    tempoLabel, gateLabel;
+    juce::ToggleButton renderAheadToggle{ "Render ahead" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepSequencerComponent)
+};
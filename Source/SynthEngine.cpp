@@ -1,69 +1,81 @@
 #include "SynthEngine.h"
 #include "MainComponent.h" // For Waveform enum access
-#include <cmath>   
+#include "TraceRecorder.h"
+#include "OscillatorKernels.h"
+#include <cmath>
 #include <JuceHeader.h> // For std::sin, std::fmod, std::abs, std::pow
 
 //==============================================================================
 SynthEngine::SynthEngine()
 {
-    // Set default ADSR parameters when the engine is created
-    adsrParams.attack = 0.05f;
-    adsrParams.decay = 0.1f;
-    adsrParams.sustain = 0.8f;
-    adsrParams.release = 0.5f;
+    // Default ADSR parameters live in the atomics; they get applied to every voice in prepareToPlay
     // Initial filter params will be set in prepareToPlay
+    for (int i = 0; i < maxVoices; ++i)
+        voices[(size_t)i].index = i;
 }
-double SynthEngine::getCurrentFrequency() const
-{
-    // Returns the frequency currently being used by the oscillator
-    return frequency; // 'frequency' is a member variable of SynthEngine
-}
-// --- UPDATE prepareToPlay ---
-// Now accepts block size and num channels for ProcessSpec
-// --- REPLACE prepareToPlay function ---
-// --- REPLACE prepareToPlay function ---
-void SynthEngine::prepareToPlay(double sampleRate, int maximumBlockSize, int /*numChannels*/) // numChannels passed in is now ignored
+
+void SynthEngine::prepareToPlay(double sampleRate, int maximumBlockSize, int /*numChannels*/) // numChannels passed in is ignored, voices are mono
 {
     currentSampleRate = sampleRate;
-    currentAngle = 0.0;
-    angleDelta = 0.0;
-    frequency = 440.0;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    voiceBuffer.setSize(1, maxBlockSize);
+    fmSynth.prepare(sampleRate, maxBlockSize);
+    additiveSynth.prepare(sampleRate);
+    granularSynth.prepare(sampleRate, maxBlockSize);
+    lastStartedFrequency = 0.0;
+    currentFrequency.store(0.0);
 
-    // --- Prepare Filter ---
+    // --- Prepare Filters ---
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = (juce::uint32)juce::jmax(1, maximumBlockSize);
+    spec.maximumBlockSize = (juce::uint32)maxBlockSize;
     spec.numChannels = 1; // <<< FORCE to 1 Channel for mono processing >>>
 
-    filter.prepare(spec); // Prepare the filter with the MONO spec
-    filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    for (auto& voice : voices)
+    {
+        voice.filter.prepare(spec); // Prepare the filter with the MONO spec
+        voice.filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+        voice.filter.reset();
+
+        voice.adsr.setSampleRate(sampleRate);
+        voice.adsr.reset();
+
+        voice.midiNote = -1;
+        voice.isKeyDown = false;
+        voice.oscillatorPhase = 0;
+        voice.pendingInputTicks = 0;
+        voice.expressionSlot = -1;
+        voice.appliedCutoff = -1.0f;
+        releaseStream(voice);
+    }
 
-    // Set initial values (read from atomics passed via MainComponent::updateFilter maybe?)
-    // For now, re-apply reasonable defaults after prepare
-    float initialCutoff = 10000.0f; // Start wide open
-    float initialResonance = 1.0f / std::sqrt(2.0f);
-    filter.setCutoffFrequency(initialCutoff);
-    filter.setResonance(initialResonance);
+    // Every voice is silent now, so no slot is in use; held MPE notes keep theirs on the MIDI side
+    if (expressionSource != nullptr)
+        for (int slot = 0; slot < MpeInput::numExpressionSlots; ++slot)
+            expressionSource->markSlotIdle(slot);
+    releasedExpressionSlots = 0;
 
-    // Log initial state
-    DBG("SynthEngine::prepareToPlay - Spec: Rate=" + juce::String(spec.sampleRate)
-        + ", BlockSize=" + juce::String(spec.maximumBlockSize)
-        + ", Channels=" + juce::String(spec.numChannels)); // Will now log 1 channel
-    DBG("SynthEngine::prepareToPlay - Initial Filter Cutoff set to: " + juce::String(filter.getCutoffFrequency()));
-    DBG("SynthEngine::prepareToPlay - Initial Filter Resonance set to: " + juce::String(filter.getResonance()));
+    // Force the current ADSR/filter settings and quality tier onto the freshly prepared voices
+    appliedAdsrVersion = -1;
+    appliedFilterVersion = -1;
+    appliedQualityTier = -1;
+    applyPendingParameters();
+    applyQualityTier();
+    numFirstSoundEvents = nextFirstSoundEvent = 0;
 
-    // --- Prepare ADSR ---
-    adsr.setSampleRate(sampleRate);
-    adsr.setParameters(adsrParams);
-    adsr.reset();
-    filter.reset(); // <<< ADD THIS LINE to clear internal filter state
+    DBG("SynthEngine::prepareToPlay - Rate=" + juce::String(sampleRate)
+        + ", BlockSize=" + juce::String(maxBlockSize)
+        + ", Voices=" + juce::String(maxVoices));
 }
 
+//==============================================================================
 void SynthEngine::setParameters(const juce::ADSR::Parameters& params)
 {
-    // Update local copy and apply to ADSR object
-    adsrParams = params;
-    adsr.setParameters(adsrParams);
+    adsrAttack.store(params.attack);
+    adsrDecay.store(params.decay);
+    adsrSustain.store(params.sustain);
+    adsrRelease.store(params.release);
+    ++adsrVersion; // Picked up by the audio thread at the start of the next block
 }
 
 void SynthEngine::setWaveform(int waveformTypeId)
@@ -71,131 +83,776 @@ void SynthEngine::setWaveform(int waveformTypeId)
     currentWaveformType.store(waveformTypeId);
 }
 
-void SynthEngine::setFrequency(double frequencyHz)
+void SynthEngine::setWavetablePosition(float position)
+{
+    wavetablePosition.store(juce::jlimit(0.0f, 1.0f, position));
+}
+
+void SynthEngine::setPitchOffset(float semitones)
+{
+    pitchOffsetSemitones.store(semitones);
+}
+
+void SynthEngine::setFilterParameters(float cutoffHz, float resonance)
+{
+    filterCutoff.store(cutoffHz);
+    filterResonance.store(resonance);
+    ++filterVersion;
+}
+
+void SynthEngine::setVoiceType(int voiceTypeId)
+{
+    currentVoiceType.store(voiceTypeId);
+}
+
+void SynthEngine::setFmPatch(int patchIndex)
+{
+    currentFmPatch.store(juce::jlimit(0, FmSynth::numAlgorithms - 1, patchIndex));
+}
+
+void SynthEngine::setAdditivePreset(int presetIndex)
+{
+    currentAdditivePreset.store(juce::jlimit(0, AdditiveSynth::numPresets - 1, presetIndex));
+}
+
+void SynthEngine::setGranularPreset(int presetIndex)
+{
+    currentGranularPreset.store(juce::jlimit(0, GranularSynth::numPresets - 1, presetIndex));
+}
+
+void SynthEngine::setQualityTier(int tier)
 {
-    frequency = frequencyHz; // Store the frequency
-    if (currentSampleRate > 0.0) {
-        double cyclesPerSample = frequency / currentSampleRate;
-        angleDelta = cyclesPerSample * 2.0 * juce::MathConstants<double>::pi;
+    qualityTier.store(juce::jlimit(0, QualityGovernor::numTiers - 1, tier));
+}
+
+void SynthEngine::applyPendingParameters()
+{
+    auto adsrVersionNow = adsrVersion.load();
+    if (adsrVersionNow != appliedAdsrVersion)
+    {
+        appliedAdsrVersion = adsrVersionNow;
+
+        juce::ADSR::Parameters params;
+        params.attack = adsrAttack.load();
+        params.decay = adsrDecay.load();
+        params.sustain = adsrSustain.load();
+        params.release = adsrRelease.load();
+
+        for (auto& voice : voices)
+            voice.adsr.setParameters(params);
     }
-    else {
-        angleDelta = 0.0;
+
+    auto filterVersionNow = filterVersion.load();
+    if (filterVersionNow != appliedFilterVersion && currentSampleRate > 0.0)
+    {
+        appliedFilterVersion = filterVersionNow;
+
+        // Clamp values to ensure they are safe for the filter
+        // Cutoff: Limit between ~20Hz and slightly below Nyquist frequency
+        float clampedCutoff = juce::jlimit(20.0f, (float)(currentSampleRate / 2.0 * 0.98), filterCutoff.load());
+        // Resonance: Limit between sqrt(0.5) and 18 (the slider range)
+        float clampedRes = juce::jlimit(0.707f, 18.0f, filterResonance.load());
+
+        // The cutoff itself is applied per voice, on top of its expression (see updateExpressionLanes)
+        baseCutoffHz = clampedCutoff;
+        for (auto& voice : voices)
+        {
+            voice.filter.setResonance(clampedRes);
+            voice.appliedCutoff = -1.0f;
+        }
     }
 }
 
-// --- ADD setFilterParameters ---
-// --- REPLACE setFilterParameters function ---
-void SynthEngine::setFilterParameters(float cutoffHz, float resonance)
+void SynthEngine::applyQualityTier()
+{
+    auto tier = qualityTier.load();
+    if (tier == appliedQualityTier || currentSampleRate <= 0.0)
+        return;
+
+    const auto& previous = *tierSettings;
+    const auto& settings = QualityGovernor::getTierSettings(tier);
+    bool firstApply = appliedQualityTier < 0;
+    appliedQualityTier = tier;
+    tierSettings = &settings;
+
+    for (auto& voice : voices)
+    {
+        // The other filter kernel's state is stale - start it from silence
+        if (firstApply || settings.onePoleFilter != previous.onePoleFilter)
+        {
+            voice.filter.reset();
+            voice.onePoleState = 0.0f;
+        }
+
+        // At control rate the ADSR is stepped once per interval, so it runs at a divided sample rate
+        if (firstApply || settings.envelopeInterval != previous.envelopeInterval)
+        {
+            voice.adsr.setSampleRate(currentSampleRate / settings.envelopeInterval);
+            voice.envelopeCountdown = 0;
+        }
+    }
+
+    enforcePolyphonyLimit();
+}
+
+void SynthEngine::enforcePolyphonyLimit()
+{
+    // Stop the oldest voices beyond the tier's cap outright - a click is better than a dropout
+    for (int active = getNumActiveVoices(); active > tierSettings->maxPolyphony; --active)
+    {
+        Voice* oldest = nullptr;
+        for (auto& voice : voices)
+            if (voice.isActive() && (oldest == nullptr || voice.startOrder < oldest->startOrder))
+                oldest = &voice;
+
+        oldest->isKeyDown = false;
+        oldest->adsr.reset();
+        releaseStream(*oldest);
+    }
+}
+
+//==============================================================================
+void SynthEngine::handleNoteEvent(const NoteEvent& event)
+{
+    switch (event.type)
+    {
+    case NoteEvent::noteOn:      noteOn(event.midiNote, event.velocity, event.timestampTicks, event.inputPath, event.expressionSlot); break;
+    case NoteEvent::noteOff:     noteOff(event.midiNote, event.expressionSlot); break;
+    case NoteEvent::allNotesOff: allNotesOff(); break;
+    default: break;
+    }
+}
+
+SynthEngine::Voice& SynthEngine::findVoiceForNote(int midiNote, int expressionSlot)
 {
-    // Clamp values to ensure they are safe for the filter
-    // Cutoff: Limit between ~20Hz and slightly below Nyquist frequency
-    float clampedCutoff = juce::jlimit(20.0f, (float)(currentSampleRate / 2.0 * 0.98), cutoffHz);
-    // Resonance: Limit between reasonable minimum (e.g., 0.1 or sqrt(0.5)) and a max (e.g., 18)
-    float clampedRes = juce::jlimit(0.707f, 18.0f, resonance); // Using slider range min/max basically
+    // 1. Same note still sounding (e.g. in its release) - retrigger that voice.
+    //    MPE notes only match their own slot: the same pitch on two channels is two voices.
+    for (auto& voice : voices)
+        if (voice.midiNote == midiNote && voice.expressionSlot == expressionSlot && voice.isActive())
+            return voice;
 
-    DBG("SynthEngine::setFilterParameters called. Input C=" + juce::String(cutoffHz) + ", R=" + juce::String(resonance)
-        + " | Clamped C=" + juce::String(clampedCutoff) + ", R=" + juce::String(clampedRes));
+    // 2. A silent voice, unless the quality tier's polyphony cap is already reached
+    if (getNumActiveVoices() < tierSettings->maxPolyphony)
+        for (auto& voice : voices)
+            if (! voice.isActive())
+                return voice;
 
-    filter.setCutoffFrequency(clampedCutoff);
-    filter.setResonance(clampedRes);
+    // 3. Steal the oldest sounding voice - preferring ones whose key is already up
+    Voice* oldest = nullptr;
+    for (auto& voice : voices)
+    {
+        if (! voice.isActive())
+            continue; // Only reachable while capped - silent voices must stay unused
+        if (oldest == nullptr
+            || (oldest->isKeyDown && ! voice.isKeyDown)
+            || (oldest->isKeyDown == voice.isKeyDown && voice.startOrder < oldest->startOrder))
+            oldest = &voice;
+    }
+    return *oldest;
 }
 
+void SynthEngine::noteOn(int midiNote, float velocity, juce::int64 inputTicks, int inputPath, int expressionSlot)
+{
+    // Sampler notes need a zone; with no library loaded (or a gap in it) the note is ignored.
+    // Granular notes use one if there is one (their live presets don't need it).
+    auto voiceType = currentVoiceType.load();
+    const SampleLibrary::Zone* zone = nullptr;
+    if (voiceType == samplerVoice || voiceType == granularVoice)
+    {
+        auto* library = sampleStreamer != nullptr ? sampleStreamer->getLibrary() : nullptr;
+        zone = library != nullptr ? library->findZone(midiNote, juce::roundToInt(velocity * 127.0f)) : nullptr;
+        if (zone == nullptr && voiceType == samplerVoice)
+            return;
+    }
+
+    auto& voice = findVoiceForNote(midiNote, expressionSlot);
+    const bool freshVoice = ! voice.isActive();
+
+    if (freshVoice)
+    {
+        // Fresh voice: start the waveform from zero and drop filter history from its last note
+        voice.oscillatorPhase = 0;
+        voice.wavetableFrame = -1.0f;
+        voice.filter.reset();
+        voice.onePoleState = 0.0f;
+        voice.envelopeLevel = 0.0f;
+        voice.envelopeCountdown = 0;
+        voice.fm = {};
+    }
 
-void SynthEngine::noteOn()
+    // A voice switching over to additive has no partial phases or overlap of its own yet
+    if (voiceType == fmVoice)
+        fmSynth.noteOn(voice.fm);
+    else if (voiceType == additiveVoice)
+        additiveSynth.noteOn(additiveStates[(size_t)voice.index], freshVoice || voice.voiceType != additiveVoice);
+    else if (voiceType == granularVoice)
+        granularSynth.noteOn(granularStates[(size_t)voice.index], freshVoice || voice.voiceType != granularVoice);
+    voice.voiceType = voiceType;
+
+    if (voiceType == granularVoice)
+    {
+        // Grains only read the zone's resident head, so no stream. The zone pointer still
+        // matters: a library swap stops the voice like any other that points into the old one.
+        releaseStream(voice);
+        voice.zone = zone;
+    }
+    else if (zone != nullptr)
+    {
+        // (Re)start the sample from the top: the head plays from RAM while the rest streams in
+        voice.zone = zone;
+        voice.samplePosition = 0.0;
+        voice.sampleIncrement = std::pow(2.0, (midiNote - zone->rootNote) / 12.0) * zone->sampleRate / currentSampleRate;
+        voice.sourceFinished = false;
+        voice.streamGeneration = sampleStreamer->requestStream(voice.index, zone);
+    }
+    else
+    {
+        releaseStream(voice);
+    }
+
+    // Expression starts at the note's initial values, no glide from whatever the voice played before
+    voice.expressionSlot = expressionSource != nullptr ? expressionSlot : -1;
+    updateExpressionLanes(voice, 0, true);
+
+    voice.midiNote = midiNote;
+    voice.velocity = velocity;
+    voice.isKeyDown = true;
+    voice.startOrder = nextStartOrder++;
+    voice.pendingInputTicks = inputTicks;
+    voice.pendingInputPath = inputPath;
+    voice.adsr.noteOn();
+}
+
+void SynthEngine::noteOff(int midiNote, int expressionSlot)
 {
-    adsr.noteOn();
+    if (expressionSlot >= 0)
+        releasedExpressionSlots |= 1u << expressionSlot; // Handed back once its release tail has finished
+    for (auto& voice : voices)
+    {
+        if (voice.midiNote == midiNote && voice.isKeyDown && (expressionSlot < 0 || voice.expressionSlot == expressionSlot))
+        {
+            voice.isKeyDown = false;
+            voice.adsr.noteOff(); // <<< Trigger ADSR Release >>>
+            fmSynth.noteOff(voice.fm);
+        }
+    }
 }
 
-void SynthEngine::noteOff()
+void SynthEngine::allNotesOff()
 {
-    adsr.noteOff();
+    for (auto& voice : voices)
+    {
+        if (voice.isKeyDown)
+        {
+            voice.isKeyDown = false;
+            voice.adsr.noteOff();
+            fmSynth.noteOff(voice.fm);
+        }
+    }
 }
 
 bool SynthEngine::isActive() const
 {
-    return adsr.isActive();
+    for (const auto& voice : voices)
+        if (voice.isActive())
+            return true;
+    return false;
 }
 
+int SynthEngine::getNumActiveVoices() const
+{
+    int count = 0;
+    for (const auto& voice : voices)
+        if (voice.isActive())
+            ++count;
+    return count;
+}
 
-// --- UPDATE renderNextBlock ---
-// --- REPLACE renderNextBlock function ---
-// --- REPLACE renderNextBlock function (Back to Sample-by-Sample) ---
+void SynthEngine::releaseStream(Voice& voice)
+{
+    if (voice.zone != nullptr && sampleStreamer != nullptr)
+        sampleStreamer->requestStream(voice.index, nullptr);
+    voice.zone = nullptr;
+}
+
+//==============================================================================
 void SynthEngine::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
-{   
- 
-    // If ADSR is completely finished, ensure output is silent and exit
-    if (!adsr.isActive())
+{
+    const TraceRecorder::ScopedEvent trace("SynthEngine::renderNextBlock");
+    numFirstSoundEvents = nextFirstSoundEvent = 0;
+    outputBuffer.clear(startSample, numSamples);
+
+    // Pick up any parameter changes made since the last block
     {
-        outputBuffer.clear(startSample, numSamples);
-        return; // Exit early
+        const TraceRecorder::ScopedEvent parametersTrace("SynthEngine parameters");
+        applyPendingParameters();
+        applyQualityTier();
     }
 
-    // --- If ADSR is active ---
+    // A newly loaded sample library invalidates every zone the sampler voices point at
+    if (sampleStreamer != nullptr && sampleStreamer->beginBlock())
+    {
+        ++libraryGeneration;
+        for (auto& voice : voices)
+        {
+            if (voice.zone != nullptr)
+            {
+                voice.zone = nullptr; // Its stream was already released by the swap
+                voice.adsr.reset();
+            }
+        }
+    }
 
-    // Calculate the angle delta based on the current stored frequency
-    double currentBlockAngleDelta = 0.0;
-    if (currentSampleRate > 0.0 && frequency > 0.0) // Use the 'frequency' member variable
+    if (! isActive() || currentSampleRate <= 0.0)
     {
-        currentBlockAngleDelta = (frequency / currentSampleRate) * 2.0 * juce::MathConstants<double>::pi;
+        granularSynth.captureLive(outputBuffer.getReadPointer(0, startSample), numSamples); // Silence keeps the live ring in time
+        releaseIdleExpressionSlots();
+        publishBlockStatistics();
+        return; // All voices silent - output is already cleared
     }
 
-    // Get waveform type
+    // Block-constant values
     auto waveTypeInt = currentWaveformType.load(); // Read atomic waveform type as int
+    auto pitchRatio = std::pow(2.0, pitchOffsetSemitones.load() / 12.0); // Transpose + fine tune
+    fmPatch = &FmSynth::getPatch(currentFmPatch.load());
+    additivePresetIndex = currentAdditivePreset.load(); // Already clamped by setAdditivePreset
+    granularPreset = &GranularSynth::getPreset(currentGranularPreset.load());
     auto* leftBuffer = outputBuffer.getWritePointer(0, startSample);
-    auto* rightBuffer = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
 
-    // Process sample by sample
-    for (int i = 0; i < numSamples; ++i)
+    // Render in chunks no larger than the scratch buffer prepared in prepareToPlay
+    for (int chunkStart = 0; chunkStart < numSamples; chunkStart += maxBlockSize)
     {
-        // 1. Get the ADSR gain value for this sample (advances ADSR state)
-        float envelopeGain = adsr.getNextSample();
+        auto chunkSize = juce::jmin(maxBlockSize, numSamples - chunkStart);
+        auto* scratch = voiceBuffer.getWritePointer(0);
 
-        // 2. Calculate raw oscillator value
-        double currentSampleValue = 0.0;
-        // Only calculate if gain > 0 and delta is valid (slight optimization, but run filter anyway)
-        // Let's calculate oscillator regardless of gain first, simpler.
-        if (currentBlockAngleDelta != 0.0)
+        // Granular voices go last: the live ring takes the mix of the others, so they never granulate themselves
+        for (int pass = 0; pass < 2; ++pass)
         {
-            double phase = std::fmod(currentAngle, 2.0 * juce::MathConstants<double>::pi) / (2.0 * juce::MathConstants<double>::pi);
-            // Use integer cases for the switch
-            switch (waveTypeInt)
+            const TraceRecorder::ScopedEvent passTrace(pass == 0 ? "SynthEngine voices" : "SynthEngine granular voices");
+            for (auto& voice : voices)
             {
-            case 1: currentSampleValue = std::sin(currentAngle); break;
-            case 2: currentSampleValue = (phase < 0.5) ? 1.0 : -1.0; break;
-            case 3: currentSampleValue = (2.0 * phase) - 1.0; break;
-            case 4: currentSampleValue = 2.0 * (1.0 - 2.0 * std::abs(phase - 0.5)) - 1.0; break;
-            default: currentSampleValue = std::sin(currentAngle); break;
+                if (! voice.isActive() || (voice.voiceType == granularVoice) != (pass == 1))
+                    continue;
+
+                renderVoice(voice, scratch, chunkSize, waveTypeInt, pitchRatio);
+
+                // Latency tracking: find the first audible sample of a freshly triggered note
+                if (voice.pendingInputTicks != 0)
+                {
+                    for (int i = 0; i < chunkSize; ++i)
+                    {
+                        if (scratch[i] != 0.0f)
+                        {
+                            if (numFirstSoundEvents < (int)firstSoundEvents.size())
+                                firstSoundEvents[(size_t)numFirstSoundEvents++] = { voice.pendingInputTicks, voice.pendingInputPath, chunkStart + i };
+                            voice.pendingInputTicks = 0;
+                            break;
+                        }
+                    }
+                }
+
+                juce::FloatVectorOperations::add(leftBuffer + chunkStart, scratch, chunkSize);
             }
-            // Increment oscillator phase angle using the calculated delta
-            currentAngle += currentBlockAngleDelta;
+
+            if (pass == 0)
+                granularSynth.captureLive(leftBuffer + chunkStart, chunkSize);
+        }
+    }
+
+    // Write same mono signal to the other channels
+    for (int channel = 1; channel < outputBuffer.getNumChannels(); ++channel)
+        outputBuffer.copyFrom(channel, startSample, outputBuffer, 0, startSample, numSamples);
+
+    releaseIdleExpressionSlots();
+    publishBlockStatistics();
+
+    // Note: Oscilloscope copy and Master Level are handled in MainComponent::getNextAudioBlock
+}
+
+void SynthEngine::renderVoice(Voice& voice, float* output, int numSamples, int waveTypeInt, double pitchRatio)
+{
+    // Per-note bend and cutoff (control rate: once per block, however many messages arrived)
+    updateExpressionLanes(voice, numSamples, false);
+
+    // Calculate this voice's note frequency, including the global pitch offset and its own bend
+    if (voice.pitchBendSemitones != 0.0f)
+        pitchRatio *= std::pow(2.0, voice.pitchBendSemitones / 12.0);
+    voice.frequency = juce::MidiMessage::getMidiNoteInHertz(voice.midiNote) * pitchRatio;
+    if (voice.startOrder + 1 == nextStartOrder)
+        lastStartedFrequency = voice.frequency;
+
+    // 1. Raw source signal
+    if (voice.voiceType == samplerVoice && voice.zone != nullptr)
+        renderSampler(voice, output, numSamples, pitchRatio);
+    else if (voice.voiceType == fmVoice)
+        fmSynth.render(voice.fm, *fmPatch, voice.frequency, output, numSamples); // Operator envelopes shape the timbre; the ADSR below stays the amp envelope
+    else if (voice.voiceType == granularVoice)
+        granularSynth.render(granularStates[(size_t)voice.index], *granularPreset, voice.zone, voice.frequency, output, numSamples);
+    else if (voice.voiceType == additiveVoice)
+        additiveSynth.render(additiveStates[(size_t)voice.index], additivePresetIndex, voice.frequency, output, numSamples);
+    else
+        renderOscillator(voice, output, numSamples, waveTypeInt);
+
+    // 2. Filter, envelope and velocity - the same for every source
+    const auto envelopeInterval = tierSettings->envelopeInterval;
+    const auto onePoleFilter = tierSettings->onePoleFilter;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Get the ADSR gain value for this sample (advances ADSR state).
+        // At control rate: one ADSR step per interval, linearly ramped in between.
+        float envelopeGain;
+        if (envelopeInterval <= 1)
+        {
+            envelopeGain = voice.envelopeLevel = voice.adsr.getNextSample(); // Kept so a switch to control rate ramps from here
         }
-        // If delta was 0, currentSampleValue remains 0.0
-
-        // 3. Apply Filter (process sample - treating input as mono for now)
-        float filteredSample = filter.processSample(0, (float)currentSampleValue);
-
-        // Log Filter I/O (for first sample only)
-        if (i == 0) {
-            DBG("Filter I/O [Sample 0]: In=" + juce::String(currentSampleValue, 4)
-                + ", Out=" + juce::String(filteredSample, 4)
-                + ", Cutoff=" + juce::String(filter.getCutoffFrequency())
-                + ", Res=" + juce::String(filter.getResonance())
-                + ", Type=" + juce::String((int)filter.getType()));
+        else
+        {
+            if (voice.envelopeCountdown <= 0)
+            {
+                voice.envelopeStep = (voice.adsr.getNextSample() - voice.envelopeLevel) / (float)envelopeInterval;
+                voice.envelopeCountdown = envelopeInterval;
+            }
+            voice.envelopeLevel += voice.envelopeStep;
+            --voice.envelopeCountdown;
+            envelopeGain = voice.envelopeLevel;
         }
 
-        // 4. Calculate final sample value: FilteredOsc * Envelope Gain
+        // Apply Filter (process sample - voices are mono)
+        float filteredSample;
+        if (onePoleFilter)
+            filteredSample = voice.onePoleState += voice.onePoleCoefficient * (output[i] - voice.onePoleState);
+        else
+            filteredSample = voice.filter.processSample(0, output[i]);
+
+        // Final sample value: FilteredSource * Envelope Gain * Velocity
         // Master Level is applied later in MainComponent::getNextAudioBlock
-        float outputSample = filteredSample * envelopeGain;
+        output[i] = filteredSample * envelopeGain * voice.velocity;
+    }
 
-        // 5. Write to output buffers
-        leftBuffer[i] = outputSample;
-        if (rightBuffer != nullptr)
-            rightBuffer[i] = outputSample; // Write same mono signal to right channel
+    // A sample that has played to its end stops the voice, whatever the envelope is doing
+    if (voice.sourceFinished)
+    {
+        voice.sourceFinished = false;
+        voice.adsr.reset();
+        releaseStream(voice);
     }
+}
 
-    // Optional: Wrap main phase angle
-    if (currentAngle >= 2.0 * juce::MathConstants<double>::pi)
-        currentAngle -= 2.0 * juce::MathConstants<double>::pi;
+void SynthEngine::updateExpressionLanes(Voice& voice, int numSamples, bool jumpToTarget)
+{
+    // Targets: the latest values the MIDI thread wrote into the voice's slot
+    float targetBend = 0.0f, targetOctaves = 0.0f;
+    if (voice.expressionSlot >= 0)
+    {
+        const auto& expression = expressionSource->getExpression(voice.expressionSlot);
+        targetBend = expression.pitchBendSemitones.load(std::memory_order_relaxed);
+        // Pressure opens the filter by up to 2 octaves, timbre moves it +-3 octaves around neutral
+        targetOctaves = 2.0f * expression.pressure.load(std::memory_order_relaxed)
+                      + 6.0f * (expression.timbre.load(std::memory_order_relaxed) - 0.5f);
+    }
 
-    // Note: Oscilloscope copy and Master Level are handled in MainComponent::getNextAudioBlock
-}
\ No newline at end of file
+    // One-pole smoothing per block (~10 ms), so stepped controller values don't zipper
+    if (jumpToTarget)
+    {
+        voice.pitchBendSemitones = targetBend;
+        voice.cutoffOctaves = targetOctaves;
+    }
+    else
+    {
+        auto smoothing = (float)(1.0 - std::exp(-numSamples / (0.01 * currentSampleRate)));
+        voice.pitchBendSemitones += smoothing * (targetBend - voice.pitchBendSemitones);
+        voice.cutoffOctaves += smoothing * (targetOctaves - voice.cutoffOctaves);
+    }
+
+    // Filter coefficients only when the effective cutoff has actually moved (about 1/100 semitone)
+    auto cutoff = baseCutoffHz;
+    if (voice.cutoffOctaves != 0.0f)
+        cutoff = juce::jlimit(20.0f, (float)(currentSampleRate / 2.0 * 0.98), cutoff * std::exp2(voice.cutoffOctaves));
+
+    if (voice.appliedCutoff < 0.0f || std::abs(cutoff - voice.appliedCutoff) > voice.appliedCutoff * 0.0006f)
+    {
+        voice.appliedCutoff = cutoff;
+        voice.filter.setCutoffFrequency(cutoff);
+        // The cheap tiers' one-pole lowpass follows the same cutoff (resonance is lost)
+        voice.onePoleCoefficient = (float)(1.0 - std::exp(-2.0 * juce::MathConstants<double>::pi * cutoff / currentSampleRate));
+    }
+}
+
+void SynthEngine::releaseIdleExpressionSlots()
+{
+    if (releasedExpressionSlots == 0)
+        return;
+
+    // A slot goes back to MpeInput once no voice plays it: its tail has ended, or the voice was stolen
+    auto stillSounding = 0u;
+    for (const auto& voice : voices)
+        if (voice.expressionSlot >= 0 && voice.isActive())
+            stillSounding |= 1u << voice.expressionSlot;
+
+    const auto idle = releasedExpressionSlots & ~stillSounding;
+    for (int slot = 0; slot < MpeInput::numExpressionSlots; ++slot)
+        if ((idle & (1u << slot)) != 0)
+            expressionSource->markSlotIdle(slot);
+
+    releasedExpressionSlots &= stillSounding;
+}
+
+void SynthEngine::renderOscillator(Voice& voice, float* output, int numSamples, int waveTypeInt)
+{
+    // User wavetables take the IDs after the fixed shapes; one that isn't loaded yet plays as a sine
+    if (wavetableBank != nullptr)
+    {
+        if (auto* table = wavetableBank->getTableForWaveformId(waveTypeInt))
+        {
+            renderWavetable(voice, output, numSamples, *table);
+            return;
+        }
+    }
+
+    // Kernel chosen once per block: shape from the waveform ID, precision from the quality tier
+    auto shape = waveTypeInt == MainComponent::square ? OscillatorKernels::square
+               : waveTypeInt == MainComponent::saw ? OscillatorKernels::saw
+               : waveTypeInt == MainComponent::triangle ? OscillatorKernels::triangle
+               : OscillatorKernels::sine;
+    auto precision = tierSettings->fastOscillators ? OscillatorKernels::floatPrecision : OscillatorKernels::doublePrecision;
+
+    OscillatorKernels::getKernel(shape, precision)(output, numSamples, voice.oscillatorPhase,
+                                                   OscillatorKernels::getIncrement(voice.frequency, currentSampleRate));
+}
+
+void SynthEngine::renderWavetable(Voice& voice, float* output, int numSamples, const Wavetable& table)
+{
+    // Band limit once per block, for the note's current pitch
+    auto mipLevel = table.getMipLevelForFrequency(voice.frequency, currentSampleRate);
+
+    // Frame morph runs at control rate: a linear ramp across the block to the latest position
+    auto lastFrame = table.getNumFrames() - 1;
+    auto targetFrame = wavetablePosition.load() * (float)lastFrame;
+    auto frame = voice.wavetableFrame >= 0.0f ? juce::jmin(voice.wavetableFrame, (float)lastFrame) : targetFrame;
+    auto frameStep = (targetFrame - frame) / (float)numSamples;
+
+    // The same integer phase as the fixed shapes: its top fftOrder bits index the frame, the rest interpolate
+    constexpr int fractionBits = 32 - Wavetable::fftOrder;
+    constexpr juce::uint32 fractionMask = (1u << fractionBits) - 1;
+    constexpr auto fractionScale = 1.0f / (float)(1u << fractionBits);
+    const auto startPhase = voice.oscillatorPhase;
+    const auto increment = OscillatorKernels::getIncrement(voice.frequency, currentSampleRate);
+
+    // Lower tiers read only the nearest frame - half the lookups, slightly steppy morphing
+    if (tierSettings->fastOscillators)
+    {
+        const auto* nearest = table.getFrame(mipLevel, juce::jlimit(0, lastFrame, juce::roundToInt(frame + frameStep * (float)numSamples * 0.5f)));
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto phase = startPhase + increment * (juce::uint32)i;
+            auto index = (int)(phase >> fractionBits);
+            auto fraction = (float)(phase & fractionMask) * fractionScale;
+            output[i] = nearest[index] + fraction * (nearest[index + 1] - nearest[index]);
+        }
+
+        voice.oscillatorPhase = startPhase + increment * (juce::uint32)numSamples;
+        voice.wavetableFrame = targetFrame;
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto frame0 = (int)frame;
+        auto frame1 = juce::jmin(frame0 + 1, lastFrame);
+        auto frameFraction = frame - (float)frame0;
+        const auto* table0 = table.getFrame(mipLevel, frame0);
+        const auto* table1 = table.getFrame(mipLevel, frame1);
+
+        // Linear interpolation within each frame, then between the two frames
+        auto phase = startPhase + increment * (juce::uint32)i;
+        auto index = (int)(phase >> fractionBits);
+        auto fraction = (float)(phase & fractionMask) * fractionScale;
+        auto sample0 = table0[index] + fraction * (table0[index + 1] - table0[index]);
+        auto sample1 = table1[index] + fraction * (table1[index + 1] - table1[index]);
+        output[i] = sample0 + frameFraction * (sample1 - sample0);
+        frame += frameStep;
+    }
+
+    voice.oscillatorPhase = startPhase + increment * (juce::uint32)numSamples;
+    voice.wavetableFrame = targetFrame;
+}
+
+void SynthEngine::renderSampler(Voice& voice, float* output, int numSamples, double pitchRatio)
+{
+    const auto& zone = *voice.zone;
+    const auto* head = zone.head.getReadPointer(0);
+
+    // Whatever the prefetcher has delivered so far; anything beyond that plays as silence
+    SampleStreamer::StreamView stream;
+    bool hasStream = sampleStreamer->getStreamView(voice.index, voice.streamGeneration, stream);
+    bool underrun = false;
+
+    auto sampleAt = [&](juce::int64 position) -> float
+    {
+        if (position < zone.headLength)
+            return head[position];
+        if (hasStream && position < stream.availableEnd)
+            return stream.ring[position & (SampleStreamer::ringSize - 1)];
+        underrun = true;
+        return 0.0f;
+    };
+
+    auto increment = voice.sampleIncrement * pitchRatio;
+    auto lastPosition = zone.lengthInSamples - 1;
+    double position = voice.samplePosition;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (position >= (double)lastPosition)
+        {
+            // End of the sample: pad the block and let renderVoice stop the voice
+            juce::FloatVectorOperations::clear(output + i, numSamples - i);
+            voice.sourceFinished = true;
+            break;
+        }
+
+        // Linear interpolation between neighbouring source samples
+        auto index0 = (juce::int64)position;
+        auto fraction = (float)(position - (double)index0);
+        auto sample0 = sampleAt(index0);
+        auto sample1 = sampleAt(index0 + 1);
+        output[i] = sample0 + fraction * (sample1 - sample0);
+
+        position += increment;
+    }
+
+    voice.samplePosition = position;
+
+    // Tell the prefetcher what may be overwritten; the next block starts reading at floor(position)
+    sampleStreamer->setPlayPosition(voice.index, (juce::int64)position);
+
+    // The play head ran past what the prefetcher has delivered - the disk isn't keeping up
+    if (underrun)
+        sampleStreamer->reportUnderrun();
+}
+
+void SynthEngine::publishBlockStatistics() noexcept
+{
+    // Read by other threads (scope, stats) instead of the voices, which may belong to the render-ahead worker
+    numSoundingVoices.store(getNumActiveVoices(), std::memory_order_relaxed);
+    currentFrequency.store(isActive() ? lastStartedFrequency : 0.0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void SynthEngine::prepareState(State& state) const
+{
+    // Every voice's filter state vectors get their size here, so copying any voice in later doesn't allocate
+    state.voices = voices;
+    saveState(state);
+}
+
+void SynthEngine::saveState(State& state) const
+{
+    state.activeVoices = 0;
+    for (size_t i = 0; i < voices.size(); ++i)
+    {
+        const auto& voice = voices[i];
+        if (! voice.isActive())
+            continue;
+
+        state.activeVoices |= 1u << i;
+        state.voices[i] = voice;
+        if (voice.voiceType == additiveVoice)
+            state.additive[i] = additiveStates[i];
+        else if (voice.voiceType == granularVoice)
+            state.granular[i] = granularStates[i];
+    }
+
+    state.nextStartOrder = nextStartOrder;
+    state.lastStartedFrequency = lastStartedFrequency;
+    state.appliedAdsrVersion = appliedAdsrVersion;
+    state.appliedFilterVersion = appliedFilterVersion;
+    state.appliedQualityTier = appliedQualityTier;
+    state.tierSettings = tierSettings;
+    state.baseCutoffHz = baseCutoffHz;
+    state.liveWritePosition = granularSynth.getLiveWritePosition();
+    state.libraryGeneration = libraryGeneration;
+}
+
+bool SynthEngine::isStreaming(const Voice& voice) noexcept
+{
+    return voice.voiceType == samplerVoice && voice.zone != nullptr;
+}
+
+bool SynthEngine::canRewindStreams(const State& state) const noexcept
+{
+    // The prefetcher only moves forwards. A stream that is still this voice's can be replayed as far
+    // back as the ring keeps played samples; one that was released or restarted since starts over
+    // from the end of the head, so the restored voice must not have got past it.
+    for (size_t i = 0; i < voices.size(); ++i)
+    {
+        const auto& saved = state.voices[i];
+        if ((state.activeVoices & (1u << i)) == 0 || ! isStreaming(saved) || saved.samplePosition < saved.zone->headLength)
+            continue;
+
+        const auto& voice = voices[i];
+        if (saved.streamGeneration != voice.streamGeneration
+            || voice.samplePosition - saved.samplePosition >= SampleStreamer::rewindMargin - 1)
+            return false;
+    }
+    return true;
+}
+
+bool SynthEngine::restoreState(const State& state)
+{
+    // Voices in the snapshot may point at zones of a library that has since been deleted
+    if (state.libraryGeneration != libraryGeneration || ! canRewindStreams(state))
+        return false;
+
+    for (size_t i = 0; i < voices.size(); ++i)
+    {
+        auto& voice = voices[i];
+        if ((state.activeVoices & (1u << i)) != 0)
+        {
+            const auto& saved = state.voices[i];
+            auto keepsStream = isStreaming(saved) && saved.streamGeneration == voice.streamGeneration;
+            if (! keepsStream)
+                releaseStream(voice);
+
+            voice = saved;
+            if (isStreaming(voice) && ! keepsStream)
+                voice.streamGeneration = sampleStreamer->requestStream(voice.index, voice.zone); // Still in its head
+            else if (voice.voiceType == additiveVoice)
+                additiveStates[i] = state.additive[i];
+            else if (voice.voiceType == granularVoice)
+                granularStates[i] = state.granular[i];
+        }
+        else if (voice.isActive())
+        {
+            // Started after the snapshot: silent again, as it was then
+            voice.isKeyDown = false;
+            voice.adsr.reset();
+            voice.pendingInputTicks = 0;
+            releaseStream(voice);
+        }
+    }
+
+    nextStartOrder = state.nextStartOrder;
+    lastStartedFrequency = state.lastStartedFrequency;
+    appliedAdsrVersion = state.appliedAdsrVersion;
+    appliedFilterVersion = state.appliedFilterVersion;
+    appliedQualityTier = state.appliedQualityTier;
+    tierSettings = state.tierSettings;
+    baseCutoffHz = state.baseCutoffHz;
+    granularSynth.setLiveWritePosition(state.liveWritePosition); // The ring is rewritten as the engine renders again
+    numFirstSoundEvents = nextFirstSoundEvent = 0;
+    return true;
+}
+
+bool SynthEngine::popFirstSoundEvent(juce::int64& inputTicks, int& inputPath, int& sampleOffset)
+{
+    if (nextFirstSoundEvent >= numFirstSoundEvents)
+        return false;
+
+    const auto& event = firstSoundEvents[(size_t)nextFirstSoundEvent++];
+    inputTicks = event.inputTicks;
+    inputPath = event.inputPath;
+    sampleOffset = event.sampleOffset;
+    return true;
+}
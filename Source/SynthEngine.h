@@ -2,51 +2,244 @@
 
 #include <JuceHeader.h>
 #include <juce_dsp/juce_dsp.h> // Needed for Filter and ProcessSpec
+#include <array>
 #include <atomic>
+#include "NoteEventQueue.h"
+#include "SampleStreamer.h"
+#include "WavetableBank.h"
+#include "QualityGovernor.h"
+#include "MpeInput.h"
+#include "FmSynth.h"
+#include "AdditiveSynth.h"
+#include "GranularSynth.h"
 
 // Forward declare MainComponent just in case (though not strictly needed by header now)
 class MainComponent;
 
 //==============================================================================
 /*
-    Handles the core sound generation (oscillator + filter + ADSR) for one synth voice.
+    Handles the core sound generation (oscillator or sampler + filter + ADSR) for a
+    fixed pool of polyphonic voices.
+
+    Parameter setters may be called from the message thread; they only store into
+    atomics which the audio thread picks up at the start of the next block. Note
+    events (handleNoteEvent/noteOn/noteOff) and rendering happen on the audio thread.
 */
 class SynthEngine
 {
 public:
+    static constexpr int maxVoices = SampleStreamer::numSlots; // One stream slot per voice
+
+    enum VoiceType
+    {
+        oscillatorVoice = 1, // Matches the ComboBox IDs in ControlsComponent
+        samplerVoice,
+        fmVoice,
+        additiveVoice,
+        granularVoice
+    };
+
     SynthEngine();
-    double getCurrentFrequency() const; // <-- ADD THIS DECLARATION
+    // Any thread: frequency of the most recently started voice at the end of the last rendered block (0 if silent)
+    double getCurrentFrequency() const noexcept { return currentFrequency.load(std::memory_order_relaxed); }
+
     // --- Setup ---
     // Prepare engine for playback with audio specs
-    void prepareToPlay(double sampleRate, int maximumBlockSize, int numChannels); // <-- Updated signature
+    void prepareToPlay(double sampleRate, int maximumBlockSize, int numChannels);
 
-    // --- Parameter Setters called by MainComponent ---
+    // --- Parameter Setters called by MainComponent (any thread) ---
     void setParameters(const juce::ADSR::Parameters& params); // For ADSR
-    void setWaveform(int waveformTypeId);
-    void setFrequency(double frequencyHz);
-    void setFilterParameters(float cutoffHz, float resonance); // <-- NEW for Filter
+    void setWaveform(int waveformTypeId);                    // MainComponent::Waveform, or a WavetableBank ID
+    void setWavetablePosition(float position);              // 0-1 across the frames of a user wavetable
+    void setPitchOffset(float semitones);                    // Transpose + fine tune, applied to every voice
+    void setFilterParameters(float cutoffHz, float resonance);
+    void setVoiceType(int voiceTypeId);                      // Applies to notes started after the change
+    void setFmPatch(int patchIndex);                         // FmSynth preset/algorithm, applies to sounding FM voices too
+    void setAdditivePreset(int presetIndex);                 // AdditiveSynth spectral envelope, likewise
+    void setGranularPreset(int presetIndex);                 // GranularSynth preset, likewise
+    void setQualityTier(int tier);                           // QualityGovernor::Tier, applied at the next block
 
-    // --- Triggers ---
-    void noteOn();
-    void noteOff();
-    bool isActive() const; // Keep this
+    // Source of sampler zones. Set once, before audio starts; may be nullptr (sampler voices stay silent).
+    void setSampleStreamer(SampleStreamer* streamer) { sampleStreamer = streamer; }
+    // Source of user wavetables. Set once, before audio starts.
+    void setWavetableBank(const WavetableBank* bank) { wavetableBank = bank; }
+    // Per-note expression for MPE notes (NoteEvent::expressionSlot). Set once, before audio starts.
+    // The engine reports back when a released note's voice has gone silent, so its slot can be reused.
+    void setExpressionSource(MpeInput* source) { expressionSource = source; }
+
+    // --- Triggers (audio thread) ---
+    void handleNoteEvent(const NoteEvent& event);
+    // inputTicks: juce::Time::getHighResolutionTicks() when the triggering input arrived (0 = not measured)
+    // expressionSlot: MpeInput slot whose bend/pressure/timbre modulate the voice (-1 = none)
+    void noteOn(int midiNote, float velocity, juce::int64 inputTicks = 0, int inputPath = 0, int expressionSlot = -1);
+    void noteOff(int midiNote, int expressionSlot = -1);
+    void allNotesOff();
+    bool isActive() const; // True while any voice is still sounding
+    int  getNumActiveVoices() const;
+    // Any thread: voices still sounding at the end of the last rendered block (for monitoring)
+    int  getNumSoundingVoices() const noexcept { return numSoundingVoices.load(std::memory_order_relaxed); }
 
     // --- Audio Processing ---
     void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
 
+    // --- Render-ahead rollback (whichever thread is rendering) ---
+    class State; // Snapshot of everything renderNextBlock advances, defined below
+    void prepareState(State& state) const; // Sizes a snapshot so that saveState never allocates (may allocate)
+    void saveState(State& state) const;   // Allocation-free once prepareState has been called on state
+    bool restoreState(const State& state); // False (and nothing restored) if a sample library was swapped in since
+
+    // --- Latency measurement (audio thread, call right after renderNextBlock) ---
+    // Returns true once per measured note, when the block just rendered contained its first non-zero sample.
+    // Call repeatedly until it returns false - a chord produces one event per note.
+    bool popFirstSoundEvent(juce::int64& inputTicks, int& inputPath, int& sampleOffset);
+
 
 private:
+    struct Voice
+    {
+        int          midiNote = -1;   // Note currently assigned (-1 = never used)
+        float        velocity = 0.0f;
+        bool         isKeyDown = false;
+        juce::uint32 startOrder = 0;  // For stealing the oldest voice
+        juce::uint32 oscillatorPhase = 0; // Oscillator and wavetable phase, 2^32 per cycle
+        double       frequency = 0.0;
+        float        wavetableFrame = -1.0f; // Smoothed frame position (-1 = jump straight to the target)
+
+        // Per-note expression lanes (MPE), smoothed and applied once per block
+        int          expressionSlot = -1;
+        float        pitchBendSemitones = 0.0f;
+        float        cutoffOctaves = 0.0f;  // From pressure and timbre
+        float        appliedCutoff = -1.0f; // What the filter coefficients were last computed for
+
+        // Cheaper kernels used at the lower quality tiers
+        float        onePoleState = 0.0f;   // One-pole lowpass in place of the state-variable filter
+        float        onePoleCoefficient = 1.0f;
+        float        envelopeLevel = 0.0f;  // Envelope ramp between control-rate ADSR evaluations
+        float        envelopeStep = 0.0f;
+        int          envelopeCountdown = 0;
+
+        // Latency tracking: set by noteOn, resolved once the voice produces sound
+        juce::int64  pendingInputTicks = 0;
+        int          pendingInputPath = 0;
+
+        // Sampler state (voiceType == samplerVoice). The voice index doubles as its stream slot.
+        int          index = 0;
+        int          voiceType = oscillatorVoice; // Latched at noteOn
+        const SampleLibrary::Zone* zone = nullptr;
+        juce::uint32 streamGeneration = 0;
+        double       samplePosition = 0.0;  // In source samples
+        double       sampleIncrement = 1.0; // Before the global pitch offset
+        bool         sourceFinished = false;
+
+        // FM state (voiceType == fmVoice): operator phases and envelopes.
+        // The much larger additive and granular states are kept per voice index outside the
+        // voice (additiveStates, granularStates), so a snapshot copies them only for voices using them.
+        FmSynth::VoiceState fm;
+
+        // DSP Modules (one of each per voice, so every note has its own envelope and filter state)
+        juce::dsp::StateVariableTPTFilter<float> filter;
+        juce::ADSR adsr;
+
+        bool isActive() const { return adsr.isActive(); }
+    };
+
+    struct FirstSoundEvent
+    {
+        juce::int64 inputTicks = 0;
+        int inputPath = 0;
+        int sampleOffset = 0;
+    };
+
+    Voice& findVoiceForNote(int midiNote, int expressionSlot);
+    void   applyPendingParameters();
+    void   applyQualityTier();
+    void   enforcePolyphonyLimit();
+    void   updateExpressionLanes(Voice& voice, int numSamples, bool jumpToTarget);
+    void   releaseIdleExpressionSlots();
+    void   renderVoice(Voice& voice, float* output, int numSamples, int waveTypeInt, double pitchRatio);
+    void   renderOscillator(Voice& voice, float* output, int numSamples, int waveTypeInt);
+    void   renderWavetable(Voice& voice, float* output, int numSamples, const Wavetable& table);
+    void   renderSampler(Voice& voice, float* output, int numSamples, double pitchRatio);
+    void   releaseStream(Voice& voice);
+    static bool isStreaming(const Voice& voice) noexcept; // Sampler voice with a zone: its stream slot is in use
+    bool   canRewindStreams(const State& state) const noexcept;
+
     // Audio State
     double currentSampleRate = 0.0;
-    double currentAngle = 0.0;
-    double angleDelta = 0.0;
-    double frequency = 440.0;
-
-    // Parameters
-    std::atomic<int> currentWaveformType{ 1 }; // Default Sine
-
-    // DSP Modules
-    juce::dsp::StateVariableTPTFilter<float> filter; // <-- ADDED Filter object
-    juce::ADSR adsr;
-    juce::ADSR::Parameters adsrParams; // Store local copy
-};
\ No newline at end of file
+    int    maxBlockSize = 0;
+    juce::uint32 nextStartOrder = 0;
+    std::array<Voice, maxVoices> voices;
+    std::array<AdditiveSynth::VoiceState, maxVoices> additiveStates;   // Partial phases and overlap-add buffer, by voice index
+    std::array<GranularSynth::VoiceState, maxVoices> granularStates;   // Grain pool and scheduler; reads the zone's head, unstreamed
+    juce::AudioBuffer<float> voiceBuffer; // Mono scratch, one voice at a time
+    FmSynth fmSynth;                      // Shared operator buffers, also one voice at a time
+    const FmSynth::Patch* fmPatch = &FmSynth::getPatch(0); // Block-constant
+    AdditiveSynth additiveSynth;          // Shared FFT and kernel tables
+    int additivePresetIndex = 0;          // Block-constant
+    GranularSynth granularSynth;          // Window tables, live ring and shared scratch
+    const GranularSynth::Preset* granularPreset = &GranularSynth::getPreset(0); // Block-constant
+    double lastStartedFrequency = 0.0;
+
+    // Parameters (written by any thread, read by the audio thread)
+    std::atomic<int>   currentWaveformType{ 1 }; // Default Sine
+    std::atomic<int>   currentVoiceType{ oscillatorVoice };
+    std::atomic<int>   currentFmPatch{ 0 };
+    std::atomic<int>   currentAdditivePreset{ 0 };
+    std::atomic<int>   currentGranularPreset{ 0 };
+    std::atomic<float> wavetablePosition{ 0.0f };
+    std::atomic<float> pitchOffsetSemitones{ 0.0f };
+    std::atomic<float> adsrAttack{ 0.05f }, adsrDecay{ 0.1f }, adsrSustain{ 0.8f }, adsrRelease{ 0.5f };
+    std::atomic<float> filterCutoff{ 10000.0f };
+    std::atomic<float> filterResonance{ 0.707f };
+    std::atomic<int>   adsrVersion{ 0 }, filterVersion{ 0 }; // Bumped by setters
+    int appliedAdsrVersion = -1, appliedFilterVersion = -1;   // Audio thread's copy
+    std::atomic<int>   qualityTier{ QualityGovernor::fullQuality };
+    int appliedQualityTier = -1;
+    const QualityGovernor::TierSettings* tierSettings = &QualityGovernor::getTierSettings(QualityGovernor::fullQuality);
+    float baseCutoffHz = 10000.0f;   // Clamped filter cutoff before per-note modulation
+
+    SampleStreamer* sampleStreamer = nullptr;
+    juce::uint32 libraryGeneration = 0; // Bumped by each library swap: zone pointers from before are dead
+    const WavetableBank* wavetableBank = nullptr;
+    MpeInput* expressionSource = nullptr;
+    juce::uint32 releasedExpressionSlots = 0; // Bit per slot: note-off handled, waiting for its voices to go silent
+    static_assert(MpeInput::numExpressionSlots <= 32, "releasedExpressionSlots has one bit per slot");
+
+    std::atomic<int> numSoundingVoices{ 0 };
+    std::atomic<double> currentFrequency{ 0.0 };  // Published with numSoundingVoices, for the scope
+    void publishBlockStatistics() noexcept;
+
+    // Latency tracking results for the current block
+    std::array<FirstSoundEvent, maxVoices> firstSoundEvents;
+    int numFirstSoundEvents = 0;
+    int nextFirstSoundEvent = 0;
+};
+
+//==============================================================================
+/*
+    Everything the audio-thread side of SynthEngine changes while rendering, so
+    RenderAhead can rewind the engine to an earlier point and render again.
+    Parameters live in atomics and are not part of it; the "applied" copies are.
+
+    Only the voices sounding at the time are saved, each with the per-type state
+    its voice type uses. A voice that was silent is restored as silent; whatever
+    else it held is rebuilt by its next noteOn.
+*/
+class SynthEngine::State
+{
+private:
+    friend class SynthEngine;
+    static_assert(maxVoices <= 32, "activeVoices has one bit per voice");
+
+    juce::uint32 activeVoices = 0;  // Bit per voice: saved below
+    std::array<Voice, maxVoices> voices;
+    std::array<AdditiveSynth::VoiceState, maxVoices> additive;
+    std::array<GranularSynth::VoiceState, maxVoices> granular;
+    juce::uint32 nextStartOrder = 0;
+    double lastStartedFrequency = 0.0;
+    int appliedAdsrVersion = -1, appliedFilterVersion = -1, appliedQualityTier = -1;
+    const QualityGovernor::TierSettings* tierSettings = nullptr;
+    float baseCutoffHz = 0.0f;
+    juce::int64 liveWritePosition = 0;
+    juce::uint32 libraryGeneration = 0;
+};
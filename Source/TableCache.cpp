@@ -0,0 +1,156 @@
+#include "TableCache.h"
+#include <cstring>
+#include <map>
+
+namespace
+{
+    constexpr juce::uint32 fileMagic = 0x43545343; // "CSTC" in memory on little-endian
+    constexpr size_t headerSize = 128;              // Payload starts here; keeps it 16-byte aligned in the mapping
+    constexpr size_t maxKeyLength = 80;
+
+    struct FileHeader
+    {
+        juce::uint32 magic;
+        juce::uint32 formatVersion;
+        juce::uint32 generatorVersion;
+        juce::uint32 keyLength;
+        juce::uint64 payloadSize;
+        juce::uint64 checksum;                      // FNV-1a, 64-bit, over the payload
+        char key[maxKeyLength];
+    };
+
+    static_assert(sizeof(FileHeader) <= headerSize, "The header must fit before the payload");
+
+    juce::uint64 fnv1a(const void* data, size_t size) noexcept
+    {
+        auto hash = (juce::uint64)0xcbf29ce484222325ull;
+        const auto* bytes = static_cast<const juce::uint8*>(data);
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        return hash;
+    }
+
+    // Maps the file if it is a complete, current copy of the table (of expectedSize bytes, unless 0); null otherwise
+    std::unique_ptr<juce::MemoryMappedFile> mapValidFile(const juce::File& file, const juce::String& key,
+                                                         juce::uint32 generatorVersion, size_t expectedSize)
+    {
+        if (! file.existsAsFile())
+            return nullptr;
+
+        auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+        if (mapped->getData() == nullptr || mapped->getSize() < headerSize)
+            return nullptr;
+
+        FileHeader header;
+        std::memcpy(&header, mapped->getData(), sizeof(header));
+        const auto keyUtf8 = key.toRawUTF8();
+        const auto keyLength = std::strlen(keyUtf8);
+        const auto* payload = static_cast<const char*>(mapped->getData()) + headerSize;
+
+        if (header.magic != fileMagic || header.formatVersion != TableCache::formatVersion
+            || header.generatorVersion != generatorVersion
+            || header.keyLength != keyLength || std::memcmp(header.key, keyUtf8, keyLength) != 0
+            || header.payloadSize != mapped->getSize() - headerSize
+            || (expectedSize != 0 && header.payloadSize != expectedSize)
+            || header.checksum != fnv1a(payload, (size_t)header.payloadSize))
+            return nullptr;
+
+        return mapped;
+    }
+
+    // Written next to the target and renamed over it, so no reader ever maps half a file
+    bool writeFile(const juce::File& file, const juce::String& key, juce::uint32 generatorVersion, const juce::MemoryBlock& payload)
+    {
+        if (! file.getParentDirectory().createDirectory())
+            return false;
+
+        char headerBytes[headerSize] = {};
+        FileHeader header{};
+        header.magic = fileMagic;
+        header.formatVersion = TableCache::formatVersion;
+        header.generatorVersion = generatorVersion;
+        header.keyLength = (juce::uint32)std::strlen(key.toRawUTF8());
+        std::memcpy(header.key, key.toRawUTF8(), header.keyLength);
+        header.payloadSize = payload.getSize();
+        header.checksum = fnv1a(payload.getData(), payload.getSize());
+        std::memcpy(headerBytes, &header, sizeof(header));
+
+        juce::TemporaryFile temporary(file);
+        {
+            juce::FileOutputStream stream(temporary.getFile());
+            if (! stream.openedOk()
+                || ! stream.write(headerBytes, headerSize)
+                || ! stream.write(payload.getData(), payload.getSize()))
+                return false;
+
+            stream.flush();
+            if (stream.getStatus().failed())
+                return false;
+        }
+
+        return temporary.overwriteTargetFileWithTemporary();
+    }
+}
+
+//==============================================================================
+juce::File TableCache::getCacheFolder()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("CSYNTH").getChildFile("TableCache");
+}
+
+std::shared_ptr<const TableCache::Table> TableCache::getTable(const juce::String& key, juce::uint32 generatorVersion,
+                                                             const Builder& build, size_t expectedSize)
+{
+    jassert(key.isNotEmpty() && std::strlen(key.toRawUTF8()) <= maxKeyLength);
+
+    // Within the process, every engine asking for the same table gets the same mapping
+    static juce::CriticalSection registryLock;
+    static std::map<juce::String, std::weak_ptr<const Table>> registry;
+    const auto registryKey = key + "@" + juce::String(generatorVersion);
+    {
+        const juce::ScopedLock lock(registryLock);
+        if (auto existing = registry[registryKey].lock())
+            return existing;
+    }
+
+    // Not held while building: two threads wanting the same new table both build it, and the second rename wins
+    auto table = std::make_shared<Table>();
+    auto file = getCacheFolder().getChildFile(juce::File::createLegalFileName(key) + ".table");
+
+    table->mappedFile = mapValidFile(file, key, generatorVersion, expectedSize);
+    if (table->mappedFile == nullptr)
+    {
+        auto startMs = juce::Time::getMillisecondCounterHiRes();
+        auto payload = build();
+        jassert(expectedSize == 0 || payload.getSize() == expectedSize); // The builder and its caller disagree
+        DBG("TableCache: built " + key + " (" + juce::String((int)payload.getSize()) + " bytes) in "
+            + juce::String(juce::Time::getMillisecondCounterHiRes() - startMs, 1) + " ms");
+
+        if (writeFile(file, key, generatorVersion, payload))
+            table->mappedFile = mapValidFile(file, key, generatorVersion, expectedSize);
+
+        if (table->mappedFile == nullptr)
+        {
+            DBG("TableCache: could not cache " + file.getFullPathName() + " - keeping " + key + " in memory");
+            table->memoryCopy = std::move(payload);
+        }
+    }
+
+    if (table->mappedFile != nullptr)
+    {
+        table->data = static_cast<const char*>(table->mappedFile->getData()) + headerSize;
+        table->size = table->mappedFile->getSize() - headerSize;
+    }
+    else
+    {
+        table->data = table->memoryCopy.getData();
+        table->size = table->memoryCopy.getSize();
+    }
+
+    const juce::ScopedLock lock(registryLock);
+    if (auto existing = registry[registryKey].lock()) // Another thread got there first: share its copy
+        return existing;
+    registry[registryKey] = table;
+    return table;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+
+//==============================================================================
+/*
+    An on-disk cache of precomputed DSP tables (window shapes, kernels,
+    transformed impulse responses), shared by every SynthEngine in the
+    process and by every running instance of the app.
+
+    Each table is one file in <app data>/CSYNTH/TableCache, named by a key
+    that includes everything the table depends on, e.g. the sample rate:
+    "reverb-hall-48000". A file starts with a fixed header: magic, format
+    version, the generator's version, the key, the payload size and an
+    FNV-1a checksum of the payload. A file fails the check if anything in
+    it doesn't match, e.g. it was truncated, written by an older generator
+    or by a machine with the other endianness. A file that fails the check
+    is rebuilt and replaced.
+
+    Valid files are memory-mapped read-only. The tables are then read
+    straight from the page cache, not copied, so a cold start skips the
+    computation, and all instances share the same physical pages. New
+    files are written to a temporary file and renamed into place, so
+    instances building the same table at once never see a partial file.
+    If the folder can't be written, the built table is kept in memory.
+*/
+class TableCache
+{
+public:
+    static constexpr juce::uint32 formatVersion = 1;
+
+    // One table, mapped from its file (or held in memory if it couldn't be cached). Immutable.
+    class Table
+    {
+    public:
+        const void* getData() const noexcept { return data; }
+        size_t getSize() const noexcept { return size; }
+
+        // The payload from byteOffset on, as an array of T (the caller knows the layout it built)
+        template <typename T>
+        const T* getAs(size_t byteOffset = 0) const noexcept
+        {
+            jassert(byteOffset + sizeof(T) <= size && byteOffset % alignof(T) == 0);
+            return reinterpret_cast<const T*>(static_cast<const char*>(data) + byteOffset);
+        }
+
+    private:
+        friend class TableCache;
+
+        std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+        juce::MemoryBlock memoryCopy;   // Only when the file couldn't be written or mapped
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    using Builder = std::function<juce::MemoryBlock()>;
+
+    // Returns the table for key, building and writing it first if there's no valid file.
+    // Bump generatorVersion whenever the builder's output changes. A fixed-size table passes
+    // expectedSize: a file of any other size fails the check too, so it is rebuilt rather than
+    // read past its end. Any thread; the build runs on the calling thread, so keep it off the audio thread.
+    static std::shared_ptr<const Table> getTable(const juce::String& key, juce::uint32 generatorVersion,
+                                                 const Builder& build, size_t expectedSize = 0);
+
+    static juce::File getCacheFolder();
+
+private:
+    TableCache() = delete;
+};
@@ -0,0 +1,177 @@
+#include "TraceRecorder.h"
+#include <array>
+#include <memory>
+
+std::atomic<bool> TraceRecorder::recording{ false };
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        juce::int64 ticks;
+        bool isBegin;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<TraceEvent[]> events;
+        std::atomic<int> numEvents{ 0 };              // Written by the owning thread only
+        std::atomic<const char*> threadName{ nullptr };
+    };
+
+    // Allocated by the first start() and kept: a thread may still hold a slot index into them
+    std::array<ThreadBuffer, TraceRecorder::maxThreads> buffers;
+    bool buffersAllocated = false;
+
+    std::atomic<int> numClaimedBuffers{ 0 };
+    std::atomic<int> droppedEvents{ 0 };
+    std::atomic<juce::uint32> generation{ 0 }; // Bumped by start(): every thread claims a buffer afresh
+    juce::int64 startTicks = 0;
+
+    struct ThreadSlot
+    {
+        int index = -1;
+        juce::uint32 generation = 0;
+    };
+    thread_local ThreadSlot threadSlot;
+
+    // This thread's buffer for the current recording, claiming one if needed (nullptr if none left)
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        auto currentGeneration = generation.load(std::memory_order_acquire);
+        if (threadSlot.generation != currentGeneration || threadSlot.index < 0)
+        {
+            threadSlot.generation = currentGeneration;
+            threadSlot.index = numClaimedBuffers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return threadSlot.index < TraceRecorder::maxThreads ? &buffers[(size_t)threadSlot.index] : nullptr;
+    }
+
+    juce::String toMicroseconds(juce::int64 ticks)
+    {
+        return juce::String(juce::Time::highResolutionTicksToSeconds(ticks - startTicks) * 1.0e6, 3);
+    }
+}
+
+//==============================================================================
+void TraceRecorder::start()
+{
+    if (isRecording())
+        return;
+
+    if (! buffersAllocated)
+    {
+        for (auto& buffer : buffers)
+            buffer.events.reset(new TraceEvent[(size_t)eventsPerThread]);
+        buffersAllocated = true;
+    }
+
+    for (auto& buffer : buffers)
+    {
+        buffer.numEvents.store(0, std::memory_order_relaxed);
+        buffer.threadName.store(nullptr, std::memory_order_relaxed);
+    }
+    numClaimedBuffers.store(0, std::memory_order_relaxed);
+    droppedEvents.store(0, std::memory_order_relaxed);
+    startTicks = juce::Time::getHighResolutionTicks();
+
+    generation.fetch_add(1, std::memory_order_release);
+    recording.store(true, std::memory_order_release);
+    labelThisThread("Message thread");
+    DBG("TraceRecorder: recording started");
+}
+
+juce::File TraceRecorder::stopAndWrite()
+{
+    if (! isRecording())
+        return {};
+
+    recording.store(false, std::memory_order_relaxed);
+
+    auto file = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                    .getChildFile("CSYNTH")
+                    .getChildFile("trace_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".json");
+    file.getParentDirectory().createDirectory();
+
+    juce::FileOutputStream stream(file);
+    if (! stream.openedOk())
+    {
+        DBG("TraceRecorder: could not write " + file.getFullPathName());
+        return {};
+    }
+
+    // Chrome trace-event format: one track per thread (tid), timestamps in microseconds
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    auto first = true;
+    auto writeEvent = [&](const juce::String& json)
+    {
+        stream << (first ? "" : ",\n") << json;
+        first = false;
+    };
+
+    auto numThreads = juce::jmin((int)maxThreads, numClaimedBuffers.load(std::memory_order_relaxed));
+    int numWritten = 0;
+    for (int thread = 0; thread < numThreads; ++thread)
+    {
+        auto& buffer = buffers[(size_t)thread];
+        auto* threadName = buffer.threadName.load(std::memory_order_relaxed);
+        writeEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + juce::String(thread)
+                   + ",\"args\":{\"name\":\"" + (threadName != nullptr ? juce::String(threadName) : "Thread " + juce::String(thread)) + "\"}}");
+
+        auto numEvents = buffer.numEvents.load(std::memory_order_acquire);
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const auto& event = buffer.events[(size_t)i];
+            writeEvent("{\"name\":\"" + juce::String(event.name) + "\",\"ph\":\"" + (event.isBegin ? "B" : "E")
+                       + "\",\"ts\":" + toMicroseconds(event.ticks) + ",\"pid\":1,\"tid\":" + juce::String(thread) + "}");
+        }
+        numWritten += numEvents;
+    }
+    stream << "\n]}\n";
+    stream.flush();
+
+    DBG("TraceRecorder: wrote " + juce::String(numWritten) + " events from " + juce::String(numThreads) + " threads ("
+        + juce::String(getNumDroppedEvents()) + " dropped) to " + file.getFullPathName());
+    return file;
+}
+
+int TraceRecorder::getNumDroppedEvents() noexcept
+{
+    return droppedEvents.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+void TraceRecorder::labelThisThread(const char* threadName) noexcept
+{
+    if (! isRecording())
+        return;
+
+    if (auto* buffer = getThreadBuffer())
+        buffer->threadName.store(threadName, std::memory_order_relaxed);
+}
+
+bool TraceRecorder::record(const char* eventName, bool isBegin) noexcept
+{
+    auto ticks = juce::Time::getHighResolutionTicks();
+
+    auto* buffer = getThreadBuffer();
+    if (buffer == nullptr || ! isRecording())
+    {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Only this thread writes here; the release publishes the event to stopAndWrite()
+    auto index = buffer->numEvents.load(std::memory_order_relaxed);
+    if (index >= eventsPerThread)
+    {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    buffer->events[(size_t)index] = { eventName, ticks, isBegin };
+    buffer->numEvents.store(index + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/*
+    Scoped begin/end trace events from any thread, written out as Chrome
+    trace-event JSON (open in ui.perfetto.dev or chrome://tracing). It shows
+    where UI work overlaps the audio deadline and what each stage costs.
+
+    Each thread that records gets its own fixed-size buffer the first time
+    it records, so writing an event is a plain store and a release
+    increment - no locks, no allocation. The buffers are allocated once,
+    when recording first starts. A thread whose buffer is full, or that
+    arrives after all buffers are taken, stops recording and is counted.
+
+    While not recording, a ScopedEvent costs one relaxed atomic load.
+    Event names must be string literals: only the pointer is stored.
+
+    Started with --trace or F9; F9 again stops and writes
+    trace_<time>.json next to the latency log. A capture still running
+    when the app quits is written then, which is how a --headless run
+    (ended by --run-seconds or Ctrl-C) gets its trace.
+*/
+class TraceRecorder
+{
+public:
+    static constexpr int maxThreads = 16;
+    static constexpr int eventsPerThread = 1 << 15; // ~9 s of audio callback (~20 events per 256 samples at 48 kHz)
+
+    // --- Message thread ---
+    static void start();
+    // Stops recording and writes what was captured. Returns the file (or an empty File on failure).
+    static juce::File stopAndWrite();
+    static int getNumDroppedEvents() noexcept;
+
+    // --- Any thread ---
+    static bool isRecording() noexcept { return recording.load(std::memory_order_relaxed); }
+    // Names this thread's track in the trace (a string literal); cheap enough to call every callback
+    static void labelThisThread(const char* threadName) noexcept;
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* eventName) noexcept
+            : name(eventName), begun(isRecording() && record(eventName, true)) {}
+        ~ScopedEvent() noexcept
+        {
+            if (begun)
+                record(name, false);
+        }
+
+    private:
+        const char* name;
+        bool begun;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+
+private:
+    TraceRecorder() = delete;
+
+    static bool record(const char* eventName, bool isBegin) noexcept; // False if dropped
+
+    static std::atomic<bool> recording;
+};
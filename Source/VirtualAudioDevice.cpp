@@ -0,0 +1,242 @@
+#include "VirtualAudioDevice.h"
+
+//==============================================================================
+std::optional<VirtualAudioIODeviceType::Options> VirtualAudioIODeviceType::Options::fromCommandLine(const juce::String& commandLine)
+{
+    juce::ArgumentList args("CSYNTH", commandLine);
+    if (! args.containsOption("--virtual-audio"))
+        return std::nullopt;
+
+    Options result;
+    result.realTime = args.getValueForOption("--virtual-audio").equalsIgnoreCase("realtime");
+
+    auto doubleOption = [&](const char* name, double fallback)
+    {
+        auto text = args.getValueForOption(name);
+        return text.isNotEmpty() ? text.getDoubleValue() : fallback;
+    };
+
+    result.jitterMs = juce::jmax(0.0, doubleOption("--jitter-ms", result.jitterMs));
+    result.sampleRate = juce::jlimit(8000.0, 384000.0, doubleOption("--sample-rate", result.sampleRate));
+    result.bufferSize = juce::jlimit(16, 8192, (int)doubleOption("--buffer-size", result.bufferSize));
+    result.runSeconds = juce::jmax(0.0, doubleOption("--run-seconds", result.runSeconds));
+    result.headless = args.containsOption("--headless");
+    result.autoPlay = args.containsOption("--auto-play");
+    return result;
+}
+
+//==============================================================================
+VirtualAudioIODeviceType::VirtualAudioIODeviceType(const Options& optionsToUse)
+    : juce::AudioIODeviceType(typeName),
+      options(optionsToUse)
+{
+}
+
+juce::XmlElement VirtualAudioIODeviceType::createDeviceSetupXml() const
+{
+    // Same attributes AudioDeviceManager::createStateXml() writes
+    juce::XmlElement state("DEVICESETUP");
+    state.setAttribute("deviceType", typeName);
+    state.setAttribute("audioOutputDeviceName", options.realTime ? realTimeDeviceName : fastDeviceName);
+    state.setAttribute("audioDeviceRate", options.sampleRate);
+    state.setAttribute("audioDeviceBufferSize", options.bufferSize);
+    return state;
+}
+
+juce::StringArray VirtualAudioIODeviceType::getDeviceNames(bool wantInputNames) const
+{
+    if (wantInputNames)
+        return {};
+    return { fastDeviceName, realTimeDeviceName };
+}
+
+int VirtualAudioIODeviceType::getDefaultDeviceIndex(bool forInput) const
+{
+    return forInput ? -1 : (options.realTime ? 1 : 0);
+}
+
+int VirtualAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const
+{
+    if (device == nullptr || asInput)
+        return -1;
+    return getDeviceNames().indexOf(device->getName());
+}
+
+juce::AudioIODevice* VirtualAudioIODeviceType::createDevice(const juce::String& outputDeviceName, const juce::String& /*inputDeviceName*/)
+{
+    auto name = outputDeviceName.isNotEmpty() ? outputDeviceName : getDeviceNames()[getDefaultDeviceIndex(false)];
+    if (! getDeviceNames().contains(name))
+        return nullptr;
+
+    auto deviceOptions = options;
+    deviceOptions.realTime = name == realTimeDeviceName;
+    return new VirtualAudioIODevice(name, deviceOptions);
+}
+
+//==============================================================================
+VirtualAudioIODevice::VirtualAudioIODevice(const juce::String& deviceName, const VirtualAudioIODeviceType::Options& optionsToUse)
+    : juce::AudioIODevice(deviceName, VirtualAudioIODeviceType::typeName),
+      juce::Thread("CSYNTH Virtual Audio"),
+      options(optionsToUse)
+{
+}
+
+VirtualAudioIODevice::~VirtualAudioIODevice()
+{
+    close();
+}
+
+juce::String VirtualAudioIODevice::open(const juce::BigInteger& /*inputChannels*/, const juce::BigInteger& outputChannels,
+                                        double sampleRate, int bufferSizeSamples)
+{
+    close();
+
+    currentSampleRate = sampleRate > 0.0 ? sampleRate : options.sampleRate;
+    currentBufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : options.bufferSize;
+    activeOutputChannels = outputChannels;
+    activeOutputChannels.setRange(2, activeOutputChannels.getHighestBit() + 1, false); // Only Left/Right exist
+    outputBuffer.setSize(juce::jmax(1, activeOutputChannels.countNumberOfSetBits()), currentBufferSize);
+
+    blocksRendered = 0;
+    slowestCallbackMs = totalCallbackMs = 0.0;
+    quitRequested = false;
+    deviceIsOpen = true;
+
+    // Realtime priority in paced mode, so the pacing and jitter are the only timing noise
+    startThread(options.realTime ? juce::Thread::Priority::highest : juce::Thread::Priority::normal);
+
+    DBG("VirtualAudioIODevice: Opened '" + getName() + "' at " + juce::String(currentSampleRate)
+        + " Hz, " + juce::String(currentBufferSize) + " samples");
+    return {};
+}
+
+void VirtualAudioIODevice::close()
+{
+    if (! deviceIsOpen)
+        return;
+
+    stop();
+    stopThread(2000);
+    deviceIsOpen = false;
+
+    if (! quitRequested) // Otherwise already reported when the run ended
+        logSummary();
+}
+
+void VirtualAudioIODevice::start(juce::AudioIODeviceCallback* callback)
+{
+    if (callback == nullptr || ! deviceIsOpen)
+        return;
+
+    callback->audioDeviceAboutToStart(this);
+
+    const juce::ScopedLock sl(callbackLock);
+    currentCallback = callback;
+}
+
+void VirtualAudioIODevice::stop()
+{
+    juce::AudioIODeviceCallback* previousCallback = nullptr;
+    {
+        const juce::ScopedLock sl(callbackLock); // Waits for a block in progress
+        previousCallback = currentCallback;
+        currentCallback = nullptr;
+    }
+
+    if (previousCallback != nullptr)
+        previousCallback->audioDeviceStopped();
+}
+
+//==============================================================================
+void VirtualAudioIODevice::run()
+{
+    wallStartMs = juce::Time::getMillisecondCounterHiRes();
+    juce::int64 blockIndex = 0;
+
+    while (! threadShouldExit())
+    {
+        if (options.realTime)
+            waitForNextDeadline(blockIndex, wallStartMs);
+
+        {
+            const juce::ScopedLock sl(callbackLock);
+
+            if (currentCallback == nullptr)
+            {
+                // Not started yet (or stopped) - don't spin
+                const juce::ScopedUnlock su(callbackLock);
+                wait(5);
+                wallStartMs = juce::Time::getMillisecondCounterHiRes();
+                blockIndex = 0;
+                continue;
+            }
+
+            // Virtual time of the first sample in this block
+            auto hostTimeNs = (juce::uint64)((double)blocksRendered * currentBufferSize / currentSampleRate * 1.0e9);
+            juce::AudioIODeviceCallbackContext context;
+            context.hostTimeNs = &hostTimeNs;
+
+            outputBuffer.clear();
+            auto callbackStartMs = juce::Time::getMillisecondCounterHiRes();
+            currentCallback->audioDeviceIOCallbackWithContext(nullptr, 0, outputBuffer.getArrayOfWritePointers(),
+                                                              outputBuffer.getNumChannels(), currentBufferSize, context);
+            auto callbackMs = juce::Time::getMillisecondCounterHiRes() - callbackStartMs;
+
+            slowestCallbackMs = juce::jmax(slowestCallbackMs, callbackMs);
+            totalCallbackMs += callbackMs;
+            ++blocksRendered;
+            ++blockIndex;
+        }
+
+        // --run-seconds: once enough virtual time has passed, report and ask the app to quit.
+        // The callback is left attached - the device manager detaches it on the message thread.
+        auto virtualSeconds = (double)blocksRendered * currentBufferSize / currentSampleRate;
+        if (options.runSeconds > 0.0 && virtualSeconds >= options.runSeconds)
+        {
+            quitRequested = true;
+            logSummary();
+            juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+
+            while (! threadShouldExit())
+                wait(10);
+        }
+    }
+}
+
+void VirtualAudioIODevice::waitForNextDeadline(juce::int64 blockIndex, double startMs)
+{
+    // When the next block would be due from a real device, plus some random lateness
+    auto deadlineMs = startMs + (double)blockIndex * currentBufferSize * 1000.0 / currentSampleRate;
+    if (options.jitterMs > 0.0)
+        deadlineMs += jitterRandom.nextDouble() * options.jitterMs;
+
+    for (;;)
+    {
+        auto remainingMs = deadlineMs - juce::Time::getMillisecondCounterHiRes();
+        if (remainingMs <= 0.0 || threadShouldExit())
+            return;
+
+        // Sleep most of the way, then yield for the last millisecond for sub-ms accuracy
+        if (remainingMs > 1.5)
+            wait((int)(remainingMs - 1.0));
+        else
+            juce::Thread::yield();
+    }
+}
+
+void VirtualAudioIODevice::logSummary()
+{
+    if (blocksRendered == 0)
+        return;
+
+    auto virtualSeconds = (double)blocksRendered * currentBufferSize / currentSampleRate;
+    auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - wallStartMs) * 0.001;
+    auto blockDeadlineMs = currentBufferSize * 1000.0 / currentSampleRate;
+
+    // Logger rather than DBG so CI runs of release builds see it too
+    juce::Logger::writeToLog("VirtualAudioIODevice: " + juce::String(blocksRendered) + " blocks, "
+        + juce::String(virtualSeconds, 1) + " s audio in " + juce::String(wallSeconds, 1) + " s ("
+        + juce::String(virtualSeconds / juce::jmax(wallSeconds, 1.0e-6), 1) + "x real time). Callback mean "
+        + juce::String(totalCallbackMs / (double)blocksRendered, 3) + " ms, max " + juce::String(slowestCallbackMs, 3)
+        + " ms, deadline " + juce::String(blockDeadlineMs, 3) + " ms");
+}
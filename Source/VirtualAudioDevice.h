@@ -0,0 +1,121 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <optional>
+
+//==============================================================================
+/*
+    A null audio device driven by a virtual clock, for running the complete app
+    (MainComponent::getNextAudioBlock and everything it feeds) on machines with
+    no sound card - CI boxes, containers, profilers.
+
+    Its thread calls audioDeviceIOCallbackWithContext() with silent inputs and
+    discards the outputs, either
+      - fast:      back to back, as fast as the callback allows (soak tests,
+                   profiling - an hour of audio renders in a fraction of that), or
+      - real time: paced to the sample rate against the wall clock, with an
+                   optional random lateness added to each wake-up to imitate a
+                   jittery driver.
+
+    The context passed to the callback carries the virtual time in nanoseconds.
+
+    Selected from the command line (see Options::fromCommandLine), e.g.
+        CSYNTH --virtual-audio=fast --run-seconds=600 --headless
+*/
+class VirtualAudioIODeviceType : public juce::AudioIODeviceType
+{
+public:
+    struct Options
+    {
+        bool   realTime = false;
+        double jitterMs = 0.0;       // Real-time mode: each wake-up is late by up to this much
+        double sampleRate = 48000.0;
+        int    bufferSize = 256;
+        double runSeconds = 0.0;     // Quit the app after this much virtual time (0 = run forever)
+        bool   headless = false;     // No window (see Main.cpp)
+        bool   autoPlay = false;     // Play notes and move parameters without a user (see MainComponent)
+
+        // --virtual-audio[=fast|realtime] --jitter-ms=<ms> --sample-rate=<hz> --buffer-size=<n>
+        // --run-seconds=<s> --headless --auto-play. Returns nothing unless --virtual-audio is given.
+        static std::optional<Options> fromCommandLine(const juce::String& commandLine);
+    };
+
+    static constexpr const char* typeName = "Virtual";
+    static constexpr const char* fastDeviceName = "Virtual Clock (fast)";
+    static constexpr const char* realTimeDeviceName = "Virtual Clock (real time)";
+
+    explicit VirtualAudioIODeviceType(const Options& optionsToUse);
+
+    // Device state XML that makes AudioDeviceManager::initialise pick the right virtual device
+    juce::XmlElement createDeviceSetupXml() const;
+
+    // AudioIODeviceType
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName, const juce::String& inputDeviceName) override;
+
+private:
+    Options options;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioIODeviceType)
+};
+
+//==============================================================================
+class VirtualAudioIODevice : public juce::AudioIODevice,
+    private juce::Thread
+{
+public:
+    VirtualAudioIODevice(const juce::String& deviceName, const VirtualAudioIODeviceType::Options& optionsToUse);
+    ~VirtualAudioIODevice() override;
+
+    juce::StringArray getOutputChannelNames() override { return { "Left", "Right" }; }
+    juce::StringArray getInputChannelNames() override { return {}; }
+    juce::Array<double> getAvailableSampleRates() override { return { 44100.0, 48000.0, 88200.0, 96000.0 }; }
+    juce::Array<int> getAvailableBufferSizes() override { return { 32, 64, 128, 256, 512, 1024, 2048, 4096 }; }
+    int getDefaultBufferSize() override { return options.bufferSize; }
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                      double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override { return deviceIsOpen; }
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override { return currentCallback != nullptr; }
+    juce::String getLastError() override { return {}; }
+
+    int getCurrentBufferSizeSamples() override { return currentBufferSize; }
+    double getCurrentSampleRate() override { return currentSampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+    juce::BigInteger getActiveOutputChannels() const override { return activeOutputChannels; }
+    juce::BigInteger getActiveInputChannels() const override { return {}; }
+    int getOutputLatencyInSamples() override { return 0; }
+    int getInputLatencyInSamples() override { return 0; }
+
+private:
+    void run() override;
+    void waitForNextDeadline(juce::int64 blockIndex, double startMs);
+    void logSummary();
+
+    VirtualAudioIODeviceType::Options options;
+    bool deviceIsOpen = false;
+    double currentSampleRate = 48000.0;
+    int currentBufferSize = 256;
+    juce::BigInteger activeOutputChannels;
+    juce::AudioBuffer<float> outputBuffer;
+
+    juce::CriticalSection callbackLock; // Held around each callback, so stop() can't return mid-block
+    juce::AudioIODeviceCallback* currentCallback = nullptr;
+    juce::Random jitterRandom;
+
+    // Stats (device thread)
+    juce::int64 blocksRendered = 0;
+    double wallStartMs = 0.0;
+    double slowestCallbackMs = 0.0;
+    double totalCallbackMs = 0.0;
+    bool quitRequested = false; // --run-seconds reached
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioIODevice)
+};
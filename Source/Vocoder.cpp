@@ -0,0 +1,149 @@
+#include "Vocoder.h"
+#include "TraceRecorder.h"
+#include <cmath>
+
+namespace
+{
+    constexpr double lowestBandHz = 100.0;
+    constexpr double highestBandHz = 8000.0;   // Lowered to 0.45 x the rate at low sample rates
+    constexpr double attackSeconds = 0.005;
+    constexpr double releaseSeconds = 0.05;
+}
+
+//==============================================================================
+void Vocoder::prepare(double sampleRate, int maximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+
+    // Devices sometimes deliver more than they announced; input past the end is treated as silence
+    modulator.assign((size_t)juce::jmax(4096, 4 * maximumBlockSize), 0.0f);
+    numModulatorSamples = 0;
+
+    designBank(0); // The next block designs the bank for the new rate
+}
+
+void Vocoder::setNumBands(int numBands)
+{
+    requestedBands.store(numBands <= 0 ? 0 : juce::jlimit(minBands, maxBands, numBands));
+}
+
+//==============================================================================
+void Vocoder::designBank(int numBands) noexcept
+{
+    appliedBands = numBands;
+    numGroups = (numBands + lanes - 1) / lanes;
+    controlCountdown = controlInterval;
+    for (auto& group : groups)
+        group = {}; // Unused lanes keep zero coefficients, so they stay silent
+    if (numBands == 0)
+        return;
+
+    // Log-spaced centres, each band as wide as the spacing, so neighbours cross at about -3 dB
+    const auto highestHz = juce::jmin(highestBandHz, 0.45 * currentSampleRate);
+    const auto ratio = std::pow(highestHz / lowestBandHz, 1.0 / (numBands - 1));
+    const auto q = std::sqrt(ratio) / (ratio - 1.0);
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        // RBJ band-pass, 0 dB peak gain
+        auto w0 = juce::MathConstants<double>::twoPi * lowestBandHz * std::pow(ratio, band) / currentSampleRate;
+        auto alpha = std::sin(w0) / (2.0 * q);
+        auto a0 = 1.0 + alpha;
+
+        auto& group = groups[(size_t)(band / lanes)];
+        auto lane = (size_t)(band % lanes);
+        group.b0.set(lane, (float)(alpha / a0));
+        group.minusA1.set(lane, (float)(2.0 * std::cos(w0) / a0));
+        group.minusA2.set(lane, (float)(-(1.0 - alpha) / a0));
+    }
+
+    const auto updatesPerSecond = currentSampleRate / controlInterval;
+    attackCoefficient = (float)std::exp(-1.0 / (attackSeconds * updatesPerSecond));
+    releaseCoefficient = (float)std::exp(-1.0 / (releaseSeconds * updatesPerSecond));
+    makeupGain = 2.0f * std::sqrt((float)numBands); // A band's RMS falls with the band count; this keeps the output level steady
+}
+
+void Vocoder::updateEnvelopes() noexcept
+{
+    constexpr auto perSample = 1.0f / (float)controlInterval;
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        auto& group = groups[(size_t)g];
+        for (size_t lane = 0; lane < (size_t)lanes; ++lane)
+        {
+            auto level = std::sqrt(group.energy.get(lane) * perSample);
+            auto& envelope = group.envelope[lane];
+            envelope = level + (envelope - level) * (level > envelope ? attackCoefficient : releaseCoefficient);
+
+            // Reach the new target by the next update
+            group.gainStep.set(lane, (envelope * makeupGain - group.gain.get(lane)) * perSample);
+        }
+        group.energy = Vector::expand(0.0f);
+    }
+}
+
+//==============================================================================
+void Vocoder::captureModulator(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (requestedBands.load() == 0)
+        return;
+
+    numModulatorSamples = juce::jmin(numSamples, (int)modulator.size());
+    if (buffer.getNumChannels() > 0)
+        juce::FloatVectorOperations::copy(modulator.data(), buffer.getReadPointer(0, startSample), numModulatorSamples);
+    else
+        juce::FloatVectorOperations::clear(modulator.data(), numModulatorSamples);
+}
+
+void Vocoder::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    auto bands = requestedBands.load();
+    if (bands != appliedBands)
+        designBank(bands);
+    if (appliedBands == 0)
+        return;
+
+    const TraceRecorder::ScopedEvent trace("Vocoder::process");
+    const juce::ScopedNoDenormals noDenormals;
+    auto* carrier = buffer.getWritePointer(0, startSample);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto modulatorIn = Vector::expand(i < numModulatorSamples ? modulator[(size_t)i] : 0.0f);
+        const auto carrierIn = Vector::expand(carrier[i]);
+        auto output = Vector::expand(0.0f);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            auto& group = groups[(size_t)g];
+
+            // Analysis: band energy of the modulator
+            auto analysed = group.b0 * modulatorIn + group.analysisZ1;
+            group.analysisZ1 = group.minusA1 * analysed + group.analysisZ2;
+            group.analysisZ2 = group.minusA2 * analysed - group.b0 * modulatorIn;
+            group.energy += analysed * analysed;
+
+            // Synthesis: the same band of the carrier, at the modulator's level
+            auto synthesised = group.b0 * carrierIn + group.synthesisZ1;
+            group.synthesisZ1 = group.minusA1 * synthesised + group.synthesisZ2;
+            group.synthesisZ2 = group.minusA2 * synthesised - group.b0 * carrierIn;
+            group.gain += group.gainStep;
+            output += synthesised * group.gain;
+        }
+
+        carrier[i] = output.sum();
+
+        if (--controlCountdown == 0)
+        {
+            updateEnvelopes();
+            controlCountdown = controlInterval;
+        }
+    }
+
+    numModulatorSamples = 0;
+
+    // The master is mono
+    for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+        buffer.copyFrom(channel, startSample, buffer, 0, startSample, numSamples);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h> // For SIMDRegister
+#include <array>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/*
+    Channel vocoder on the master bus. The modulator is the audio input (a
+    microphone) and the carrier is the engine's output.
+
+    Both signals go through the same bank of 16-40 band-pass filters,
+    log-spaced from 100 Hz to 8 kHz. Each analysis band's energy sets the
+    gain of the matching carrier band, and the carrier bands are summed.
+    The bands are processed SIMDRegister::size() at a time (4 with SSE or
+    NEON): each register holds one biquad coefficient or state per lane,
+    so a 32-band bank is 8 vector biquads per signal per sample.
+
+    The envelope followers run at control rate. Every controlInterval
+    samples the band energies become RMS levels, pass through an
+    attack/release follower, and set a new gain target. The gains ramp to
+    their targets sample by sample, so there is no zipper noise. The filter
+    bank has no block latency, and the control clock carries on across
+    callbacks, so small buffers cost the same per sample as large ones.
+
+    Device input arrives in the callback's buffer, which the engine then
+    writes over. captureModulator() copies it first.
+*/
+class Vocoder
+{
+public:
+    static constexpr int minBands = 16;
+    static constexpr int maxBands = 40;
+    static constexpr int controlInterval = 32;     // Samples per envelope update (~0.7 ms at 48 kHz)
+
+    Vocoder() = default;
+
+    // Called from prepareToPlay, while the audio callback isn't running
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    // --- Message thread ---
+    void setNumBands(int numBands); // 0 = off; otherwise clamped to minBands-maxBands
+    int getNumBands() const noexcept { return requestedBands.load(); }
+
+    // --- Audio thread ---
+    // Start of the callback, before anything writes to the buffer: keeps channel 0 (the input) as the modulator
+    void captureModulator(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    // Replaces the carrier in channel 0 with the vocoded signal and copies it to the other channels
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int)Vector::SIMDNumElements;
+    static constexpr int maxGroups = (maxBands + lanes - 1) / lanes;
+
+    // SIMD-width slice of the bank: one band per lane. Band-pass biquads (b1 = 0, b2 = -b0), transposed direct form II.
+    struct BandGroup
+    {
+        Vector b0, minusA1, minusA2;               // Shared by analysis and synthesis
+        Vector analysisZ1, analysisZ2;             // Modulator filter state
+        Vector synthesisZ1, synthesisZ2;           // Carrier filter state
+        Vector energy;                             // Modulator band energy since the last control update
+        Vector gain, gainStep;                     // Carrier band gain, ramping to the latest target
+        std::array<float, lanes> envelope{};       // Follower state, per band (control rate, scalar)
+    };
+
+    void designBank(int numBands) noexcept;        // Audio thread, when the band count changes
+    void updateEnvelopes() noexcept;
+
+    // --- Audio thread state ---
+    std::array<BandGroup, maxGroups> groups{};
+    int numGroups = 0;
+    int appliedBands = 0;
+    int controlCountdown = controlInterval;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f; // Per control update
+    float makeupGain = 1.0f;
+    std::vector<float> modulator;                  // This callback's input
+    int numModulatorSamples = 0;
+
+    double currentSampleRate = 48000.0;
+    std::atomic<int> requestedBands{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Vocoder)
+};
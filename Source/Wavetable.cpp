@@ -0,0 +1,109 @@
+#include "Wavetable.h"
+
+//==============================================================================
+std::unique_ptr<Wavetable> Wavetable::loadFromFile(const juce::File& file, juce::String& errorMessage)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        errorMessage = "Can't read " + file.getFileName();
+        return nullptr;
+    }
+
+    auto length = (int)juce::jmin(reader->lengthInSamples, (juce::int64)frameSize * maxFrames);
+    juce::AudioBuffer<float> source(1, length);
+    reader->read(&source, 0, length, 0, true, false); // First channel only
+    const auto* input = source.getReadPointer(0);
+
+    // --- Cut (or stretch) the file into frames of frameSize samples ---
+    std::vector<float> rawFrames;
+    if (length <= 2 * frameSize)
+    {
+        // Single cycle of arbitrary length: resample it to frameSize, wrapping around the end
+        rawFrames.resize((size_t)frameSize);
+        auto ratio = (double)length / frameSize;
+        for (int i = 0; i < frameSize; ++i)
+        {
+            auto position = i * ratio;
+            auto index0 = (int)position;
+            auto fraction = (float)(position - index0);
+            auto sample0 = input[index0 % length];
+            auto sample1 = input[(index0 + 1) % length];
+            rawFrames[(size_t)i] = sample0 + fraction * (sample1 - sample0);
+        }
+    }
+    else
+    {
+        if (length % frameSize != 0)
+            DBG("Wavetable: " + file.getFileName() + " isn't a whole number of " + juce::String(frameSize)
+                + "-sample frames, ignoring the last " + juce::String(length % frameSize) + " samples");
+
+        rawFrames.assign(input, input + (length / frameSize) * frameSize);
+    }
+
+    auto table = std::unique_ptr<Wavetable>(new Wavetable());
+    table->name = file.getFileNameWithoutExtension();
+    table->numFrames = (int)(rawFrames.size() / frameSize);
+    table->buildMipLevels(rawFrames);
+
+    DBG("Wavetable: Loaded '" + table->name + "' - " + juce::String(table->numFrames) + " frames, "
+        + juce::String(numMipLevels) + " mip levels");
+    return table;
+}
+
+void Wavetable::buildMipLevels(const std::vector<float>& rawFrames)
+{
+    const auto frameStride = (size_t)(frameSize + 1);
+    data.assign((size_t)numMipLevels * (size_t)numFrames * frameStride, 0.0f);
+
+    juce::dsp::FFT fft(fftOrder);
+    std::vector<float> spectrum((size_t)frameSize * 2);
+    std::vector<float> levelBuffer((size_t)frameSize * 2);
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        // One forward transform per frame...
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        std::copy_n(rawFrames.begin() + (std::ptrdiff_t)frame * frameSize, frameSize, spectrum.begin());
+        fft.performRealOnlyForwardTransform(spectrum.data(), true);
+
+        spectrum[0] = spectrum[1] = 0.0f; // Remove DC
+
+        // ...then one inverse per level, with everything above its harmonic limit removed
+        for (int level = 0; level < numMipLevels; ++level)
+        {
+            auto maxHarmonic = (frameSize / 2) >> level;
+            std::copy(spectrum.begin(), spectrum.end(), levelBuffer.begin());
+            std::fill(levelBuffer.begin() + 2 * (maxHarmonic + 1), levelBuffer.end(), 0.0f);
+            fft.performRealOnlyInverseTransform(levelBuffer.data());
+
+            auto* destination = data.data() + ((size_t)level * (size_t)numFrames + (size_t)frame) * frameStride;
+            std::copy_n(levelBuffer.begin(), frameSize, destination);
+            destination[frameSize] = destination[0];
+        }
+    }
+
+    // Normalise the whole table to the full-bandwidth peak, so frames keep their relative levels
+    auto peak = 0.0f;
+    for (int frame = 0; frame < numFrames; ++frame)
+        for (int i = 0; i < frameSize; ++i)
+            peak = juce::jmax(peak, std::abs(getFrame(0, frame)[i]));
+
+    if (peak > 0.0f)
+        juce::FloatVectorOperations::multiply(data.data(), 1.0f / peak, (int)data.size());
+}
+
+//==============================================================================
+int Wavetable::getMipLevelForFrequency(double frequency, double sampleRate) const noexcept
+{
+    // Harmonics that fit below Nyquist at this pitch
+    auto harmonicsAllowed = frequency > 0.0 ? sampleRate * 0.5 / frequency : (double)frameSize;
+
+    int level = 0;
+    while (level < numMipLevels - 1 && (double)((frameSize / 2) >> level) > harmonicsAllowed)
+        ++level;
+    return level;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h> // For dsp::FFT
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    A user wavetable: one or more single-cycle frames, each stored at several
+    band-limited "mip" levels.
+
+    Level 0 holds all 1024 harmonics a 2048-sample frame can carry; every level
+    after that halves the count, down to a pure fundamental. The oscillator picks
+    the richest level whose top harmonic stays below Nyquist for the note being
+    played, so high notes don't alias.
+
+    Loading (file read, resampling, one FFT per frame and a filtered inverse FFT
+    per level) is slow, so it is done on a background thread by WavetableBank.
+    Once built the table is immutable and safe to read from the audio thread.
+*/
+class Wavetable
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int frameSize = 1 << fftOrder;  // Samples per cycle at every mip level
+    static constexpr int numMipLevels = fftOrder;    // 1024, 512 ... 1 harmonics
+    static constexpr int maxFrames = 256;
+
+    // Reads a WAV (or any registered format) file. A file of up to 4096 samples is taken as one
+    // cycle and resampled to frameSize; a longer one as consecutive frames of frameSize samples.
+    // Returns nullptr and fills errorMessage on failure.
+    static std::unique_ptr<Wavetable> loadFromFile(const juce::File& file, juce::String& errorMessage);
+
+    juce::String getName() const { return name; }
+    int getNumFrames() const noexcept { return numFrames; }
+
+    // Audio thread: the richest mip level that doesn't alias at this frequency
+    int getMipLevelForFrequency(double frequency, double sampleRate) const noexcept;
+
+    // frameSize + 1 samples: the last one repeats the first, for interpolation across the wrap
+    const float* getFrame(int mipLevel, int frame) const noexcept
+    {
+        return data.data() + ((size_t)mipLevel * (size_t)numFrames + (size_t)frame) * (size_t)(frameSize + 1);
+    }
+
+private:
+    Wavetable() = default;
+    void buildMipLevels(const std::vector<float>& rawFrames);
+
+    juce::String name;
+    int numFrames = 0;
+    std::vector<float> data; // [level][frame][sample]
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Wavetable)
+};
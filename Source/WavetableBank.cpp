@@ -0,0 +1,67 @@
+#include "WavetableBank.h"
+
+//==============================================================================
+WavetableBank::~WavetableBank()
+{
+    loaderPool.removeAllJobs(true, 10000);
+
+    for (auto& table : tables)
+        delete table.exchange(nullptr);
+}
+
+//==============================================================================
+void WavetableBank::loadAsync(const juce::File& file)
+{
+    if (numTables.load() >= maxTables)
+    {
+        const juce::ScopedLock sl(statusLock);
+        statusText = "Wavetable slots full (" + juce::String(maxTables) + ")";
+        return;
+    }
+
+    if (loadInProgress.exchange(true))
+    {
+        DBG("WavetableBank::loadAsync - Already loading, ignoring " + file.getFullPathName());
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl(statusLock);
+        statusText = "Building " + file.getFileName() + "...";
+    }
+
+    loaderPool.addJob([this, file]
+    {
+        juce::String error;
+        auto table = Wavetable::loadFromFile(file, error);
+
+        {
+            const juce::ScopedLock sl(statusLock);
+            statusText = table != nullptr ? table->getName() + ": " + juce::String(table->getNumFrames()) + " frames"
+                                          : error;
+        }
+
+        if (table != nullptr)
+        {
+            // Publish the finished table, then make it visible to the UI
+            auto index = numTables.load();
+            tables[(size_t)index].store(table.release());
+            numTables.store(index + 1);
+        }
+
+        loadInProgress.store(false);
+    });
+}
+
+juce::String WavetableBank::getStatusText() const
+{
+    const juce::ScopedLock sl(statusLock);
+    return statusText;
+}
+
+juce::String WavetableBank::getTableName(int index) const
+{
+    if (index < 0 || index >= getNumTables())
+        return {};
+    return tables[(size_t)index].load()->getName();
+}
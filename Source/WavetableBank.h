@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "Wavetable.h"
+
+//==============================================================================
+/*
+    The user wavetables available to the oscillator, after the four fixed
+    MainComponent::Waveform shapes.
+
+    Tables are loaded and their mip levels built on a worker thread. A finished
+    table is published to its slot with a single atomic pointer store, so the
+    audio thread either sees the whole table or nothing - it never waits for a
+    load. Slots are only ever appended, never replaced, which means a table the
+    audio thread may be reading is never deleted while the bank is alive.
+*/
+class WavetableBank
+{
+public:
+    static constexpr int maxTables = 16;
+    static constexpr int firstTableId = 5; // Waveform IDs 1-4 are the fixed shapes; user tables follow
+
+    WavetableBank() = default;
+    ~WavetableBank();
+
+    // --- Message thread ---
+    void loadAsync(const juce::File& file);
+    bool isLoading() const noexcept { return loadInProgress.load(); }
+    juce::String getStatusText() const;
+    int getNumTables() const noexcept { return numTables.load(); }
+    juce::String getTableName(int index) const;
+
+    // --- Audio thread ---
+    // nullptr if the waveform ID isn't a loaded user table
+    const Wavetable* getTableForWaveformId(int waveformId) const noexcept
+    {
+        auto index = waveformId - firstTableId;
+        return (index >= 0 && index < maxTables) ? tables[(size_t)index].load() : nullptr;
+    }
+
+private:
+    std::array<std::atomic<Wavetable*>, maxTables> tables{};
+    std::atomic<int> numTables{ 0 };
+
+    juce::ThreadPool loaderPool{ 1 };
+    std::atomic<bool> loadInProgress{ false };
+
+    juce::CriticalSection statusLock; // Loader and message threads only
+    juce::String statusText;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WavetableBank)
+};